@@ -0,0 +1,84 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/** \brief Evaluating an SXFunction at many points
+ * NOTE: Example is mainly intended for developers of CasADi.
+ * This example compares the evaluation of an SXFunction at a large number of points,
+ * once by calling setInput/evaluate/getOutput for each point and once by passing all the
+ * points at once to evaluateBatch, which runs through the algorithm only once.
+ */
+
+#include "symbolic/casadi.hpp"
+#include <ctime>
+
+using namespace CasADi;
+using namespace std;
+
+int main(){
+  // Number of points
+  int npoints = 10000;
+  
+  // Construct a function with some typical nonlinearities
+  SXMatrix x = ssym("x",4);
+  SXMatrix f = SXMatrix::zeros(3,1);
+  f.at(0) = sin(x.at(0))*x.at(1) + exp(-x.at(2)*x.at(2));
+  f.at(1) = sqrt(x.at(0)*x.at(0) + x.at(3)*x.at(3))/(1+x.at(1)*x.at(1));
+  f.at(2) = f.at(0)*f.at(1) - log(1+x.at(2)*x.at(2))*cos(x.at(3));
+  SXFunction fcn(x,f);
+  fcn.init();
+  
+  // Points in structure-of-arrays format
+  vector<vector<double> > arg(1,vector<double>(x.size()*npoints)), res;
+  for(int k=0; k<x.size(); ++k){
+    for(int p=0; p<npoints; ++p){
+      arg[0][k*npoints+p] = 0.1*(k+1) + double(p)/npoints;
+    }
+  }
+  
+  // Evaluate the points one at a time
+  vector<double> res_scalar(f.size()*npoints), xp(x.size()), fp(f.size());
+  clock_t time1 = clock();
+  for(int p=0; p<npoints; ++p){
+    for(int k=0; k<x.size(); ++k) xp[k] = arg[0][k*npoints+p];
+    fcn.setInput(xp);
+    fcn.evaluate();
+    fcn.getOutput(fp);
+    for(int k=0; k<f.size(); ++k) res_scalar[k*npoints+p] = fp[k];
+  }
+  clock_t time2 = clock();
+  cout << "scalar loop: " << (double(time2 - time1)/CLOCKS_PER_SEC*1000) << " ms" << endl;
+  
+  // Evaluate all points at once
+  time1 = clock();
+  fcn.evaluateBatch(arg,res,npoints);
+  time2 = clock();
+  cout << "evaluateBatch: " << (double(time2 - time1)/CLOCKS_PER_SEC*1000) << " ms" << endl;
+  
+  // Make sure that the results match
+  double max_diff = 0;
+  for(int i=0; i<res_scalar.size(); ++i){
+    max_diff = std::max(max_diff,fabs(res_scalar[i]-res[0][i]));
+  }
+  cout << "maximum difference: " << max_diff << endl;
+  
+  return 0;
+}
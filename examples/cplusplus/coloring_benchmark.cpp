@@ -0,0 +1,137 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+/** \brief Graph coloring of large sparsity patterns
+ * NOTE: Example is mainly intended for developers of CasADi.
+ * This example colors synthetic banded, block-arrow and random sparsity patterns with the 
+ * unidirectional (column) coloring used to compress Jacobians and, after symmetrization,
+ * with the star coloring used to compress Hessians,
+ * for each vertex ordering with and without recoloring, and reports the time and the number of colors.
+ * Compile CasADi with WITH_OPENMP=ON to include the speculative parallel coloring.
+ */
+
+#include <symbolic/casadi.hpp>
+#include <symbolic/matrix/sparsity_tools.hpp>
+#include <ctime>
+#include <iomanip>
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif // WITH_OPENMP
+
+using namespace CasADi;
+using namespace std;
+
+// Banded pattern with 2*bw+1 nonzeros per row
+CRSSparsity banded(int n, int bw){
+  vector<int> row, col;
+  for(int i=0; i<n; ++i){
+    for(int j=max(0,i-bw); j<=min(n-1,i+bw); ++j){
+      row.push_back(i);
+      col.push_back(j);
+    }
+  }
+  return sp_triplet(n,n,row,col);
+}
+
+// Dense diagonal blocks plus a number of dense rows and columns
+CRSSparsity blockArrow(int n, int bs, int w){
+  vector<int> row, col;
+  for(int i=0; i<n; ++i){
+    int b = i/bs;
+    for(int j=b*bs; j<min(n,(b+1)*bs); ++j){
+      row.push_back(i);
+      col.push_back(j);
+    }
+    for(int k=0; k<w; ++k){
+      if(k/bs==b) continue;
+      row.push_back(i);
+      col.push_back(k);
+      row.push_back(k);
+      col.push_back(i);
+    }
+  }
+  return sp_triplet(n,n,row,col);
+}
+
+// Random pattern with a diagonal and k off-diagonal nonzeros per row
+CRSSparsity randomPattern(int n, int k){
+  vector<int> row, col;
+  unsigned int s = 1;
+  for(int i=0; i<n; ++i){
+    row.push_back(i);
+    col.push_back(i);
+    for(int j=0; j<k; ++j){
+      s = s*1103515245 + 12345;
+      row.push_back(i);
+      col.push_back((s>>8)%n);
+    }
+  }
+  return sp_triplet(n,n,row,col);
+}
+
+int main(){
+  const char* ordering_name[] = {"natural","largest_first","smallest_last","incidence_degree"};
+  
+  const int npatterns = 3;
+  const char* pattern_name[npatterns] = {"banded","block-arrow","random"};
+  CRSSparsity pattern[npatterns] = {banded(1000000,2), blockArrow(20000,8,2), randomPattern(200000,4)};
+
+  for(int p=0; p<npatterns; ++p){
+    const CRSSparsity& A = pattern[p];
+    CRSSparsity AT = A.transpose();
+    cout << pattern_name[p] << ": " << A.size1() << "-by-" << A.size2() << ", " << A.size() << " nonzeros" << endl;
+    
+    // Unidirectional coloring of the columns (forward mode)
+    for(int ordering=0; ordering<4; ++ordering){
+      for(int recolor=0; recolor<=2; recolor+=2){
+        clock_t time0 = clock();
+        CRSSparsity D = AT.unidirectionalColoring(A,ordering,recolor);
+        clock_t time1 = clock();
+        cout << "  unidirectional, " << setw(16) << left << ordering_name[ordering] << ", " << recolor << " recoloring passes: " 
+             << setw(6) << right << D.size1() << " colors, " << double(time1-time0)/CLOCKS_PER_SEC << " s" << endl;
+      }
+    }
+    
+#ifdef WITH_OPENMP
+    // Speculative parallel coloring
+    double wtime0 = omp_get_wtime();
+    CRSSparsity D = AT.unidirectionalColoring(A,0,0,true);
+    double wtime1 = omp_get_wtime();
+    cout << "  unidirectional, parallel (" << omp_get_max_threads() << " threads): " << D.size1() << " colors, " << (wtime1-wtime0) << " s (wall)" << endl;
+#endif // WITH_OPENMP
+    
+    // Star coloring of the symmetric part of the pattern (Hessians)
+    CRSSparsity H = A + AT;
+    for(int ordering=0; ordering<4; ++ordering){
+      for(int recolor=0; recolor<=2; recolor+=2){
+        clock_t time0 = clock();
+        CRSSparsity D = H.starColoring(ordering,recolor);
+        clock_t time1 = clock();
+        cout << "  star,           " << setw(16) << left << ordering_name[ordering] << ", " << recolor << " recoloring passes: " 
+             << setw(6) << right << D.size1() << " colors, " << double(time1-time0)/CLOCKS_PER_SEC << " s" << endl;
+      }
+    }
+  }
+  
+  return 0;
+}
@@ -0,0 +1,164 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+/** \brief Micro-benchmarks of the sparse matrix product kernels
+ * NOTE: Example is mainly intended for developers of CasADi.
+ * This example times DMatrix::mul_no_alloc, mul_no_alloc1 and mul_no_alloc2 for dense, banded and random
+ * sparsity patterns, with and without a precomputed MulPlan, and compares with a reference implementation
+ * that merges the sparsity patterns at every call.
+ */
+
+#include <symbolic/casadi.hpp>
+#include <ctime>
+#include <cstdlib>
+
+using namespace CasADi;
+using namespace std;
+
+// Reference: merge the row of x with the row of y_trans for each nonzero of z
+void mul_reference(const DMatrix& x, const DMatrix& y_trans, DMatrix& z){
+  const vector<int> &z_col = z.col();
+  const vector<int> &z_rowind = z.rowind();
+  const vector<int> &x_col = x.col();
+  const vector<int> &y_row = y_trans.col();
+  const vector<int> &x_rowind = x.rowind();
+  const vector<int> &y_colind = y_trans.rowind();
+  const vector<double> &x_data = x.data();
+  const vector<double> &y_trans_data = y_trans.data();
+  vector<double> &z_data = z.data();
+  for(int i=0; i<z.size1(); ++i){
+    for(int el=z_rowind[i]; el<z_rowind[i+1]; ++el){
+      int j = z_col[el];
+      int el1 = x_rowind[i];
+      int el2 = y_colind[j];
+      while(el1 < x_rowind[i+1] && el2 < y_colind[j+1]){
+        int j1 = x_col[el1];
+        int i2 = y_row[el2];
+        if(j1==i2){
+          z_data[el] += x_data[el1++] * y_trans_data[el2++];
+        } else if(j1<i2) {
+          el1++;
+        } else {
+          el2++;
+        }
+      }
+    }
+  }
+}
+
+// Banded n-by-n sparsity pattern with p bands above and below the diagonal
+CRSSparsity sp_bands(int n, int p){
+  vector<int> col, rowind(1,0);
+  for(int i=0; i<n; ++i){
+    for(int j=std::max(0,i-p); j<=std::min(n-1,i+p); ++j) col.push_back(j);
+    rowind.push_back(col.size());
+  }
+  return CRSSparsity(n,n,col,rowind);
+}
+
+// Random n-by-n sparsity pattern with a given density and a nonzero diagonal
+CRSSparsity sp_random(int n, double density){
+  vector<int> col, rowind(1,0);
+  for(int i=0; i<n; ++i){
+    for(int j=0; j<n; ++j){
+      if(i==j || rand() < density*RAND_MAX) col.push_back(j);
+    }
+    rowind.push_back(col.size());
+  }
+  return CRSSparsity(n,n,col,rowind);
+}
+
+// Largest absolute value of the nonzeros
+double max_abs(const DMatrix& x){
+  double r = 0;
+  for(int i=0; i<x.size(); ++i) r = std::max(r,fabs(x.at(i)));
+  return r;
+}
+
+// Time since t1, in microseconds per call
+double elapsed(clock_t t1, int nrep){
+  return double(clock()-t1)/CLOCKS_PER_SEC*1e6/nrep;
+}
+
+void benchmark(const string& name, const CRSSparsity& sp_x, const CRSSparsity& sp_y, int nrep){
+  DMatrix x(sp_x), y(sp_y);
+  for(int i=0; i<x.size(); ++i) x.at(i) = sin(1.0+i);
+  for(int i=0; i<y.size(); ++i) y.at(i) = cos(2.0+i);
+  DMatrix y_trans = trans(y);
+  DMatrix z(sp_x.patternProduct(y_trans.sparsity()),0);
+  DMatrix z_ref = z, z_plan = z;
+  
+  // Build the plan once
+  clock_t t = clock();
+  MulPlan plan(x.sparsity(),y_trans.sparsity(),z.sparsity());
+  double t_build = elapsed(t,1);
+  
+  // z += x*y
+  t = clock();
+  for(int r=0; r<nrep; ++r) mul_reference(x,y_trans,z_ref);
+  double t_ref = elapsed(t,nrep);
+  t = clock();
+  for(int r=0; r<nrep; ++r) DMatrix::mul_no_alloc(x,y_trans,z);
+  double t_new = elapsed(t,nrep);
+  t = clock();
+  for(int r=0; r<nrep; ++r) DMatrix::mul_no_alloc(x,y_trans,z_plan,plan);
+  double t_plan = elapsed(t,nrep);
+  double err = std::max(max_abs(z-z_ref),max_abs(z_plan-z_ref))/std::max(1.,max_abs(z_ref));
+  
+  // x += z*trans(y) and y += trans(x)*z, the reference is the plan-free version
+  DMatrix x1 = x, x1_plan = x, y1 = y_trans, y1_plan = y_trans;
+  t = clock();
+  for(int r=0; r<nrep; ++r) DMatrix::mul_no_alloc1(x1,y_trans,z_ref);
+  double t_new1 = elapsed(t,nrep);
+  t = clock();
+  for(int r=0; r<nrep; ++r) DMatrix::mul_no_alloc1(x1_plan,y_trans,z_ref,plan);
+  double t_plan1 = elapsed(t,nrep);
+  t = clock();
+  for(int r=0; r<nrep; ++r) DMatrix::mul_no_alloc2(x,y1,z_ref);
+  double t_new2 = elapsed(t,nrep);
+  t = clock();
+  for(int r=0; r<nrep; ++r) DMatrix::mul_no_alloc2(x,y1_plan,z_ref,plan);
+  double t_plan2 = elapsed(t,nrep);
+  err = std::max(err,max_abs(x1-x1_plan)/std::max(1.,max_abs(x1)));
+  err = std::max(err,max_abs(y1-y1_plan)/std::max(1.,max_abs(y1)));
+  
+  cout << name << ": nnz(x) = " << x.size() << ", nnz(y) = " << y.size() << ", nnz(z) = " << z.size() 
+       << (plan.dense ? ", dense" : "") << ", plan " << plan.x_el.size() << " pairs built in " << t_build << " us" << endl;
+  cout << "  mul_no_alloc:  reference " << t_ref << " us, no plan " << t_new << " us, plan " << t_plan << " us" << endl;
+  cout << "  mul_no_alloc1: no plan " << t_new1 << " us, plan " << t_plan1 << " us" << endl;
+  cout << "  mul_no_alloc2: no plan " << t_new2 << " us, plan " << t_plan2 << " us" << endl;
+  cout << "  maximum relative difference: " << err << endl;
+}
+
+int main(){
+  srand(1);
+  benchmark("dense 20x20",sp_dense(20,20),sp_dense(20,20),2000);
+  benchmark("dense 200x200",sp_dense(200,200),sp_dense(200,200),5);
+  benchmark("dense 200x50 times 50x1",sp_dense(200,50),sp_dense(50,1),20000);
+  benchmark("banded 2000x2000, bandwidth 2",sp_bands(2000,2),sp_bands(2000,2),500);
+  benchmark("banded 500x500, bandwidth 20",sp_bands(500,20),sp_bands(500,20),20);
+  benchmark("random 500x500, density 0.01",sp_random(500,0.01),sp_random(500,0.01),100);
+  benchmark("random 200x200, density 0.1",sp_random(200,0.1),sp_random(200,0.1),20);
+  return 0;
+}
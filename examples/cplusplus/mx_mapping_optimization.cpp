@@ -0,0 +1,203 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/** \brief Effect of the "optimize_mappings" option of MXFunction
+ * NOTE: Example is mainly intended for developers of CasADi.
+ * This example builds the constraint function of a multiple shooting and of a collocation NLP, as well as
+ * the Jacobian of the constraints and the gradient of the objective, and reports the number of mapping
+ * nodes and the number of bytes copied by them in one evaluation, with and without the optimization.
+ * Only the constraint Jacobians get smaller, since the optimization removes the identity mappings created when
+ * a Jacobian is built. The constraint functions and the objective gradients are not affected: Mapping::assign
+ * already composes nested mappings when their expressions are built.
+ */
+
+#include <symbolic/casadi.hpp>
+#include <ctime>
+
+using namespace CasADi;
+using namespace std;
+
+// Van der Pol oscillator, with the objective as a third state for the collocation NLP
+SXFunction vdp(bool with_quadrature){
+  SXMatrix x = ssym("x",with_quadrature ? 3 : 2);
+  SXMatrix u = ssym("u");
+  SXMatrix ode = vertcat(SXMatrix((1 - x.at(1)*x.at(1))*x.at(0) - x.at(1) + u.at(0)), SXMatrix(x.at(0)));
+  if(with_quadrature) ode.append(SXMatrix(x.at(0)*x.at(0) + x.at(1)*x.at(1) + u.at(0)*u.at(0)));
+  vector<SXMatrix> f_in;
+  f_in.push_back(x);
+  f_in.push_back(u);
+  SXFunction f(f_in,ode);
+  f.init();
+  return f;
+}
+
+// Multiple shooting with one RK4 step per shooting interval
+void multipleShooting(int ns, MX& V, MX& J, MX& g){
+  SXFunction f = vdp(false);
+  int nx = 2;
+  double h = 20.0/ns;
+  
+  // Integrator
+  MX X0 = msym("X0",nx), U0 = msym("U0");
+  vector<MX> f_in(2);
+  f_in[1] = U0;
+  f_in[0] = X0;             MX k1 = f.call(f_in)[0];
+  f_in[0] = X0 + h/2*k1;    MX k2 = f.call(f_in)[0];
+  f_in[0] = X0 + h/2*k2;    MX k3 = f.call(f_in)[0];
+  f_in[0] = X0 + h*k3;      MX k4 = f.call(f_in)[0];
+  vector<MX> I_in;
+  I_in.push_back(X0);
+  I_in.push_back(U0);
+  MXFunction I(I_in,X0 + h/6*(k1 + 2*k2 + 2*k3 + k4));
+  I.init();
+  
+  // NLP variables
+  V = msym("V",nx*(ns+1) + ns);
+  vector<MX> X, U;
+  int offset = 0;
+  for(int k=0; k<ns; ++k){
+    X.push_back(V[Slice(offset,offset+nx)]);
+    offset += nx;
+    U.push_back(V[Slice(offset,offset+1)]);
+    offset += 1;
+  }
+  X.push_back(V[Slice(offset,offset+nx)]);
+  
+  // Objective and continuity constraints
+  J = 0;
+  vector<MX> gv;
+  for(int k=0; k<ns; ++k){
+    I_in[0] = X[k];
+    I_in[1] = U[k];
+    gv.push_back(I.call(I_in)[0] - X[k+1]);
+    J += inner_prod(X[k],X[k]) + inner_prod(U[k],U[k]);
+  }
+  g = vertcat(gv);
+}
+
+// Direct collocation with Radau points of degree 3
+void collocation(int nk, MX& V, MX& J, MX& g){
+  SXFunction f = vdp(true);
+  int nx = 3, d = 3;
+  double tau_root[] = {0, 0.155051, 0.644949, 1.0};
+  double h = 10.0/nk;
+  
+  // Coefficients of the collocation and continuity equations
+  SXMatrix tau = ssym("tau");
+  vector<vector<double> > C(d+1,vector<double>(d+1));
+  vector<double> D(d+1);
+  for(int j=0; j<=d; ++j){
+    SXMatrix L = 1;
+    for(int r=0; r<=d; ++r){
+      if(r!=j) L *= (tau-tau_root[r])/(tau_root[j]-tau_root[r]);
+    }
+    SXFunction lfcn(tau,L);
+    lfcn.setOption("number_of_fwd_dir",1);
+    lfcn.init();
+    lfcn.setInput(1.0);
+    lfcn.evaluate();
+    D[j] = lfcn.output().at(0);
+    for(int r=0; r<=d; ++r){
+      lfcn.setInput(tau_root[r]);
+      lfcn.setFwdSeed(1.0);
+      lfcn.evaluate(1,0);
+      C[j][r] = lfcn.fwdSens().at(0);
+    }
+  }
+  
+  // NLP variables
+  V = msym("V",nk*(d+1)*nx + nk + nx);
+  vector<vector<MX> > X(nk+1,vector<MX>(d+1));
+  vector<MX> U(nk);
+  int offset = 0;
+  for(int k=0; k<nk; ++k){
+    for(int j=0; j<=d; ++j){
+      X[k][j] = V[Slice(offset,offset+nx)];
+      offset += nx;
+    }
+    U[k] = V[Slice(offset,offset+1)];
+    offset += 1;
+  }
+  X[nk][0] = V[Slice(offset,offset+nx)];
+  
+  // Collocation and continuity equations
+  vector<MX> gv, f_in(2);
+  for(int k=0; k<nk; ++k){
+    for(int j=1; j<=d; ++j){
+      MX xp_jk = 0;
+      for(int r=0; r<=d; ++r) xp_jk += C[r][j]*X[k][r];
+      f_in[0] = X[k][j];
+      f_in[1] = U[k];
+      gv.push_back(h*f.call(f_in)[0] - xp_jk);
+    }
+    MX xf_k = 0;
+    for(int j=0; j<=d; ++j) xf_k += D[j]*X[k][j];
+    gv.push_back(X[k+1][0] - xf_k);
+  }
+  g = vertcat(gv);
+  J = X[nk][0][2];
+}
+
+double elapsed(clock_t t1, int nrep){
+  return double(clock()-t1)/CLOCKS_PER_SEC*1e6/nrep;
+}
+
+void report(const string& name, const MX& V, const MX& e, int nrep){
+  cout << name << endl;
+  for(int opt=0; opt<2; ++opt){
+    MXFunction F(V,e);
+    F.setOption("optimize_mappings",bool(opt));
+    F.init();
+    F.input().set(0.1);
+    clock_t t = clock();
+    for(int r=0; r<nrep; ++r) F.evaluate();
+    double t_eval = elapsed(t,nrep);
+    cout << "  optimize_mappings=" << opt << ": " << F.getAlgorithmSize() << " operations, " << t_eval << " us per evaluation";
+    if(opt){
+      cout << ", mapping nodes " << F.getStat("mapping_nodes_unoptimized") << " -> " << F.getStat("mapping_nodes");
+      cout << ", bytes copied " << F.getStat("mapping_bytes_copied_unoptimized") << " -> " << F.getStat("mapping_bytes_copied");
+    }
+    cout << endl;
+  }
+}
+
+int main(){
+  MX V, J, g;
+  for(int nlp=0; nlp<2; ++nlp){
+    string name;
+    if(nlp==0){
+      multipleShooting(50,V,J,g);
+      name = "multiple shooting";
+    } else {
+      collocation(20,V,J,g);
+      name = "collocation";
+    }
+    MXFunction gfcn(V,g);
+    gfcn.init();
+    MXFunction jfcn(V,J);
+    jfcn.init();
+    report(name + ", constraints",V,g,1000);
+    report(name + ", constraint Jacobian",V,gfcn.jac(),100);
+    report(name + ", objective gradient",V,jfcn.grad(),1000);
+  }
+  return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+/** \brief Evaluating an SXFunction with the superinstruction bytecode
+ * NOTE: Example is mainly intended for developers of CasADi.
+ * This example compares the number of executed instructions and the evaluation time
+ * of the rocket integrator and the CSTR right hand side with and without the
+ * "superinstructions" option, which fuses multiply-adds, square and negation chains
+ * and inlines constants.
+ */
+
+#include <symbolic/casadi.hpp>
+#include <optimal_control/symbolic_ocp.hpp>
+#include <optimal_control/variable_tools.hpp>
+#include <ctime>
+
+using namespace CasADi;
+using namespace std;
+
+// Rocket, integrated over one interval with nj steps of Euler forward
+SXFunction rocket(int nj){
+  SX u("u"), s0("s0"), v0("v0"), m0("m0");
+  SX dt = 10.0/nj; // time step
+  SX alpha = 0.05; // friction
+  SX beta = 0.1; // fuel consumption rate
+  SX s = s0, v = v0, m = m0;
+  SX dm = -dt*beta*u*u;
+  for(int j=0; j<nj; ++j){
+    s += dt*v;
+    v += dt / m * (u - alpha * v*v);
+    m += dm;
+  }
+  SXMatrix x, x0;
+  x.append(s);
+  x.append(v);
+  x.append(m);
+  x0.append(s0);
+  x0.append(v0);
+  x0.append(m0);
+  vector<SXMatrix> input(2);
+  input[0] = u;
+  input[1] = x0;
+  return SXFunction(input,x);
+}
+
+// Right hand side of the CSTR model
+SXFunction cstr(){
+  SymbolicOCP ocp;
+  Dictionary parse_options;
+  parse_options["scale_variables"] = true;
+  parse_options["eliminate_dependent"] = true;
+  parse_options["scale_equations"] = false;
+  parse_options["make_explicit"] = true;
+  ocp.parseFMI("../examples/xml_files/cstr.xml",parse_options);
+  vector<SXMatrix> input(3);
+  input[0] = var(ocp.x);
+  input[1] = var(ocp.u);
+  input[2] = ocp.t;
+  return SXFunction(input,ocp.ode);
+}
+
+// Evaluate the function repeatedly with and without superinstructions
+void benchmark(const string& name, SXFunction f, int nrep){
+  vector<double> res[2];
+  for(int k=0; k<2; ++k){
+    f.setOption("superinstructions",k==1);
+    f.init();
+    for(int i=0; i<f.getNumInputs(); ++i){
+      for(int el=0; el<f.input(i).size(); ++el){
+        f.input(i).at(el) = 0.5 + 0.1*(i+el);
+      }
+    }
+    clock_t time1 = clock();
+    for(int r=0; r<nrep; ++r) f.evaluate();
+    clock_t time2 = clock();
+    res[k] = f.output().data();
+    
+    int ninst = k==1 ? int(f.getStat("num_superinstructions")) : f.getAlgorithmSize();
+    cout << name << (k==1 ? ", superinstructions: " : ", elementary operations: ") << ninst << " instructions, " 
+         << (double(time2 - time1)/CLOCKS_PER_SEC*1e6/nrep) << " us per evaluation" << endl;
+  }
+  
+  // Make sure that the results match
+  double max_diff = 0;
+  for(int i=0; i<res[0].size(); ++i){
+    max_diff = std::max(max_diff,fabs(res[0][i]-res[1][i])/std::max(1.,fabs(res[0][i])));
+  }
+  cout << name << ", maximum relative difference: " << max_diff << endl;
+}
+
+int main(){
+  benchmark("rocket",rocket(1000),2000);
+  benchmark("cstr",cstr(),200000);
+  return 0;
+}
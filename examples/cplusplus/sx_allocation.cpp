@@ -0,0 +1,71 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+/** \brief Building and destroying a large SX graph
+ * NOTE: Example is mainly intended for developers of CasADi.
+ * This example builds an expression graph with 10 million nodes as a single deep chain
+ * of unary and binary operations and then destroys it, timing both steps.
+ * Compile CasADi with and without the WITH_SX_POOL option to compare the pooled
+ * node allocator with plain new and delete, and with and without WITH_THREADSAFE_SYMBOLICS
+ * to measure the single-threaded cost of the atomic reference counting.
+ */
+
+#include <symbolic/casadi.hpp>
+#include <ctime>
+
+using namespace CasADi;
+using namespace std;
+
+int main(){
+  // Number of nodes to create
+  const int nnodes = 10000000;
+  
+  // Allocate the graph and the nodes, repeat to measure the allocation from a warm pool
+  for(int rep=0; rep<2; ++rep){
+    clock_t time0 = clock();
+    SX x("x"), y("y");
+    SX f = x;
+    for(int i=0; i<nnodes/4; ++i){
+      // Four new nodes per iteration
+      f = sin(f)*y + f*x;
+    }
+    clock_t time1 = clock();
+    
+    // Destroy the graph, this must not recurse along the chain
+    f = 0;
+    clock_t time2 = clock();
+    
+#ifdef WITH_SX_POOL
+    cout << "pooled allocation";
+#else // WITH_SX_POOL
+    cout << "plain allocation";
+#endif // WITH_SX_POOL
+#ifdef WITH_THREADSAFE_SYMBOLICS
+    cout << ", thread-safe reference counting";
+#endif // WITH_THREADSAFE_SYMBOLICS
+    cout << (rep==0 ? ", first pass: " : ", second pass: ")
+         << "build " << double(time1 - time0)/CLOCKS_PER_SEC << " s, "
+         << "destroy " << double(time2 - time1)/CLOCKS_PER_SEC << " s" << endl;
+  }
+  return 0;
+}
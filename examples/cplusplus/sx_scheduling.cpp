@@ -0,0 +1,163 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+
+/** \brief Cache behaviour of the work vector of an SXFunction
+ * NOTE: Example is mainly intended for developers of CasADi.
+ * This example compares the default layout of the algorithm with the "work_allocation" and
+ * "scheduling" options for functions whose work vector does not fit in the cache. The number of
+ * cache misses, instructions and cycles are read from the hardware counters (Linux perf events),
+ * if these are not available, only the evaluation time is reported.
+ */
+
+#include <symbolic/casadi.hpp>
+#include <ctime>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif // __linux__
+
+using namespace CasADi;
+using namespace std;
+
+// Hardware counters of the calling thread
+class Counters{
+  public:
+    Counters(){
+      for(int i=0; i<3; ++i) fd_[i] = -1;
+#ifdef __linux__
+      const unsigned long long cfg[3] = {PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CPU_CYCLES};
+      for(int i=0; i<3; ++i){
+        perf_event_attr attr;
+        memset(&attr,0,sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = cfg[i];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_[i] = syscall(__NR_perf_event_open,&attr,0,-1,-1,0);
+      }
+#endif // __linux__
+    }
+    ~Counters(){
+#ifdef __linux__
+      for(int i=0; i<3; ++i) if(fd_[i]>=0) close(fd_[i]);
+#endif // __linux__
+    }
+    bool available() const{ return fd_[0]>=0 && fd_[1]>=0 && fd_[2]>=0;}
+    void start(){
+#ifdef __linux__
+      for(int i=0; i<3; ++i){
+        if(fd_[i]<0) continue;
+        ioctl(fd_[i],PERF_EVENT_IOC_RESET,0);
+        ioctl(fd_[i],PERF_EVENT_IOC_ENABLE,0);
+      }
+#endif // __linux__
+    }
+    void stop(){
+      for(int i=0; i<3; ++i){
+        val_[i] = 0;
+#ifdef __linux__
+        if(fd_[i]<0) continue;
+        ioctl(fd_[i],PERF_EVENT_IOC_DISABLE,0);
+        if(read(fd_[i],&val_[i],sizeof(val_[i]))!=sizeof(val_[i])) val_[i] = 0;
+#endif // __linux__
+      }
+    }
+    double cacheMisses() const{ return double(val_[0]);}
+    double instructions() const{ return double(val_[1]);}
+    double cycles() const{ return double(val_[2]);}
+  private:
+    int fd_[3];
+    unsigned long long val_[3];
+};
+
+// Gradient of a sum of products of the entries of a chain of dense matrices, a wide graph with many intermediate values
+SXFunction matrixChain(int n, int nmat){
+  vector<SXMatrix> input;
+  SXMatrix p = SXMatrix::eye(n);
+  for(int k=0; k<nmat; ++k){
+    input.push_back(ssym("A",n,n));
+    p = mul(p,sin(input.back()));
+  }
+  SXMatrix f = sumAll(p*p);
+  SXFunction F(input,f);
+  F.init();
+  return SXFunction(input,F.grad(0));
+}
+
+// Evaluate the function with different layouts of the algorithm
+void benchmark(const string& name, SXFunction f, int nrep){
+  const char* scheduling[3] = {"none", "none", "locality"};
+  const char* work_allocation[3] = {"stack", "linear_scan", "linear_scan"};
+  vector<double> res[3];
+  Counters counters;
+  if(!counters.available()){
+    cout << "Hardware counters not available, reporting the evaluation time only" << endl;
+  }
+  for(int k=0; k<3; ++k){
+    f.setOption("scheduling",scheduling[k]);
+    f.setOption("work_allocation",work_allocation[k]);
+    f.init();
+    for(int i=0; i<f.getNumInputs(); ++i){
+      for(int el=0; el<f.input(i).size(); ++el){
+        f.input(i).at(el) = 0.5 + 0.01*((i+el)%17);
+      }
+    }
+    f.evaluate(); // warm up
+    clock_t time1 = clock();
+    counters.start();
+    for(int r=0; r<nrep; ++r) f.evaluate();
+    counters.stop();
+    clock_t time2 = clock();
+    res[k] = f.output().data();
+    
+    cout << name << ", scheduling \"" << scheduling[k] << "\", work allocation \"" << work_allocation[k] << "\": "
+         << f.getAlgorithmSize() << " operations, work vector " << f.getWorkSize() << " elements, "
+         << (double(time2 - time1)/CLOCKS_PER_SEC*1e6/nrep) << " us per evaluation";
+    if(counters.available()){
+      cout << ", " << counters.cacheMisses()/nrep << " cache misses, "
+           << counters.instructions()/nrep << " instructions, " << counters.cycles()/nrep << " cycles per evaluation";
+    }
+    cout << endl;
+  }
+  
+  // Make sure that the results match
+  double max_diff = 0;
+  for(int k=1; k<3; ++k){
+    for(int i=0; i<res[0].size(); ++i){
+      max_diff = std::max(max_diff,fabs(res[0][i]-res[k][i])/std::max(1.,fabs(res[0][i])));
+    }
+  }
+  cout << name << ", maximum relative difference: " << max_diff << endl;
+}
+
+int main(){
+  benchmark("matrix chain, n=10",matrixChain(10,4),200);
+  benchmark("matrix chain, n=30",matrixChain(30,4),10);
+  return 0;
+}
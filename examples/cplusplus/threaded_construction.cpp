@@ -0,0 +1,113 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+/** \brief Building SX and MX expressions from several threads
+ * NOTE: Example is mainly intended for developers of CasADi.
+ * Requires CasADi to be compiled with WITH_THREADSAFE_SYMBOLICS=ON.
+ * This example is a stress test: a number of threads repeatedly build scenario models
+ * which share constants, symbolic inputs and MX subexpressions, turn them into functions, evaluate them and
+ * destroy them again, first without and then with hash-consing of the SX expressions.
+ * The results are compared with those obtained in a single thread.
+ */
+
+#include <symbolic/casadi.hpp>
+#include <thread>
+#include <vector>
+#include <cmath>
+#include <ctime>
+
+using namespace CasADi;
+using namespace std;
+
+// Symbolic inputs shared between all scenarios
+SXMatrix x_shared = ssym("x",4);
+
+// MX input and subexpression shared between all scenarios, the functions built from them are initialized concurrently
+MX x_mx_shared = msym("x",4);
+MX g_mx_shared = x_mx_shared*x_mx_shared;
+
+// Build and evaluate a scenario model, returns the sum of the outputs
+double scenario(int k){
+  // SX model with constants shared between the scenarios
+  SXMatrix f = x_shared;
+  for(int i=0; i<200; ++i){
+    f = sin(f)*0.5 + f*(0.25 + 0.01*(k%7)) + 2;
+  }
+  SXFunction F(x_shared,f);
+  F.init();
+  
+  // MX model calling the SX model
+  vector<MX> Fx = F.call(vector<MX>(1,x_mx_shared));
+  MX g = Fx[0] + g_mx_shared;
+  MXFunction G(x_mx_shared,g);
+  G.init();
+  
+  for(int i=0; i<4; ++i) G.input().at(i) = 0.1*(i+1);
+  G.evaluate();
+  double ret = 0;
+  for(int i=0; i<4; ++i) ret += G.output().at(i);
+  return ret;
+}
+
+int main(){
+#ifndef WITH_THREADSAFE_SYMBOLICS
+  cout << "CasADi has not been compiled with WITH_THREADSAFE_SYMBOLICS=ON, running in a single thread only" << endl;
+  const int nthreads = 1;
+#else // WITH_THREADSAFE_SYMBOLICS
+  const int nthreads = 16;
+#endif // WITH_THREADSAFE_SYMBOLICS
+  const int nscenarios = 50;
+
+  // Reference results, calculated in a single thread
+  vector<double> ref(nscenarios);
+  clock_t time0 = clock();
+  for(int k=0; k<nscenarios; ++k) ref[k] = scenario(k);
+  clock_t time1 = clock();
+  cout << nscenarios << " scenarios in a single thread: " << double(time1 - time0)/CLOCKS_PER_SEC << " s" << endl;
+
+  double max_diff = 0;
+  for(int hash_consing=0; hash_consing<2; ++hash_consing){
+    SX::setHashConsing(hash_consing);
+    
+    // Each thread builds all the scenarios
+    vector<vector<double> > res(nthreads,vector<double>(nscenarios));
+    vector<thread> threads;
+    for(int t=0; t<nthreads; ++t){
+      threads.push_back(thread([t,&res](){
+        for(int k=0; k<nscenarios; ++k) res[t][k] = scenario((k+t)%nscenarios);
+      }));
+    }
+    for(int t=0; t<nthreads; ++t) threads[t].join();
+    
+    // Compare
+    for(int t=0; t<nthreads; ++t){
+      for(int k=0; k<nscenarios; ++k){
+        max_diff = std::max(max_diff,fabs(res[t][(k+nscenarios-t)%nscenarios]-ref[k]));
+      }
+    }
+    cout << nscenarios << " scenarios in each of " << nthreads << " threads" << (hash_consing ? " with hash-consing" : "") << ", maximum difference: " << max_diff << endl;
+  }
+  SX::setHashConsing(false);
+  SX::clearHashConsing();
+  return max_diff==0 ? 0 : 1;
+}
@@ -98,3 +98,22 @@ for f in [gfcn,efcn_no_opt,efcn_O3_opt,efcn_Os_opt]:
   print "time per elementary operations: ", dt/num_op*1e9, " ns"
   
   
+
+# Code generation also works for matrix valued graphs, embedded function calls are generated as separate functions
+X = msym("X",7,7)
+[G] = gfcn.call([vec(X)])
+mfcn = MXFunction([X],[mul(X,reshape(G,7,7)) + sin(X)])
+mfcn.init()
+
+srcname = "mx_grad_det.c"
+mfcn.generateCode(srcname)
+objname_mx = "mx_grad_det.so"
+if compileme:
+  system("gcc -fPIC -shared -O3 " + srcname + " -o " + objname_mx)
+efcn_mx = ExternalFunction("./"+objname_mx)
+efcn_mx.init()
+
+for f in [mfcn,efcn_mx]:
+  f.setInput(x0)
+  f.evaluate()
+  print "result = ", f.output().data()
@@ -471,7 +471,7 @@ bool IpoptInternal::eval_h(const double* x, bool new_x, double obj_factor, const
       }
 
       // Evaluate
-      H_.evaluate();
+      H_.evaluateOutput(0);
 
       // Scale objective
       if(n_hess_in==1 && obj_factor!=1.0){
@@ -524,7 +524,7 @@ bool IpoptInternal::eval_jac_g(int n, const double* x, bool new_x,int m, int nel
       J_.setInput(x);
       
        // Evaluate the function
-      J_.evaluate();
+      J_.evaluateOutput(0);
 
       // Get the output
       J_.getOutput(values);
@@ -561,7 +561,7 @@ bool IpoptInternal::eval_f(int n, const double* x, bool new_x, double& obj_value
     F_.setInput(x);
       
     // Evaluate the function
-    F_.evaluate();
+    F_.evaluateOutput(0);
 
     // Get the result
     F_.getOutput(obj_value);
@@ -597,7 +597,7 @@ bool IpoptInternal::eval_g(int n, const double* x, bool new_x, int m, double* g)
       G_.setInput(x);
 
       // Evaluate the function and tape
-      G_.evaluate();
+      G_.evaluateOutput(0);
 
       // Ge the result
       G_.getOutput(g);
@@ -658,7 +658,7 @@ bool IpoptInternal::eval_grad_f(int n, const double* x, bool new_x, double* grad
       GF_.setInput(x);
       
       // Evaluate, adjoint mode
-      GF_.evaluate();
+      GF_.evaluateOutput(0);
 
       // Get the result
       GF_.output().getArray(grad_f,n,DENSE);
@@ -231,7 +231,7 @@ void SQPInternal::evaluate(int nfdir, int nadir){
         H_.setInput(mu_, n_hess_in == 4 ? 2 : 1);
         H_.setInput(1, n_hess_in == 4 ? 3 : 2);
       }
-      H_.evaluate();
+      H_.evaluateOutput(0);
       H_.getOutput(Bk_);
       // Determing regularization parameter with Gershgorin theorem
       if (bool(getOption("regularize"))){
@@ -275,7 +275,7 @@ void SQPInternal::evaluate(int nfdir, int nadir){
     if(m_>0){
       // Evaluate the constraint function
       G_.setInput(x_);
-      G_.evaluate();
+      G_.evaluateOutput(0);
       G_.getOutput(gk_);
       
       if (monitored("eval_g")) {
@@ -286,7 +286,7 @@ void SQPInternal::evaluate(int nfdir, int nadir){
       
       // Evaluate the constraint Jacobian
       J_.setInput(x_);
-      J_.evaluate();
+      J_.evaluateOutput(0);
 
       if (monitored("eval_jac_g")) {
         cout << "(main loop) x = " << x_ << endl;
@@ -423,12 +423,12 @@ void SQPInternal::evaluate(int nfdir, int nadir){
       for(int i=0; i<n_; ++i) x_cand_[i] = x_[i] + t * dx[i]; 
       // Evaluating objective and constraints
       F_.setInput(x_cand_);
-      F_.evaluate();
+      F_.evaluateOutput(0);
       F_.getOutput(fk_cand);
       l1_infeas = 0.;
       if (!G_.isNull()){
         G_.setInput(x_cand_);
-        G_.evaluate();
+        G_.evaluateOutput(0);
         G_.getOutput(gk_cand_);
 
         // Calculating merit-function in candidate
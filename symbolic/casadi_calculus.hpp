@@ -315,6 +315,14 @@ struct BinaryOperationE{
   }
 };
 
+/// Apply an operation to n points, stored contiguously
+template<int I>
+struct BinaryOperationN{
+  template<typename T> static inline void fcn(const T* x, const T* y, T* f, int n){
+    for(int i=0; i<n; ++i) BinaryOperation<I>::fcn(x[i],y[i],f[i]);
+  }
+};
+
 /// Calculate function and derivative
 template<int I>
 struct DerBinaryOpertion{
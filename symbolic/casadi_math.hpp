@@ -89,6 +89,9 @@ struct casadi_math{
   /** \brief Evaluate a built in function */
   static inline void fun(unsigned char op, const T& x, const T& y, T& f);
   
+  /** \brief Evaluate a built in function for n points, stored contiguously */
+  static inline void fun(unsigned char op, const T* x, const T* y, T* f, int n);
+  
   /** \brief Evaluate a built in derivative function */
   static inline void der(unsigned char op, const T& x, const T& y, const T& f, T* d);
 
@@ -198,6 +201,58 @@ inline void casadi_math<T>::fun(unsigned char op, const T& x, const T& y, T& f){
   }
 }
 
+template<typename T>
+inline void casadi_math<T>::fun(unsigned char op, const T* x, const T* y, T* f, int n){
+// NOTE: Same as above, but with the loop over the points inside each case, allowing vectorization
+#define CASADI_MATH_FUN_N_BUILTIN(X,Y,F,N) \
+    case OP_ASSIGN:    BinaryOperationN<OP_ASSIGN>::fcn(X,Y,F,N);        break;\
+    case OP_ADD:       BinaryOperationN<OP_ADD>::fcn(X,Y,F,N);           break;\
+    case OP_SUB:       BinaryOperationN<OP_SUB>::fcn(X,Y,F,N);           break;\
+    case OP_MUL:       BinaryOperationN<OP_MUL>::fcn(X,Y,F,N);           break;\
+    case OP_DIV:       BinaryOperationN<OP_DIV>::fcn(X,Y,F,N);           break;\
+    case OP_NEG:       BinaryOperationN<OP_NEG>::fcn(X,Y,F,N);           break;\
+    case OP_EXP:       BinaryOperationN<OP_EXP>::fcn(X,Y,F,N);           break;\
+    case OP_LOG:       BinaryOperationN<OP_LOG>::fcn(X,Y,F,N);           break;\
+    case OP_POW:       BinaryOperationN<OP_POW>::fcn(X,Y,F,N);           break;\
+    case OP_CONSTPOW:  BinaryOperationN<OP_CONSTPOW>::fcn(X,Y,F,N);      break;\
+    case OP_SQRT:      BinaryOperationN<OP_SQRT>::fcn(X,Y,F,N);          break;\
+    case OP_SIN:       BinaryOperationN<OP_SIN>::fcn(X,Y,F,N);           break;\
+    case OP_COS:       BinaryOperationN<OP_COS>::fcn(X,Y,F,N);           break;\
+    case OP_TAN:       BinaryOperationN<OP_TAN>::fcn(X,Y,F,N);           break;\
+    case OP_ASIN:      BinaryOperationN<OP_ASIN>::fcn(X,Y,F,N);          break;\
+    case OP_ACOS:      BinaryOperationN<OP_ACOS>::fcn(X,Y,F,N);          break;\
+    case OP_ATAN:      BinaryOperationN<OP_ATAN>::fcn(X,Y,F,N);          break;\
+    case OP_LT:        BinaryOperationN<OP_LT>::fcn(X,Y,F,N);            break;\
+    case OP_LE:        BinaryOperationN<OP_LE>::fcn(X,Y,F,N);            break;\
+    case OP_EQ:        BinaryOperationN<OP_EQ>::fcn(X,Y,F,N);            break;\
+    case OP_NE:        BinaryOperationN<OP_NE>::fcn(X,Y,F,N);            break;\
+    case OP_NOT:       BinaryOperationN<OP_NOT>::fcn(X,Y,F,N);           break;\
+    case OP_AND:       BinaryOperationN<OP_AND>::fcn(X,Y,F,N);           break;\
+    case OP_OR:        BinaryOperationN<OP_OR>::fcn(X,Y,F,N);            break;\
+    case OP_IF_ELSE_ZERO: BinaryOperationN<OP_IF_ELSE_ZERO>::fcn(X,Y,F,N); break;\
+    case OP_FLOOR:     BinaryOperationN<OP_FLOOR>::fcn(X,Y,F,N);         break;\
+    case OP_CEIL:      BinaryOperationN<OP_CEIL>::fcn(X,Y,F,N);          break;\
+    case OP_FABS:      BinaryOperationN<OP_FABS>::fcn(X,Y,F,N);          break;\
+    case OP_SIGN:      BinaryOperationN<OP_SIGN>::fcn(X,Y,F,N);          break;\
+    case OP_ERF:       BinaryOperationN<OP_ERF>::fcn(X,Y,F,N);           break;\
+    case OP_FMIN:      BinaryOperationN<OP_FMIN>::fcn(X,Y,F,N);          break;\
+    case OP_FMAX:      BinaryOperationN<OP_FMAX>::fcn(X,Y,F,N);          break;\
+    case OP_INV:       BinaryOperationN<OP_INV>::fcn(X,Y,F,N);           break;\
+    case OP_SINH:      BinaryOperationN<OP_SINH>::fcn(X,Y,F,N);          break;\
+    case OP_COSH:      BinaryOperationN<OP_COSH>::fcn(X,Y,F,N);          break;\
+    case OP_TANH:      BinaryOperationN<OP_TANH>::fcn(X,Y,F,N);          break;\
+    case OP_ASINH:     BinaryOperationN<OP_ASINH>::fcn(X,Y,F,N);         break;\
+    case OP_ACOSH:     BinaryOperationN<OP_ACOSH>::fcn(X,Y,F,N);         break;\
+    case OP_ATANH:     BinaryOperationN<OP_ATANH>::fcn(X,Y,F,N);         break;\
+    case OP_ATAN2:     BinaryOperationN<OP_ATAN2>::fcn(X,Y,F,N);         break; \
+    case OP_ERFINV:    BinaryOperationN<OP_ERFINV>::fcn(X,Y,F,N);        break;\
+    case OP_PRINTME:   BinaryOperationN<OP_PRINTME>::fcn(X,Y,F,N);       break;
+  
+  switch(op){
+    CASADI_MATH_FUN_N_BUILTIN(x,y,f,n)
+  }
+}
+
 template<typename T>
 inline void casadi_math<T>::der(unsigned char op, const T& x, const T& y, const T& f, T* d){
 // NOTE: We define the implementation in a preprocessor macro to be able to force inlining, and to allow extensions in the VM
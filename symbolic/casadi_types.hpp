@@ -27,6 +27,9 @@
 #include <cassert>
 #include <vector>
 #include <utility>
+#ifdef WITH_THREADSAFE_SYMBOLICS
+#include <atomic>
+#endif // WITH_THREADSAFE_SYMBOLICS
 
 namespace CasADi{
   
@@ -75,6 +78,13 @@ namespace CasADi{
   typedef unsigned long bvec_t;
   #endif
 
+  // Type of the reference counters of SX nodes and shared objects, atomic if expressions may be created and destroyed from several threads
+  #ifdef WITH_THREADSAFE_SYMBOLICS
+  typedef std::atomic<unsigned int> refcount_t;
+  #else // WITH_THREADSAFE_SYMBOLICS
+  typedef unsigned int refcount_t;
+  #endif // WITH_THREADSAFE_SYMBOLICS
+
   // Number of directions we can deal with at a time
   const int bvec_size = CHAR_BIT*sizeof(bvec_t); // the size of bvec_t in bits (CHAR_BIT is the number of bits per byte, usually 8)
 
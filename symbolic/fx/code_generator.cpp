@@ -0,0 +1,236 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "code_generator.hpp"
+#include "sx_function_internal.hpp"
+#include "mx_function_internal.hpp"
+#include <limits>
+
+using namespace std;
+
+namespace CasADi{
+
+CodeGenerator::CodeGenerator() : added_auxiliaries_(NUM_AUX,false){
+  // Print the floating point constants with full precision, scientific format to force a decimal dot
+  declarations_.precision(numeric_limits<double>::digits10+2);
+  declarations_ << scientific;
+  functions_.precision(numeric_limits<double>::digits10+2);
+  functions_ << scientific;
+}
+
+void CodeGenerator::flush(std::ostream &s) const{
+  s << declarations_.str();
+  s << endl;
+  s << functions_.str();
+}
+
+void CodeGenerator::printVector(std::ostream &s, const std::string& name, const std::vector<int>& v){
+  s << "int " << name << "[] = {";
+  for(int i=0; i<v.size(); ++i){
+    if(i!=0) s << ",";
+    s << v[i];
+  }
+  s << "};" << endl;
+}
+
+void CodeGenerator::printVector(std::ostream &s, const std::string& name, const std::vector<double>& v){
+  s << "d " << name << "[] = {";
+  for(int i=0; i<v.size(); ++i){
+    if(i!=0) s << ",";
+    s << v[i];
+  }
+  s << "};" << endl;
+}
+
+std::string CodeGenerator::getConstant(const std::vector<int>& v){
+  // Arrays in C cannot be empty
+  std::vector<int> vv = v.empty() ? vector<int>(1,0) : v;
+  
+  // Add if not already added
+  map<vector<int>,int>::const_iterator it = int_constants_.find(vv);
+  int ind;
+  if(it==int_constants_.end()){
+    ind = int_constants_.size();
+    int_constants_[vv] = ind;
+    stringstream name;
+    name << "s" << ind;
+    declarations_ << "static const ";
+    printVector(declarations_,name.str(),vv);
+  } else {
+    ind = it->second;
+  }
+  stringstream name;
+  name << "s" << ind;
+  return name.str();
+}
+
+std::string CodeGenerator::getConstant(const std::vector<double>& v){
+  // Arrays in C cannot be empty
+  std::vector<double> vv = v.empty() ? vector<double>(1,0) : v;
+  
+  // Add if not already added
+  map<vector<double>,int>::const_iterator it = real_constants_.find(vv);
+  int ind;
+  if(it==real_constants_.end()){
+    ind = real_constants_.size();
+    real_constants_[vv] = ind;
+    stringstream name;
+    name << "c" << ind;
+    declarations_ << "static const ";
+    printVector(declarations_,name.str(),vv);
+  } else {
+    ind = it->second;
+  }
+  stringstream name;
+  name << "c" << ind;
+  return name.str();
+}
+
+std::string CodeGenerator::getSparsity(const CRSSparsity& sp){
+  vector<int> v;
+  v.reserve(2 + sp.rowind().size() + sp.col().size());
+  v.push_back(sp.size1());
+  v.push_back(sp.size2());
+  v.insert(v.end(),sp.rowind().begin(),sp.rowind().end());
+  v.insert(v.end(),sp.col().begin(),sp.col().end());
+  return getConstant(v);
+}
+
+std::string CodeGenerator::getDependency(const FX& f){
+  // Quick return if already added
+  map<const void*,int>::const_iterator it = dependencies_.find(f.get());
+  if(it!=dependencies_.end()){
+    stringstream name;
+    name << "f" << it->second;
+    return name.str();
+  }
+  
+  // Add the function
+  int ind = dependencies_.size();
+  dependencies_[f.get()] = ind;
+  stringstream name;
+  name << "f" << ind;
+  
+  const SXFunctionInternal* sx_f = dynamic_cast<const SXFunctionInternal*>(f.get());
+  const MXFunctionInternal* mx_f = dynamic_cast<const MXFunctionInternal*>(f.get());
+  if(sx_f){
+    casadi_assert_message(sx_f->free_vars_.empty(),"Code generation is not possible since variables " << sx_f->free_vars_ << " are free.");
+    functions_ << "static int " << name.str() << "(const d** x, d** r){" << endl;
+    sx_f->generateBody(functions_);
+    functions_ << "return 0;" << endl;
+    functions_ << "}" << endl << endl;
+  } else if(mx_f){
+    const_cast<MXFunctionInternal*>(mx_f)->generateFunction(functions_,name.str(),*this);
+  } else {
+    casadi_error("CodeGenerator::getDependency: Code generation is only possible for SXFunction and MXFunction");
+  }
+  return name.str();
+}
+
+void CodeGenerator::addAuxiliary(Auxiliary f){
+  // Quick return if already added
+  if(added_auxiliaries_[f]) return;
+  added_auxiliaries_[f] = true;
+  
+  switch(f){
+    case AUX_MM_NT:
+      functions_ << "/* Sparse matrix-matrix multiplication, z += x*trans(y) */" << endl;
+      functions_ << "static void casadi_mm_nt(const d* x, const int* sp_x, const d* trans_y, const int* sp_trans_y, d* z, const int* sp_z){" << endl;
+      functions_ << "  int i, el, j, el1, el2, j1, i2;" << endl;
+      functions_ << "  const int *x_rowind = sp_x+2, *x_col = sp_x + 2 + sp_x[0]+1;" << endl;
+      functions_ << "  const int *y_colind = sp_trans_y+2, *y_row = sp_trans_y + 2 + sp_trans_y[0]+1;" << endl;
+      functions_ << "  const int *z_rowind = sp_z+2, *z_col = sp_z + 2 + sp_z[0]+1;" << endl;
+      functions_ << "  for(i=0; i<sp_z[0]; ++i){" << endl;
+      functions_ << "    for(el=z_rowind[i]; el<z_rowind[i+1]; ++el){" << endl;
+      functions_ << "      j = z_col[el];" << endl;
+      functions_ << "      el1 = x_rowind[i];" << endl;
+      functions_ << "      el2 = y_colind[j];" << endl;
+      functions_ << "      while(el1 < x_rowind[i+1] && el2 < y_colind[j+1]){" << endl;
+      functions_ << "        j1 = x_col[el1];" << endl;
+      functions_ << "        i2 = y_row[el2];" << endl;
+      functions_ << "        if(j1==i2){" << endl;
+      functions_ << "          z[el] += x[el1++] * trans_y[el2++];" << endl;
+      functions_ << "        } else if(j1<i2) {" << endl;
+      functions_ << "          el1++;" << endl;
+      functions_ << "        } else {" << endl;
+      functions_ << "          el2++;" << endl;
+      functions_ << "        }" << endl;
+      functions_ << "      }" << endl;
+      functions_ << "    }" << endl;
+      functions_ << "  }" << endl;
+      functions_ << "}" << endl << endl;
+      break;
+    case AUX_DENSIFY:
+      functions_ << "/* Convert a sparse matrix to a dense, row-major matrix */" << endl;
+      functions_ << "static void casadi_densify(const d* x, const int* sp_x, d* r){" << endl;
+      functions_ << "  int i, el;" << endl;
+      functions_ << "  const int *rowind = sp_x+2, *col = sp_x + 2 + sp_x[0]+1;" << endl;
+      functions_ << "  for(i=0; i<sp_x[0]*sp_x[1]; ++i) r[i] = 0;" << endl;
+      functions_ << "  for(i=0; i<sp_x[0]; ++i){" << endl;
+      functions_ << "    for(el=rowind[i]; el<rowind[i+1]; ++el){" << endl;
+      functions_ << "      r[col[el] + i*sp_x[1]] = x[el];" << endl;
+      functions_ << "    }" << endl;
+      functions_ << "  }" << endl;
+      functions_ << "}" << endl << endl;
+      break;
+    case AUX_SOLVE:
+      functions_ << "/* Solve A*x = b by an LU factorization with partial pivoting, x is dense and row-major." << endl;
+      functions_ << "   lu, w and perm are work arrays with n*n, n*nrhs and n elements. Returns 1 if A is singular. */" << endl;
+      functions_ << "static int casadi_solve(const d* A, const int* sp_A, const d* b, const int* sp_b, d* x, d* lu, d* w, int* perm){" << endl;
+      functions_ << "  int n = sp_A[0], nrhs = sp_b[1];" << endl;
+      functions_ << "  int i, j, k, c, el, piv;" << endl;
+      functions_ << "  const int *A_rowind = sp_A+2, *A_col = sp_A + 2 + sp_A[0]+1;" << endl;
+      functions_ << "  const int *b_rowind = sp_b+2, *b_col = sp_b + 2 + sp_b[0]+1;" << endl;
+      functions_ << "  d t;" << endl;
+      functions_ << "  for(i=0; i<n*n; ++i) lu[i] = 0;" << endl;
+      functions_ << "  for(i=0; i<n; ++i) for(el=A_rowind[i]; el<A_rowind[i+1]; ++el) lu[i*n+A_col[el]] = A[el];" << endl;
+      functions_ << "  for(i=0; i<n; ++i) perm[i] = i;" << endl;
+      functions_ << "  for(k=0; k<n; ++k){" << endl;
+      functions_ << "    piv = k;" << endl;
+      functions_ << "    for(i=k+1; i<n; ++i) if(fabs(lu[i*n+k])>fabs(lu[piv*n+k])) piv = i;" << endl;
+      functions_ << "    if(lu[piv*n+k]==0) return 1;" << endl;
+      functions_ << "    if(piv!=k){" << endl;
+      functions_ << "      for(j=0; j<n; ++j){ t = lu[k*n+j]; lu[k*n+j] = lu[piv*n+j]; lu[piv*n+j] = t;}" << endl;
+      functions_ << "      i = perm[k]; perm[k] = perm[piv]; perm[piv] = i;" << endl;
+      functions_ << "    }" << endl;
+      functions_ << "    for(i=k+1; i<n; ++i){" << endl;
+      functions_ << "      t = lu[i*n+k] /= lu[k*n+k];" << endl;
+      functions_ << "      for(j=k+1; j<n; ++j) lu[i*n+j] -= t*lu[k*n+j];" << endl;
+      functions_ << "    }" << endl;
+      functions_ << "  }" << endl;
+      functions_ << "  for(i=0; i<n*nrhs; ++i) w[i] = 0;" << endl;
+      functions_ << "  for(i=0; i<n; ++i) for(el=b_rowind[i]; el<b_rowind[i+1]; ++el) w[i*nrhs+b_col[el]] = b[el];" << endl;
+      functions_ << "  for(i=0; i<n; ++i) for(c=0; c<nrhs; ++c) x[i*nrhs+c] = w[perm[i]*nrhs+c];" << endl;
+      functions_ << "  for(i=0; i<n; ++i) for(j=0; j<i; ++j) for(c=0; c<nrhs; ++c) x[i*nrhs+c] -= lu[i*n+j]*x[j*nrhs+c];" << endl;
+      functions_ << "  for(i=n-1; i>=0; --i){" << endl;
+      functions_ << "    for(j=i+1; j<n; ++j) for(c=0; c<nrhs; ++c) x[i*nrhs+c] -= lu[i*n+j]*x[j*nrhs+c];" << endl;
+      functions_ << "    for(c=0; c<nrhs; ++c) x[i*nrhs+c] /= lu[i*n+i];" << endl;
+      functions_ << "  }" << endl;
+      functions_ << "  return 0;" << endl;
+      functions_ << "}" << endl << endl;
+      break;
+    default:
+      casadi_error("CodeGenerator::addAuxiliary: Unknown auxiliary function");
+  }
+}
+
+} // namespace CasADi
@@ -0,0 +1,89 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef CODE_GENERATOR_HPP
+#define CODE_GENERATOR_HPP
+
+#include "fx.hpp"
+#include "../matrix/crs_sparsity.hpp"
+#include <map>
+#include <sstream>
+
+namespace CasADi{
+
+/** \brief Helper class for C code generation
+  Collects the constant arrays, the auxiliary functions and the functions that the generated code depends on,
+  making sure that each of them is only printed once.
+*/
+class CodeGenerator{
+  public:
+    /// Constructor
+    CodeGenerator();
+    
+    /// Print the collected declarations and functions, to be placed before the code using them
+    void flush(std::ostream &s) const;
+    
+    /// Add an integer constant array and get its name, identical arrays are only added once
+    std::string getConstant(const std::vector<int>& v);
+
+    /// Add a floating point constant array and get its name, identical arrays are only added once
+    std::string getConstant(const std::vector<double>& v);
+    
+    /// Add a sparsity pattern and get its name, stored as [nrow, ncol, rowind..., col...]
+    std::string getSparsity(const CRSSparsity& sp);
+    
+    /// Add a function that the generated code depends on and get its name
+    std::string getDependency(const FX& f);
+    
+    /// Auxiliary functions
+    enum Auxiliary{AUX_MM_NT, AUX_DENSIFY, AUX_SOLVE, NUM_AUX};
+    
+    /// Make sure that an auxiliary function is available
+    void addAuxiliary(Auxiliary f);
+    
+    /// Print an integer vector
+    static void printVector(std::ostream &s, const std::string& name, const std::vector<int>& v);
+    
+    /// Print a floating point vector
+    static void printVector(std::ostream &s, const std::string& name, const std::vector<double>& v);
+    
+  protected:
+    /// Declarations of constants and work arrays
+    std::stringstream declarations_;
+    
+    /// Auxiliary and dependent functions
+    std::stringstream functions_;
+    
+    /// Constants that have already been added
+    std::map<std::vector<int>,int> int_constants_;
+    std::map<std::vector<double>,int> real_constants_;
+    
+    /// Functions that have already been added
+    std::map<const void*,int> dependencies_;
+    
+    /// Auxiliary functions that have been added
+    std::vector<bool> added_auxiliaries_;
+};
+
+} // namespace CasADi
+
+#endif // CODE_GENERATOR_HPP
@@ -105,10 +105,14 @@ void DerivativeInternal::evaluate(int nfdir, int nadir){
   // Current forward and adjoint direction
   int offset_fwd = 0, offset_adj = 0;
   
-  // Current input/output index
+  // Current input/output index for the forward directions (these come first)
   int iind=0;
   int oind=0;
   
+  // Current input/output index for the adjoint directions
+  int iind_adj = num_in*(1+nfwd_);
+  int oind_adj = num_out*(1+nfwd_);
+  
   // Evaluate until everything has been determinated
   bool first_batch=true;
   while (first_batch || offset_fwd < nfwd_ || offset_adj < nadj_) {
@@ -134,7 +138,7 @@ void DerivativeInternal::evaluate(int nfdir, int nadir){
     // Pass the adjoint seed to the function
     for(int d = 0; d < nadj_f_batch; ++d){
       for(int i = 0; i < num_out; ++i) {
-        fcn_.setAdjSeed(input(iind++),i,d);
+        fcn_.setAdjSeed(input(iind_adj++),i,d);
       }
     }
 
@@ -158,7 +162,7 @@ void DerivativeInternal::evaluate(int nfdir, int nadir){
     // Get the adjoint sensitivities
     for(int d = 0; d < nadj_f_batch; ++d){
       for(int i = 0; i < num_in; ++i) {
-        fcn_.getAdjSens(output(oind++),i,d);
+        fcn_.getAdjSens(output(oind_adj++),i,d);
       }
     }
 
@@ -124,6 +124,18 @@ void FX::solve(){
   evaluate(0,0);
 }
 
+void FX::evaluateOutputs(const std::vector<int>& oind){
+  assertInit();
+  for(vector<int>::const_iterator it=oind.begin(); it!=oind.end(); ++it){
+    casadi_assert_message(*it>=0 && *it<getNumOutputs(), "FX::evaluateOutputs: output index " << *it << " out of bounds, the function has " << getNumOutputs() << " outputs");
+  }
+  (*this)->evaluateOutputs(oind);
+}
+
+void FX::evaluateOutput(int oind){
+  evaluateOutputs(vector<int>(1,oind));
+}
+
 int FX::getNumInputs() const{
   return (*this)->getNumInputs();
 }
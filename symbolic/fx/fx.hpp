@@ -151,6 +151,16 @@ class FX : public OptionsFunctionality{
   
   /// the same as evaluate(0,0)
   void solve();
+  
+  /** \brief  Evaluate only the outputs with index in oind, without derivatives
+      SXFunction and MXFunction skip the operations that are not needed for the requested outputs, unless they are compiled,
+      evaluated level by level or few operations could be skipped. Other functions are evaluated completely. The other outputs
+      are updated only if the function is evaluated completely.
+  */
+  void evaluateOutputs(const std::vector<int>& oind);
+  
+  /// Evaluate only the output with index oind, see evaluateOutputs
+  void evaluateOutput(int oind);
     
   /** \brief Generate a Jacobian function of output oind with respect to input iind
   * \param iind The index of the input
@@ -28,6 +28,11 @@
 #include "../matrix/matrix_tools.hpp"
 #include "../sx/sx_tools.hpp"
 #include "../matrix/sparsity_tools.hpp"
+#include "code_generator.hpp"
+
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif //WITH_OPENMP
 
 using namespace std;
 
@@ -50,8 +55,16 @@ FXInternal::FXInternal(){
   addOption("user_data",                OT_VOIDPTR,             GenericType(),  "A user-defined field that can be used to identify the function or pass additional information");
   addOption("monitor",      OT_STRINGVECTOR, GenericType(),  "Monitors to be activated","inputs|outputs");
   addOption("regularity_check",         OT_BOOLEAN,             true,          "Throw exceptions when NaN or Inf appears during evaluation");
+  addOption("sparsity_parallelization", OT_STRING,              "serial",      "Distribute the sweeps of the Jacobian sparsity calculation over threads, each with a private work vector, for functions that support propagating several words per nonzero, and color the Jacobian sparsity pattern speculatively in parallel (requires CasADi to be compiled with WITH_OPENMP=ON)","serial|openmp");
+  addOption("coloring_ordering",        OT_STRING,              "largest_first", "Vertex ordering used by the graph coloring that compresses Jacobians and Hessians","natural|largest_first|smallest_last|incidence_degree");
+  addOption("coloring_recolor",         OT_INTEGER,             1,             "Number of recoloring passes (class by class) to reduce the number of colors used to compress Jacobians and Hessians");
+  addOption("sparsity_cache",           OT_STRING,              "",            "Directory of a persistent cache of Jacobian sparsity patterns and their colorings, shared between processes and keyed by a hash of the function structure (empty string: no cache)");
+  addOption("sparsity_cache_max_size",  OT_REAL,                1e8,     "Maximum total size in bytes of the sparsity cache, the least recently used entries are removed first (non-positive: no limit)");
+  addOption("sparsity_block_width",     OT_INTEGER,             8,             "Number of words (each holding bvec_size directions) propagated per nonzero in each sweep when calculating Jacobian sparsity patterns, for functions that support it (1, 2, 4, 8 or 16)");
   
   verbose_ = false;
+  sp_parallel_ = false;
+  structure_key_computed_ = false;
   jacgen_ = 0;
   spgen_ = 0;
   user_data_ = 0;
@@ -70,6 +83,18 @@ FXInternal::~FXInternal(){
 void FXInternal::init(){
   verbose_ = getOption("verbose");
   regularity_check_ = getOption("regularity_check");
+  sp_parallel_ = getOption("sparsity_parallelization")=="openmp";
+  #ifndef WITH_OPENMP
+  if(sp_parallel_){
+    casadi_warning("OpenMP parallelization is not available, switching to serial sparsity calculation. Recompile CasADi setting the option WITH_OPENMP to ON.");
+    sp_parallel_ = false;
+  }
+  #endif // WITH_OPENMP
+  int sp_block_width = getOption("sparsity_block_width");
+  casadi_assert_message(sp_block_width==1 || sp_block_width==2 || sp_block_width==4 || sp_block_width==8 || sp_block_width==16, "FXInternal::init: \"sparsity_block_width\" must be 1, 2, 4, 8 or 16, got " << sp_block_width);
+  sp_cache_ = SparsityCache(getOption("sparsity_cache"),long(double(getOption("sparsity_cache_max_size"))));
+  structure_key_computed_ = false;
+  stats_["sparsity_cache_hits"] = 0;
   bool store_jacobians = getOption("store_jacobians");
   casadi_assert_warning(!store_jacobians,"Option \"store_jacobians\" has been deprecated. Jacobians are now always cached.");
   
@@ -151,6 +176,80 @@ void FXInternal::requestNumSens(int nfwd, int nadj){
   }
 }
 
+void FXInternal::generateInterface(std::ostream &cfile) const{
+  // Number of inputs/outputs
+  int n_i = input_.size();
+  int n_o = output_.size();
+  int n_io = n_i + n_o;
+
+  // Dimensions
+  cfile << "int n_in_ = " << n_i << ";" << endl;
+  cfile << "int n_out_ = " << n_o << ";" << endl;
+
+  // Number of rows and columns
+  vector<int> nrow(n_io), ncol(n_io);
+  for(int i=0; i<n_i; ++i){
+    nrow[i] = input(i).size1();
+    ncol[i] = input(i).size2();
+  }
+  for(int i=0; i<n_o; ++i){
+    nrow[i+n_i] = output(i).size1();
+    ncol[i+n_i] = output(i).size2();
+  }
+  
+  // Print to file
+  CodeGenerator::printVector(cfile,"nrow_",nrow);
+  CodeGenerator::printVector(cfile,"ncol_",ncol);
+  
+  // Print row offsets
+  for(int i=0; i<n_io; ++i){
+    stringstream name;
+    name << "rowind_" << i << "_";
+    const vector<int>& rowind = i<n_i ? input(i).rowind() : output(i-n_i).rowind();
+    CodeGenerator::printVector(cfile,name.str(),rowind);
+  }
+  
+  // Array of pointers to the arrays above
+  cfile << "int *rowind_[] = {";
+  for(int i=0; i<n_io; ++i){
+    if(i!=0) cfile << ",";
+    cfile << "rowind_" << i << "_"; 
+  }
+  cfile << "};" << endl;
+  
+  // Print columns
+  for(int i=0; i<n_io; ++i){
+    stringstream name;
+    name << "col_" << i << "_";
+    const vector<int>& col = i<n_i ? input(i).col() : output(i-n_i).col();
+    CodeGenerator::printVector(cfile,name.str(),col);
+  }
+  
+  // Array of pointers to the arrays above
+  cfile << "int *col_[] = {";
+  for(int i=0; i<n_io; ++i){
+    if(i!=0) cfile << ",";
+    cfile << "col_" << i << "_"; 
+  }
+  cfile << "};" << endl << endl;
+  
+  // Function to get dimensions
+  cfile << "int init(int *n_in, int *n_out){" << endl;
+  cfile << "  *n_in = n_in_;" << endl;
+  cfile << "  *n_out = n_out_;" << endl;
+  cfile << "  return 0;" << endl;
+  cfile << "}" << endl << endl;
+
+  // Input sizes
+  cfile << "int getSparsity(int i, int *nrow, int *ncol, int **rowind, int **col){" << endl;
+  cfile << "  *nrow = nrow_[i];" << endl;
+  cfile << "  *ncol = ncol_[i];" << endl;
+  cfile << "  *rowind = rowind_[i];" << endl;
+  cfile << "  *col = col_[i];" << endl;
+  cfile << "  return 0;" << endl;
+  cfile << "}" << endl << endl;
+}
+
 void FXInternal::print(ostream &stream) const{
   if (getNumInputs()==1) {
     stream << " Input: " << input().dimString() << std::endl;
@@ -319,6 +418,14 @@ CRSSparsity FXInternal::getJacSparsity(int iind, int oind){
       use_fwd = false;
     }
     
+    // Propagate several words per nonzero in each sweep, if supported and more than one word is needed
+    int nsweep_min = use_fwd ? nsweep_fwd : nsweep_adj;
+    int nw = getOption("sparsity_block_width");
+    while(nw>1 && nw/2>=nsweep_min) nw /= 2;
+    if(nw>1 && spCanEvaluateBlock(use_fwd)){
+      return getJacSparsityBlock(iind,oind,use_fwd,nw);
+    }
+    
     // Reset the virtual machine
     spInit(use_fwd);
 
@@ -442,6 +549,105 @@ CRSSparsity FXInternal::getJacSparsity(int iind, int oind){
   }
 }
 
+CRSSparsity FXInternal::getJacSparsityBlock(int iind, int oind, bool use_fwd, int nw){
+  // The number of nonzeros in the seed and sensitivity directions
+  int nz_seed = use_fwd ? input(iind).size() : output(oind).size();
+  int nz_sens = use_fwd ? output(oind).size() : input(iind).size();
+  
+  // Number of directions per sweep and number of sweeps needed
+  int ndir = nw*bvec_size;
+  int nsweep = nz_seed/ndir;
+  if(nz_seed%ndir>0) nsweep++;
+
+  // Print
+  if(verbose()){
+    std::cout << "FXInternal::getJacSparsityBlock: using " << (use_fwd ? "forward" : "adjoint") << " mode: ";
+    std::cout << nsweep << " sweeps of " << ndir << " directions needed for " << nz_seed << " directions" << std::endl;
+  }
+  
+  // Temporary vectors
+  std::vector<int> jrow, jcol;
+  
+  if(sp_parallel_){
+#ifdef WITH_OPENMP
+    // Pattern found by each thread
+    int nthreads = omp_get_max_threads();
+    std::vector<std::vector<int> > jrow_t(nthreads), jcol_t(nthreads);
+    
+    #pragma omp parallel
+    {
+      // Private seeds, sensitivities and work vector
+      int t = omp_get_thread_num();
+      std::vector<bvec_t> seed(nz_seed*nw,bvec_t(0)), sens(nz_sens*nw), work;
+      
+      // Distribute the sweeps
+      #pragma omp for schedule(dynamic)
+      for(int s=0; s<nsweep; ++s){
+        spJacSweep(use_fwd,nw,iind,oind,s*ndir,std::min(ndir,nz_seed-s*ndir),seed,sens,work,jrow_t[t],jcol_t[t]);
+      }
+    }
+    
+    // Merge the patterns
+    for(int t=0; t<nthreads; ++t){
+      jrow.insert(jrow.end(),jrow_t[t].begin(),jrow_t[t].end());
+      jcol.insert(jcol.end(),jcol_t[t].begin(),jcol_t[t].end());
+    }
+#endif // WITH_OPENMP
+  } else {
+    // Seeds, sensitivities and work vector
+    std::vector<bvec_t> seed(nz_seed*nw,bvec_t(0)), sens(nz_sens*nw), work;
+    
+    // Loop over the variables, ndir variables at a time
+    for(int s=0; s<nsweep; ++s){
+      spJacSweep(use_fwd,nw,iind,oind,s*ndir,std::min(ndir,nz_seed-s*ndir),seed,sens,work,jrow,jcol);
+    }
+  }
+  
+  // Construct sparsity pattern
+  CRSSparsity ret = sp_triplet(output(oind).size(), input(iind).size(), use_fwd ? jrow : jcol, use_fwd ? jcol : jrow);
+  
+  // Return sparsity pattern
+  if(verbose()){
+    std::cout << "Formed Jacobian sparsity pattern (dimension " << ret.shape() << ", " << 100*double(ret.size())/ret.numel() << " \% nonzeros)." << endl;
+  }
+  return ret;
+}
+
+void FXInternal::spJacSweep(bool use_fwd, int nw, int iind, int oind, int offset, int ndir_local, std::vector<bvec_t>& seed, std::vector<bvec_t>& sens, std::vector<bvec_t>& work, std::vector<int>& jrow, std::vector<int>& jcol){
+  // Seed direction i sits in bit i%bvec_size of word i/bvec_size
+  for(int i=0; i<ndir_local; ++i){
+    seed[(offset+i)*nw + i/bvec_size] |= bvec_t(1)<<(i%bvec_size);
+  }
+  
+  // Propagate the dependencies
+  fill(sens.begin(),sens.end(),bvec_t(0));
+  spEvaluateBlock(use_fwd,nw,iind,oind,getPtr(seed),getPtr(sens),work);
+  
+  // Loop over the nonzeros of the sensitivities
+  int nz_sens = sens.size()/nw;
+  for(int el=0; el<nz_sens; ++el){
+    for(int w=0; w<nw; ++w){
+      bvec_t spsens = sens[el*nw + w];
+      
+      // If there is a dependency in any of the directions of the word
+      if(0!=spsens){
+        for(int i=0; i<bvec_size; ++i){
+          if((bvec_t(1) << i) & spsens){
+            // Add to pattern
+            jrow.push_back(el);
+            jcol.push_back(offset + w*bvec_size + i);
+          }
+        }
+      }
+    }
+  }
+  
+  // Remove the seeds
+  for(int i=0; i<ndir_local; ++i){
+    seed[(offset+i)*nw + i/bvec_size] = 0;
+  }
+}
+
 void FXInternal::setJacSparsity(const CRSSparsity& sp, int iind, int oind, bool compact){
   if(compact){
     jac_sparsity_compact_[iind][oind] = sp;
@@ -460,8 +666,37 @@ CRSSparsity& FXInternal::jacSparsity(int iind, int oind, bool compact){
   if(jsp.isNull()){
     if(compact){
       if(spgen_==0){
-        // Use internal routine to determine sparsity
-        jsp = getJacSparsity(iind,oind);
+        // Look in the persistent cache
+        string key;
+        vector<CRSSparsity> cached;
+        if(sp_cache_.enabled() && !structureKey().empty()){
+          StructureHash h;
+          h.add(string("jacSparsity"));
+          h.add(structureKey());
+          h.add(iind);
+          h.add(oind);
+          const DMatrix &in = input(iind), &out = output(oind);
+          int dims[] = {out.size1(), out.size2(), out.size(), in.size1(), in.size2(), in.size()};
+          key = h.digest(vector<int>(dims,dims+6));
+          
+          // An entry with the wrong dimensions is a miss
+          if(sp_cache_.load(key,cached) && cached.size()==1 && !cached.front().isNull() &&
+             cached.front().size1()==output(oind).size() && cached.front().size2()==input(iind).size()){
+            log("FXInternal::jacSparsity found in cache");
+            jsp = cached.front();
+            stats_["sparsity_cache_hits"] = int(stats_["sparsity_cache_hits"])+1;
+          }
+        }
+        
+        if(jsp.isNull()){
+          // Use internal routine to determine sparsity
+          jsp = getJacSparsity(iind,oind);
+          
+          // Save to the persistent cache
+          if(!key.empty() && !jsp.isNull()){
+            sp_cache_.save(key,vector<CRSSparsity>(1,jsp));
+          }
+        }
       } else {
         // Create a temporary FX instance
         FX tmp;
@@ -530,19 +765,63 @@ void FXInternal::getPartition(int iind, int oind, CRSSparsity& D1, CRSSparsity&
     casadi_error("FXInternal::jac: Unknown ad_mode \"" << getOption("ad_mode") << "\". Possible values are \"forward\", \"reverse\" and \"automatic\".");
   }
   
+  // Vertex ordering and number of recoloring passes
+  int ordering;
+  if(getOption("coloring_ordering")=="natural"){
+    ordering = 0;
+  } else if(getOption("coloring_ordering")=="largest_first"){
+    ordering = 1;
+  } else if(getOption("coloring_ordering")=="smallest_last"){
+    ordering = 2;
+  } else if(getOption("coloring_ordering")=="incidence_degree"){
+    ordering = 3;
+  } else {
+    casadi_error("FXInternal::getPartition: Unknown coloring_ordering \"" << getOption("coloring_ordering") << "\".");
+  }
+  int recolor = getOption("coloring_recolor");
+  
+  // Look in the persistent cache, the partition only depends on the pattern and the options used
+  string key;
+  if(sp_cache_.enabled()){
+    StructureHash h;
+    h.add(string("getPartition"));
+    h.add(A);
+    h.add(int(symmetric));
+    h.add(int(test_ad_fwd) + 2*int(test_ad_adj));
+    h.add(ordering);
+    h.add(recolor);
+    int dims[] = {A.size1(), A.size2(), A.size()};
+    key = h.digest(vector<int>(dims,dims+3));
+    
+    // An entry with seed matrices that do not match the dimensions of A is a miss
+    vector<CRSSparsity> cached;
+    bool hit = sp_cache_.load(key,cached) && cached.size()==2 && !(cached[0].isNull() && cached[1].isNull());
+    hit = hit && (cached[0].isNull() || cached[0].size2()==A.size2());
+    hit = hit && (cached[1].isNull() || cached[1].size2()==A.size1());
+    if(hit){
+      log("FXInternal::getPartition found in cache");
+      D1 = cached[0];
+      D2 = cached[1];
+      stats_["sparsity_cache_hits"] = int(stats_["sparsity_cache_hits"])+1;
+      stats_["partition_fwd_dirs"] = D1.isNull() ? 0 : D1.size1();
+      stats_["partition_adj_dirs"] = D2.isNull() ? 0 : D2.size1();
+      return;
+    }
+  }
+  
   // Get seed matrices by graph coloring
   if(symmetric){
   
     // Star coloring if symmetric
     log("FXInternal::getPartition starColoring");
-    D1 = A.starColoring();
+    D1 = A.starColoring(ordering,recolor);
     
   } else {
     
     // Test unidirectional coloring using forward mode
     if(test_ad_fwd){
       log("FXInternal::getPartition unidirectional coloring (forward mode)");
-      D1 = AT.unidirectionalColoring(A);
+      D1 = AT.unidirectionalColoring(A,ordering,recolor,sp_parallel_);
       if(verbose()){
         cout << "Forward mode coloring completed: " << D1.size1() << " directional derivatives needed (" << A.size2() << " without coloring)." << endl;
       }
@@ -551,7 +830,7 @@ void FXInternal::getPartition(int iind, int oind, CRSSparsity& D1, CRSSparsity&
     // Test unidirectional coloring using reverse mode
     if(test_ad_adj){
       log("FXInternal::getPartition unidirectional coloring (adjoint mode)");
-      D2 = A.unidirectionalColoring(AT);
+      D2 = A.unidirectionalColoring(AT,ordering,recolor,sp_parallel_);
       if(verbose()){
         cout << "Adjoint mode coloring completed: " << D2.size1() << " directional derivatives needed (" << A.size1() << " without coloring)." << endl;
       }
@@ -560,9 +839,26 @@ void FXInternal::getPartition(int iind, int oind, CRSSparsity& D1, CRSSparsity&
     // Adjoint mode penalty factor (adjoint mode is usually more expensive to calculate)
     int adj_penalty = 2;
 
-    // Use whatever required less colors if we tried both (with preference to forward mode)
+    // Test bidirectional coloring: dense rows in adjoint mode, the rest in forward mode
+    CRSSparsity D1_bi, D2_bi;
+    int bi_cost = -1;
     if(test_ad_fwd && test_ad_adj){
-      if((D1.size1() <= adj_penalty*D2.size1())){
+      log("FXInternal::getPartition bidirectional coloring");
+      bi_cost = A.bidirectionalColoring(D1_bi,D2_bi,adj_penalty,AT,ordering,recolor,sp_parallel_);
+      if(verbose() && bi_cost>=0){
+        cout << "Bidirectional coloring completed: " << D1_bi.size1() << " forward and " << D2_bi.size1() << " adjoint directional derivatives needed." << endl;
+      }
+    }
+
+    // Use whatever is cheapest if we tried several (with preference to forward mode, then adjoint mode)
+    if(test_ad_fwd && test_ad_adj){
+      int fwd_cost = D1.size1();
+      int adj_cost = adj_penalty*D2.size1();
+      if(bi_cost>=0 && bi_cost<fwd_cost && bi_cost<adj_cost){
+        D1 = D1_bi;
+        D2 = D2_bi;
+        log("Bidirectional mode chosen");
+      } else if(fwd_cost <= adj_cost){
         D2=CRSSparsity();
         log("Forward mode chosen");
       } else {
@@ -572,6 +868,27 @@ void FXInternal::getPartition(int iind, int oind, CRSSparsity& D1, CRSSparsity&
     }
     log("FXInternal::getPartition end");
   }
+  
+  // Number of forward and adjoint directions of the partition last calculated
+  stats_["partition_fwd_dirs"] = D1.isNull() ? 0 : D1.size1();
+  stats_["partition_adj_dirs"] = D2.isNull() ? 0 : D2.size1();
+  
+  // Save to the persistent cache
+  if(!key.empty()){
+    vector<CRSSparsity> partition(2);
+    partition[0] = D1;
+    partition[1] = D2;
+    sp_cache_.save(key,partition);
+  }
+}
+
+const std::string& FXInternal::structureKey(){
+  if(!structure_key_computed_){
+    StructureHash h;
+    structure_key_ = hashStructure(h) ? h.digest() : "";
+    structure_key_computed_ = true;
+  }
+  return structure_key_;
 }
 
 void FXInternal::evalSX(const std::vector<SXMatrix>& arg, std::vector<SXMatrix>& res, 
@@ -634,6 +951,10 @@ void FXInternal::spEvaluate(bool fwd){
   }
 }
 
+void FXInternal::spEvaluateBlock(bool fwd, int nw, int iind, int oind, const bvec_t* seed, bvec_t* sens, std::vector<bvec_t>& work){
+  casadi_error("FXInternal::spEvaluateBlock not defined for class " << typeid(*this).name());
+}
+
 FX FXInternal::jacobian(int iind, int oind, bool compact, bool symmetric){
   // Return value
   FX ret;
@@ -24,6 +24,7 @@
 #define FX_INTERNAL_HPP
 
 #include "fx.hpp"
+#include "sparsity_cache.hpp"
 #include <set>
 
 // This macro is for documentation purposes
@@ -53,6 +54,9 @@ class FXInternal : public OptionsFunctionalityNode{
     /** \brief  Evaluate */
     virtual void evaluate(int nfdir, int nadir) = 0;
 
+    /** \brief  Evaluate only the outputs with index in oind (no derivatives), by default all outputs are evaluated */
+    virtual void evaluateOutputs(const std::vector<int>& oind){ evaluate(0,0);}
+
     /** \brief Initialize
       Initialize and make the object ready for setting arguments and evaluation. This method is typically called after setting options but before evaluating. 
       If passed to another class (in the constructor), this class should invoke this function when initialized. */
@@ -74,6 +78,19 @@ class FXInternal : public OptionsFunctionalityNode{
     /** \brief  Reset the sparsity propagation */
     virtual void spInit(bool fwd){}
     
+    /** \brief  Propagate the sparsity pattern with nw words (nw*bvec_size directions) per nonzero, forward from input iind to output oind or backward from output oind to input iind.
+        The seeds and sensitivities are stored word by word for each nonzero, all other inputs and outputs are treated as not depending on anything.
+        The work vector is resized by the function, calls with different work vectors may run in parallel */
+    virtual void spEvaluateBlock(bool fwd, int nw, int iind, int oind, const bvec_t* seed, bvec_t* sens, std::vector<bvec_t>& work);
+
+    /** \brief  Is the class able to propagate several words per nonzero at once? */
+    virtual bool spCanEvaluateBlock(bool fwd){ return false;}
+    
+    /** \brief  Add everything that the Jacobian sparsity depends on to a hash, returns false if not possible
+        The hash is used as a key for the persistent sparsity cache and must be the same for identical
+        functions created in different processes */
+    virtual bool hashStructure(StructureHash& h){ return false;}
+    
     /** \brief  Evaluate symbolically, SX type */
     virtual void evalSX(const std::vector<SXMatrix>& arg, std::vector<SXMatrix>& res, 
                         const std::vector<std::vector<SXMatrix> >& fseed, std::vector<std::vector<SXMatrix> >& fsens, 
@@ -166,6 +183,9 @@ class FXInternal : public OptionsFunctionalityNode{
     /** \brief  Print */
     virtual void repr(std::ostream &stream) const;
     
+    /** \brief  Generate the C code declaring the dimensions and sparsity patterns of the inputs and outputs */
+    void generateInterface(std::ostream &cfile) const;
+    
     /** \brief Find the index for a string describing a particular entry of an input scheme
     * example:  schemeEntry("x_opt")  -> returns  NLP_X_OPT if FXInternal adheres to SCHEME_NLPINput 
     */
@@ -187,7 +207,9 @@ class FXInternal : public OptionsFunctionalityNode{
     /** \brief  Output of the function */
     std::vector<FunctionIO> output_;
 
-    /** \brief Get the unidirectional or bidirectional partition */
+    /** \brief Get the unidirectional or bidirectional partition
+        If both D1 and D2 are non-null, the Jacobian entries in the rows seeded by D2 are to be
+        taken from the adjoint sweeps and all other entries from the forward sweeps */
     void getPartition(int iind, int oind, CRSSparsity& D1, CRSSparsity& D2, bool compact, bool symmetric);
 
     /// Verbose mode?
@@ -325,12 +347,21 @@ class FXInternal : public OptionsFunctionalityNode{
     /// Generate the sparsity of a Jacobian block
     virtual CRSSparsity getJacSparsity(int iind, int oind);
     
+    /// Generate the sparsity of a Jacobian block with spEvaluateBlock, nw words per nonzero
+    CRSSparsity getJacSparsityBlock(int iind, int oind, bool use_fwd, int nw);
+    
+    /// Sweep of getJacSparsityBlock for the seed directions offset to offset+ndir_local-1, the pattern found is appended to jrow and jcol
+    void spJacSweep(bool use_fwd, int nw, int iind, int oind, int offset, int ndir_local, std::vector<bvec_t>& seed, std::vector<bvec_t>& sens, std::vector<bvec_t>& work, std::vector<int>& jrow, std::vector<int>& jcol);
+    
     /// Generate the sparsity of a Jacobian block
     void setJacSparsity(const CRSSparsity& sp, int iind, int oind, bool compact);
     
     /// Get, if necessary generate, the sparsity of a Jacobian block
     CRSSparsity& jacSparsity(int iind, int oind, bool compact);
     
+    /// Key of the function in the persistent sparsity cache, empty if the function cannot be hashed
+    const std::string& structureKey();
+    
     /// Get a vector of symbolic variables with the same dimensions as the inputs
     virtual std::vector<MX> symbolicInput() const;
   
@@ -381,6 +412,16 @@ class FXInternal : public OptionsFunctionalityNode{
     /// Errors are thrown when NaN is produced
     bool regularity_check_;
     
+    /// Distribute the sweeps of the Jacobian sparsity calculation over threads
+    bool sp_parallel_;
+    
+    /// Persistent cache of Jacobian sparsity patterns and partitions
+    SparsityCache sp_cache_;
+    
+    /// Key of the function in the sparsity cache (a digest of its structure), computed on first use
+    std::string structure_key_;
+    bool structure_key_computed_;
+    
 };
 
 
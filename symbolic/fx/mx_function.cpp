@@ -24,10 +24,12 @@
 #include "../mx/mx_node.hpp"
 #include "../stl_vector_tools.hpp"
 #include "../mx/mx_tools.hpp"
+#include "serializer.hpp"
 
 #include <stack>
 #include <typeinfo>
 #include <cassert>
+#include <fstream>
 
 using namespace std;
 
@@ -119,6 +121,24 @@ SXFunction MXFunction::expand(const std::vector<SXMatrix>& inputv){
   return (*this)->expand(inputv);
 }
 
+void MXFunction::generateCode(const std::string& filename){
+  (*this)->generateCode(filename);
+}
+
+void MXFunction::save(const std::string& filename) const{
+  assertInit();
+  ofstream f(filename.c_str(),ios::binary);
+  casadi_assert_message(f.good(),"MXFunction::save: cannot open \"" << filename << "\" for writing");
+  Serializer s(f);
+  (*this)->save(s);
+}
+
+MXFunction MXFunction::load(const std::string& filename){
+  MappedFile f(filename);
+  Deserializer d(f.data(),f.size());
+  return MXFunctionInternal::load(d);
+}
+
 std::vector<MX> MXFunction::getFree() const{
   return (*this)->free_vars_;
 }
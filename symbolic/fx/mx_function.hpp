@@ -135,6 +135,24 @@ public:
   /** \brief Expand the matrix valued graph into a scalar valued graph */
   SXFunction expand(const std::vector<SXMatrix>& inputv = std::vector<SXMatrix>());
   
+  /** \brief Export / Generate C code for the function
+   * The file has the same entry points for the evaluation and the sparsity patterns as the code generated
+   * by SXFunction. Embedded SXFunction and MXFunction calls are generated as separate functions in the same file.
+   * The work vector is stored in local arrays, so the generated code is reentrant. The linear systems of Solve nodes
+   * are solved by a dense LU factorization, evaluate returns 1 if a matrix is singular.
+   */
+  void generateCode(const std::string& filename);
+  
+  /** \brief Save the (initialized) function to a binary file
+   * Embedded calls to SXFunction and MXFunction instances are saved with the function, once for each function
+   * called, other embedded functions (e.g. linear solvers and integrators) are not supported. Embedded SXFunction
+   * instances are loaded without their expression graph, see SXFunction::load.
+   */
+  void save(const std::string& filename) const;
+  
+  /** \brief Load an initialized function from a file written by save */
+  static MXFunction load(const std::string& filename);
+  
   /** \brief Get all the free variables of the function */
   std::vector<MX> getFree() const;
   
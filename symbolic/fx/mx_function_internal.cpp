@@ -23,6 +23,14 @@
 #include "mx_function_internal.hpp"
 #include "../mx/evaluation_mx.hpp"
 #include "../mx/mapping.hpp"
+#include "../mx/unary_mx.hpp"
+#include "../mx/binary_mx.hpp"
+#include "../mx/constant_mx.hpp"
+#include "../mx/multiplication.hpp"
+#include "../mx/densification.hpp"
+#include "../mx/norm.hpp"
+#include "sx_function_internal.hpp"
+#include "serializer.hpp"
 #include "../mx/mx_tools.hpp"
 #include "../sx/sx_tools.hpp"
 
@@ -30,7 +38,10 @@
 #include "../casadi_types.hpp"
 
 #include <stack>
+#include <map>
 #include <typeinfo>
+#include <fstream>
+#include <sstream>
 
 // To reuse variables we need to be able to sort by sparsity pattern (preferably using a hash map)
 #ifdef USE_CXX11
@@ -43,13 +54,49 @@
 #define SPARSITY_MAP std::map
 #endif // USE_CXX11
 
+#ifdef WITH_THREADSAFE_SYMBOLICS
+#include <mutex>
+#endif // WITH_THREADSAFE_SYMBOLICS
+
 using namespace std;
 
 namespace CasADi{
 
+#ifdef WITH_THREADSAFE_SYMBOLICS
+// Serializes the use of the temporary markers of the nodes, since the same nodes may be part of graphs initialized in several threads
+static std::mutex sort_mutex_;
+#endif // WITH_THREADSAFE_SYMBOLICS
+
+// Groups sparsity patterns that are structurally equal, represented by the first pattern encountered
+class SparsityClasses{
+  public:
+    const void* get(const CRSSparsity& sp){
+      const void* p = sp.get();
+      SPARSITY_MAP<const void*,const void*>::const_iterator it = rep_.find(p);
+      if(it!=rep_.end()) return it->second;
+      
+      // Compare with the patterns of the same dimensions and number of nonzeros
+      vector<CRSSparsity>& cand = by_size_[make_pair(make_pair(sp.size1(),sp.size2()),sp.size())];
+      const void* r = p;
+      for(vector<CRSSparsity>::const_iterator c=cand.begin(); c!=cand.end(); ++c){
+        if(*c==sp){
+          r = c->get();
+          break;
+        }
+      }
+      if(r==p) cand.push_back(sp);
+      rep_[p] = r;
+      return r;
+    }
+  private:
+    SPARSITY_MAP<const void*,const void*> rep_;
+    map<pair<pair<int,int>,int>,vector<CRSSparsity> > by_size_;
+};
+
 MXFunctionInternal::MXFunctionInternal(const std::vector<MX>& inputv, const std::vector<MX>& outputv) :
   XFunctionInternal<MXFunction,MXFunctionInternal,MX,MXNode>(inputv,outputv) {
   
+  addOption("optimize_mappings",OT_BOOLEAN,true,"Use the argument of identity mappings directly instead of copying it and remove mappings that are no longer used");
   setOption("name", "unnamed_mx_function");
   setOption("numeric_jacobian", true);
   setOption("numeric_hessian", true);
@@ -120,14 +167,19 @@ MXFunctionInternal::MXFunctionInternal(const std::vector<MX>& inputv, const std:
   
   // Check for duplicate entries among the input expressions
   bool has_duplicates = false;
-  for(vector<MX>::iterator it = inputv_.begin(); it != inputv_.end(); ++it){
-    has_duplicates = has_duplicates || it->getTemp()!=0;
-    it->setTemp(1);
-  }
-  
-  // Reset temporaries
-  for(vector<MX>::iterator it = inputv_.begin(); it != inputv_.end(); ++it){
-    it->setTemp(0);
+  {
+#ifdef WITH_THREADSAFE_SYMBOLICS
+    std::lock_guard<std::mutex> sort_lock(sort_mutex_);
+#endif // WITH_THREADSAFE_SYMBOLICS
+    for(vector<MX>::iterator it = inputv_.begin(); it != inputv_.end(); ++it){
+      has_duplicates = has_duplicates || it->getTemp()!=0;
+      it->setTemp(1);
+    }
+    
+    // Reset temporaries
+    for(vector<MX>::iterator it = inputv_.begin(); it != inputv_.end(); ++it){
+      it->setTemp(0);
+    }
   }
   casadi_assert_message(!has_duplicates, "The input expressions are not independent.");
   
@@ -146,6 +198,11 @@ void MXFunctionInternal::init(){
   // Call the init function of the base class
   XFunctionInternal<MXFunction,MXFunctionInternal,MX,MXNode>::init();    
 
+#ifdef WITH_THREADSAFE_SYMBOLICS
+  // The temporary markers of the nodes are used until the free variables have been located
+  std::unique_lock<std::mutex> sort_lock(sort_mutex_);
+#endif // WITH_THREADSAFE_SYMBOLICS
+
   // Stack used to sort the computational graph
   stack<MXNode*> s;
 
@@ -184,15 +241,19 @@ void MXFunctionInternal::init(){
   // Use live variables?
   bool live_variables = getOption("live_variables");
   
+  // The intermediate values must be kept between incremental evaluations
+  incremental_ = getOption("incremental");
+  if(incremental_ && live_variables){
+    if(verbose()) cout << "MXFunctionInternal::init: live variables disabled for incremental evaluation" << endl;
+    live_variables = false;
+  }
+  
   // Input instructions
   vector<pair<int,MXNode*> > symb_loc;
 
   // Current output and nonzero, start with the first one
   int curr_oind=0;
 
-  // Count the number of times each node is used
-  vector<int> refcount(nodes.size(),0);
-
   // Get the sequence of instructions for the virtual machine
   algorithm_.resize(0);
   algorithm_.reserve(nodes.size());
@@ -233,13 +294,6 @@ void MXFunctionInternal::init(){
         }
       }
       
-      // Increase the reference count of the dependencies
-      for(int c=0; c<ae.arg.size(); ++c){
-        if(ae.arg[c]>=0){
-          refcount[ae.arg[c]]++;
-        }
-      }
-       
       // Save to algorithm
       place_in_alg.push_back(algorithm_.size());
       algorithm_.push_back(ae);
@@ -264,6 +318,23 @@ void MXFunctionInternal::init(){
     }
   }
 
+  // Compose chains of mappings and avoid copying for identity mappings
+  if(getOption("optimize_mappings")){
+    vector<int> new_ind;
+    optimizeMappings(nodes.size(),new_ind);
+    for(vector<pair<int,MXNode*> >::iterator it=symb_loc.begin(); it!=symb_loc.end(); ++it){
+      it->first = new_ind[it->first];
+    }
+  }
+  
+  // Count the number of times each node is used
+  vector<int> refcount(nodes.size(),0);
+  for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+    for(vector<int>::const_iterator c=it->arg.begin(); c!=it->arg.end(); ++c){
+      if(*c>=0) refcount[*c]++;
+    }
+  }
+
   // Place in the work vector for each of the nodes in the tree (overwrites the reference counter)
   vector<int>& place = place_in_alg; // Reuse memory as it is no longer needed
   place.resize(nodes.size());
@@ -271,6 +342,9 @@ void MXFunctionInternal::init(){
   // Stack with unused elements in the work vector, sorted by sparsity pattern
   SPARSITY_MAP<const void*,stack<int> > unused_all;
   
+  // Structurally equal patterns that are different objects share the same stack
+  SparsityClasses sp_classes;
+  
   // Work vector size
   int worksize = 0;
   
@@ -285,8 +359,8 @@ void MXFunctionInternal::init(){
           
           // Are reuse of variables (live variables) enabled?
           if(live_variables){
-            // Get a pointer to the sparsity pattern node
-            const void* sp = it->data->sparsity(c).get();
+            // Get a pointer to the representative of the sparsity pattern
+            const void* sp = sp_classes.get(it->data->sparsity(c));
             
             // Get a reference to the stack for the current sparsity
             stack<int>& unused = unused_all[sp];
@@ -318,8 +392,8 @@ void MXFunctionInternal::init(){
         // Free variable for reuse
         if(live_variables && remaining==0){
           
-          // Get a pointer to the sparsity pattern of the argument that can be freed
-          const void* sp = nodes[ch_ind]->sparsity().get();
+          // Get a pointer to the representative of the sparsity pattern of the argument that can be freed
+          const void* sp = sp_classes.get(nodes[ch_ind]->sparsity());
           
           // Add to the stack of unused work vector elements for the current sparsity
           unused_all[sp].push(place[ch_ind]);
@@ -391,10 +465,17 @@ void MXFunctionInternal::init(){
       it->second->temp=0;
     }
   }
+#ifdef WITH_THREADSAFE_SYMBOLICS
+  sort_lock.unlock();
+#endif // WITH_THREADSAFE_SYMBOLICS
   
   // Allocate tape
   allocTape();
   
+  // Find the operations that depend on each input
+  inc_valid_ = false;
+  if(incremental_) initIncremental();
+  output_slices_.clear();
   
   // Allocate memory for directional derivatives
   MXFunctionInternal::updateNumSens(false);
@@ -411,6 +492,32 @@ void MXFunctionInternal::updateNumSens(bool recursive){
     it->dataF.resize(nfdir_,it->data);
     it->dataA.resize(nadir_,it->data);
   }
+  
+  // Size of the working set, compared to the size with a separate element of the work vector for each node
+  int nbuf_unshared=0, nnz_unshared=0;
+  for(vector<AlgEl>::iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+    if(it->op==OP_OUTPUT) continue;
+    for(int c=0; c<it->res.size(); ++c){
+      if(it->res[c]>=0){
+        nbuf_unshared++;
+        nnz_unshared += it->data->sparsity(c).size();
+      }
+    }
+  }
+  int nnz=0, nnz_tape=0;
+  for(vector<FunctionIO>::const_iterator it=work_.begin(); it!=work_.end(); ++it){
+    nnz += it->data.size();
+  }
+  for(vector<pair<pair<int,int>,DMatrix> >::const_iterator it=tape_.begin(); it!=tape_.end(); ++it){
+    nnz_tape += it->second.size();
+  }
+  int ndir = 1 + nfdir_ + nadir_;
+  stats_["work_buffers_unshared"] = nbuf_unshared;
+  stats_["work_buffers"] = int(work_.size());
+  stats_["work_nnz_unshared"] = nnz_unshared;
+  stats_["work_nnz"] = nnz;
+  stats_["peak_work_memory_unshared"] = double(nnz_unshared)*ndir*sizeof(double);
+  stats_["peak_work_memory"] = (double(nnz)*ndir + nnz_tape)*sizeof(double);
 }
 
 void MXFunctionInternal::setLiftingFunction(LiftingFunction liftfun, void* user_data){
@@ -471,6 +578,17 @@ void MXFunctionInternal::evaluate(int nfdir, int nadir){
     casadi_error("Cannot evaluate \"" << ss.str() << "\" since variables " << free_vars_ << " are free.");
   }
   
+  // Re-execute only the operations affected by the inputs that changed, the first time everything is evaluated
+  if(incremental_ && nfdir==0 && nadir==0){
+    if(incrementalOps(inc_buf_)){
+      evaluateOps(inc_buf_);
+      log("MXFunctionInternal::evaluate end");
+      return;
+    }
+  } else {
+    inc_valid_ = false;
+  }
+  
   // Tape iterator
   vector<pair<pair<int,int>,DMatrix> >::iterator tape_it = tape_.begin();
   
@@ -507,7 +625,7 @@ void MXFunctionInternal::evaluate(int nfdir, int nadir){
       updatePointers(*it,nfdir,0);
 
       // Evaluate
-      it->data->evaluateD(mx_input_, mx_output_, mx_fwdSeed_, mx_fwdSens_, mx_adjSeed_, mx_adjSens_);
+      it->data->evaluateD(mx_input_, mx_output_, mx_fwdSeed_, mx_fwdSens_, mx_adjSeed_, mx_adjSens_, itmp_, rtmp_);
   
       // Lifting
       if(liftfun_ && it->data->isNonLinear()){
@@ -555,7 +673,7 @@ void MXFunctionInternal::evaluate(int nfdir, int nadir){
         updatePointers(*it,0,nadir);
         
         // Evaluate
-        it->data->evaluateD(mx_input_, mx_output_, mx_fwdSeed_, mx_fwdSens_, mx_adjSeed_, mx_adjSens_);
+        it->data->evaluateD(mx_input_, mx_output_, mx_fwdSeed_, mx_fwdSens_, mx_adjSeed_, mx_adjSens_, itmp_, rtmp_);
       }
       
       if(it->op!=OP_OUTPUT){
@@ -584,6 +702,196 @@ void MXFunctionInternal::evaluate(int nfdir, int nadir){
   log("MXFunctionInternal::evaluate end");
 }
 
+// Number of nonzeros copied when evaluating a mapping
+static int mappingCopies(const Mapping* m){
+  int ret = 0;
+  for(vector<Mapping::IOMap>::const_iterator it=m->index_output_sorted_[0].begin(); it!=m->index_output_sorted_[0].end(); ++it){
+    ret += it->size();
+  }
+  return ret;
+}
+
+void MXFunctionInternal::optimizeMappings(int nnodes, std::vector<int>& new_ind){
+  // Node to be used in place of each node
+  vector<int> alias(nnodes);
+  for(int i=0; i<nnodes; ++i) alias[i] = i;
+  
+  // Statistics
+  int nmap_before=0, nmap_after=0, ncopies_before=0, ncopies_after=0, nidentity=0;
+  
+  // Elements to be removed
+  vector<bool> removed(algorithm_.size(),false);
+  
+  for(int k=0; k<algorithm_.size(); ++k){
+    AlgEl& e = algorithm_[k];
+    
+    // Use the argument of eliminated identity mappings
+    for(vector<int>::iterator c=e.arg.begin(); c!=e.arg.end(); ++c){
+      if(*c>=0) *c = alias[*c];
+    }
+    
+    if(e.op==OP_MAPPING){
+      const Mapping* m = static_cast<const Mapping*>(e.data.get());
+      nmap_before++;
+      ncopies_before += mappingCopies(m);
+      
+      // Forward the argument of an identity mapping instead of copying it, chains of mappings need no treatment
+      // since Mapping::assign composes a mapping with the mappings of its dependencies when it is created
+      if(m->isIdentity() && e.arg[0]>=0){
+        alias[e.res[0]] = e.arg[0];
+        removed[k] = true;
+        nidentity++;
+      }
+    }
+  }
+  
+  // Count the number of times each node is used
+  vector<int> refcount(nnodes,0);
+  for(int k=0; k<algorithm_.size(); ++k){
+    if(removed[k]) continue;
+    for(vector<int>::const_iterator c=algorithm_[k].arg.begin(); c!=algorithm_[k].arg.end(); ++c){
+      if(*c>=0) refcount[*c]++;
+    }
+  }
+  
+  // Remove mappings that are no longer used (backwards, so that unused chains are removed entirely)
+  int nunused = 0;
+  for(int k=algorithm_.size()-1; k>=0; --k){
+    AlgEl& e = algorithm_[k];
+    if(removed[k] || e.op!=OP_MAPPING || refcount[e.res[0]]>0) continue;
+    removed[k] = true;
+    nunused++;
+    for(vector<int>::const_iterator c=e.arg.begin(); c!=e.arg.end(); ++c){
+      if(*c>=0) refcount[*c]--;
+    }
+  }
+  
+  // Remove the elements
+  new_ind.resize(algorithm_.size());
+  int n = 0;
+  for(int k=0; k<algorithm_.size(); ++k){
+    if(removed[k]){
+      new_ind[k] = -1;
+    } else {
+      new_ind[k] = n;
+      if(algorithm_[k].op==OP_MAPPING){
+        nmap_after++;
+        ncopies_after += mappingCopies(static_cast<const Mapping*>(algorithm_[k].data.get()));
+      }
+      if(n!=k) algorithm_[n] = algorithm_[k];
+      n++;
+    }
+  }
+  algorithm_.resize(n);
+  
+  if(verbose()){
+    cout << "MXFunctionInternal::optimizeMappings: " << nidentity << " identity and " << nunused << " unused mappings removed" << endl;
+  }
+  
+  // Copies per evaluation, without derivatives
+  stats_["mapping_nodes_unoptimized"] = nmap_before;
+  stats_["mapping_nodes"] = nmap_after;
+  stats_["mapping_bytes_copied_unoptimized"] = double(ncopies_before)*sizeof(double);
+  stats_["mapping_bytes_copied"] = double(ncopies_after)*sizeof(double);
+}
+
+void MXFunctionInternal::initIncremental(){
+  // Inputs that each element of the work vector depends on, one bit per input
+  const int nw = (getNumInputs()+bvec_size-1)/bvec_size;
+  vector<bvec_t> wdep(work_.size()*nw,0), dep(nw);
+  inc_ops_.assign(getNumInputs(),vector<int>());
+  for(int k=0; k<algorithm_.size(); ++k){
+    const AlgEl& e = algorithm_[k];
+    fill(dep.begin(),dep.end(),bvec_t(0));
+    if(e.op==OP_INPUT){
+      dep[e.arg[0]/bvec_size] = bvec_t(1) << (e.arg[0]%bvec_size);
+    } else if(e.op!=OP_PARAMETER){
+      for(vector<int>::const_iterator c=e.arg.begin(); c!=e.arg.end(); ++c){
+        if(*c<0) continue;
+        for(int i=0; i<nw; ++i) dep[i] |= wdep[*c*nw+i];
+      }
+    }
+    if(e.op!=OP_OUTPUT){
+      for(vector<int>::const_iterator c=e.res.begin(); c!=e.res.end(); ++c){
+        if(*c>=0) copy(dep.begin(),dep.end(),wdep.begin()+*c*nw);
+      }
+    }
+    
+    // Add to the list of each input the operation depends on
+    for(int i=0; i<nw; ++i){
+      bvec_t b = dep[i];
+      for(int ind=i*bvec_size; b!=0; ++ind, b>>=1){
+        if(b & 1) inc_ops_[ind].push_back(k);
+      }
+    }
+  }
+}
+
+void MXFunctionInternal::evaluateOps(const std::vector<int>& ops){
+  if (!free_vars_.empty()) {
+    std::stringstream ss;
+    repr(ss);
+    casadi_error("Cannot evaluate \"" << ss.str() << "\" since variables " << free_vars_ << " are free.");
+  }
+  
+  for(vector<int>::const_iterator k=ops.begin(); k!=ops.end(); ++k){
+    AlgEl& e = algorithm_[*k];
+    if(e.op==OP_INPUT){
+      work_[e.res.front()].data.set(input(e.arg.front()));
+    } else if(e.op==OP_OUTPUT){
+      work_[e.arg.front()].data.get(output(e.res.front()));
+    } else if(e.op!=OP_PARAMETER){
+      updatePointers(e,0,0);
+      e.data->evaluateD(mx_input_, mx_output_, mx_fwdSeed_, mx_fwdSens_, mx_adjSeed_, mx_adjSens_, itmp_, rtmp_);
+      
+      // Lifting
+      if(liftfun_ && e.data->isNonLinear()){
+        for(int i=0; i<e.res.size(); ++i){
+          liftfun_(&mx_output_[i]->front(),mx_output_[i]->size(),liftfun_ud_);
+        }
+      }
+    }
+  }
+}
+
+bool MXFunctionInternal::sliceWorthwhile(const std::vector<int>& ops) const{
+  // Skip at least a quarter of the operations
+  return 4*ops.size() <= 3*algorithm_.size();
+}
+
+std::vector<int> MXFunctionInternal::outputSlice(const std::vector<int>& oind) const{
+  vector<bool> requested(getNumOutputs(),false);
+  for(vector<int>::const_iterator it=oind.begin(); it!=oind.end(); ++it) requested[*it] = true;
+  
+  // Backward sweep marking the elements of the work vector needed, an element is no longer needed before the operation assigning it
+  vector<bool> needed(work_.size(),false);
+  vector<int> ret;
+  for(int k=algorithm_.size()-1; k>=0; --k){
+    const AlgEl& e = algorithm_[k];
+    if(e.op==OP_OUTPUT){
+      if(!requested[e.res.front()]) continue;
+      needed[e.arg.front()] = true;
+    } else {
+      bool used = false;
+      for(vector<int>::const_iterator c=e.res.begin(); c!=e.res.end(); ++c){
+        if(*c>=0 && needed[*c]){
+          used = true;
+          needed[*c] = false;
+        }
+      }
+      if(!used) continue;
+      if(e.op!=OP_INPUT){
+        for(vector<int>::const_iterator c=e.arg.begin(); c!=e.arg.end(); ++c){
+          if(*c>=0) needed[*c] = true;
+        }
+      }
+    }
+    ret.push_back(k);
+  }
+  reverse(ret.begin(),ret.end());
+  return ret;
+}
+
 void MXFunctionInternal::print(ostream &stream) const{
   FXInternal::print(stream);
   for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
@@ -636,7 +944,332 @@ void MXFunctionInternal::deepCopyMembers(std::map<SharedObjectNode*,SharedObject
   }
 }
 
+bool MXFunctionInternal::hashStructure(StructureHash& h){
+  h.add(string("MXFunction"));
+  for(int ind=0; ind<getNumInputs(); ++ind) h.add(inputNoCheck(ind).sparsity());
+  for(int ind=0; ind<getNumOutputs(); ++ind) h.add(outputNoCheck(ind).sparsity());
+
+  h.add(int(algorithm_.size()));
+  for(vector<AlgEl>::iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+    h.add(it->op);
+    h.add(it->arg);
+    h.add(it->res);
+    if(it->op==OP_INPUT || it->op==OP_PARAMETER){
+      h.add(it->data.sparsity());
+    } else if(it->op!=OP_OUTPUT){
+      // Sparsity of the arguments and results, and whatever else the node needs to propagate sparsity
+      MXNode* n = static_cast<MXNode*>(it->data.get());
+      for(int i=0; i<n->ndep(); ++i){
+        h.add(n->dep(i).isNull() ? CRSSparsity() : n->dep(i).sparsity());
+      }
+      for(int i=0; i<n->getNumOutputs(); ++i){
+        h.add(n->sparsity(i));
+      }
+      if(!n->hashStructure(h)) return false;
+    }
+  }
+  return true;
+}
+
+// Node classes of the elementwise operations in the binary format of MXFunction
+enum MXElementwiseClass{MX_UNARY, MX_SCALAR_NONZEROS, MX_NONZEROS_SCALAR, MX_NONZEROS_NONZEROS, MX_SPARSE_SPARSE};
+
+// Write an embedded function, preceded by its type
+static void saveEmbedded(Serializer& s, const FX& fcn){
+  if(const SXFunctionInternal* f = dynamic_cast<const SXFunctionInternal*>(fcn.get())){
+    s.pack(string("SXFunction"));
+    f->save(s);
+  } else if(const MXFunctionInternal* f = dynamic_cast<const MXFunctionInternal*>(fcn.get())){
+    s.pack(string("MXFunction"));
+    f->save(s);
+  } else {
+    casadi_error("MXFunction::save: embedded function \"" << fcn.getOption("name") << "\" cannot be saved, only calls to SXFunction and MXFunction are supported");
+  }
+}
+
+// Read an embedded function written by saveEmbedded, SXFunction instances are only evaluated and are read without their expression graph
+static FX loadEmbedded(Deserializer& d){
+  string type;
+  d.unpack(type);
+  if(type=="SXFunction"){
+    return SXFunctionInternal::load(d,false);
+  } else if(type=="MXFunction"){
+    return MXFunctionInternal::load(d);
+  } else {
+    casadi_error("MXFunction::load: corrupt file, unknown function type \"" << type << "\"");
+  }
+}
+
+void MXFunctionInternal::save(Serializer& s) const{
+  s.packHeader("CASADIMX",1);
+  s.pack(getOption("name").toString());
+  s.pack(getNumInputs());
+  for(int ind=0; ind<getNumInputs(); ++ind){
+    s.pack(inputv_[ind].sparsity());
+    s.pack(inputv_[ind].isSymbolic() ? inputv_[ind].getName() : string());
+  }
+  s.pack(getNumOutputs());
+  
+  // Table of the embedded functions, a function called several times is saved once
+  map<const FXInternal*,int> fcn_index;
+  vector<FX> fcn;
+  for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+    if(it->op==OP_CALL){
+      FX& f = const_cast<MXNode*>(static_cast<const MXNode*>(it->data.get()))->getFunction();
+      if(fcn_index.insert(make_pair(static_cast<const FXInternal*>(f.get()),int(fcn.size()))).second){
+        fcn.push_back(f);
+      }
+    }
+  }
+  s.pack(int(fcn.size()));
+  for(vector<FX>::const_iterator it=fcn.begin(); it!=fcn.end(); ++it){
+    saveEmbedded(s,*it);
+  }
+  
+  s.pack(int(work_.size()));
+  s.pack(int(algorithm_.size()));
+  for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+    s.pack(it->op);
+    s.pack(it->arg);
+    s.pack(it->res);
+    
+    // Whatever is needed to recreate the node, the sparsity of the other nodes follows from their arguments
+    const MXNode* n = static_cast<const MXNode*>(it->data.get());
+    switch(it->op){
+      case OP_INPUT:
+      case OP_OUTPUT:
+      case OP_MATMUL:
+      case OP_DENSIFY:
+      case OP_NORM2:
+      case OP_NORM1:
+      case OP_NORMINF:
+      case OP_NORMF:
+        break;
+      case OP_PARAMETER:
+        s.pack(it->data.getName());
+        s.pack(it->data.sparsity());
+        break;
+      case OP_CONST:
+        s.pack(static_cast<const ConstantMX*>(n)->x_);
+        break;
+      case OP_CALL:
+        s.pack(fcn_index[static_cast<const FXInternal*>(const_cast<MXNode*>(n)->getFunction().get())]);
+        break;
+      case OP_MAPPING:
+      {
+        const Mapping* m = static_cast<const Mapping*>(n);
+        s.pack(m->sparsity());
+        for(vector<vector<Mapping::OutputNZ> >::const_iterator k=m->output_sorted_.begin(); k!=m->output_sorted_.end(); ++k){
+          vector<int> nz;
+          nz.reserve(2*k->size());
+          for(vector<Mapping::OutputNZ>::const_iterator e=k->begin(); e!=k->end(); ++e){
+            nz.push_back(e->inz);
+            nz.push_back(e->iind);
+          }
+          s.pack(nz);
+        }
+        break;
+      }
+      default:
+        if(dynamic_cast<const UnaryMX*>(n)){
+          s.pack(int(MX_UNARY));
+        } else if(dynamic_cast<const ScalarNonzerosOp*>(n)){
+          s.pack(int(MX_SCALAR_NONZEROS));
+        } else if(dynamic_cast<const NonzerosScalarOp*>(n)){
+          s.pack(int(MX_NONZEROS_SCALAR));
+        } else if(dynamic_cast<const NonzerosNonzerosOp*>(n)){
+          s.pack(int(MX_NONZEROS_NONZEROS));
+        } else if(dynamic_cast<const SparseSparseOp*>(n)){
+          s.pack(int(MX_SPARSE_SPARSE));
+        } else {
+          stringstream ss;
+          n->printPart(ss,0);
+          casadi_error("MXFunction::save: operation " << it->op << " (" << ss.str() << ") cannot be saved");
+        }
+    }
+  }
+}
+
+MXFunction MXFunctionInternal::load(Deserializer& d){
+  d.unpackHeader("CASADIMX",1);
+  string name;
+  d.unpack(name);
+  int n_in, n_out, worksize, n_alg;
+  d.unpack(n_in);
+  casadi_assert_message(n_in>=0, "MXFunction::load: corrupt file");
+  vector<MX> arg(n_in);
+  for(int ind=0; ind<n_in; ++ind){
+    CRSSparsity sp;
+    string iname;
+    d.unpack(sp);
+    d.unpack(iname);
+    if(iname.empty()){
+      stringstream ss;
+      ss << "x" << ind;
+      iname = ss.str();
+    }
+    arg[ind] = msym(iname,sp);
+  }
+  d.unpack(n_out);
+  
+  // Table of the embedded functions
+  int n_fcn;
+  d.unpack(n_fcn);
+  casadi_assert_message(n_fcn>=0, "MXFunction::load: corrupt file");
+  vector<FX> fcn(n_fcn);
+  for(vector<FX>::iterator it=fcn.begin(); it!=fcn.end(); ++it){
+    *it = loadEmbedded(d);
+  }
+  
+  d.unpack(worksize);
+  d.unpack(n_alg);
+  casadi_assert_message(n_out>=0 && worksize>=0 && n_alg>=0, "MXFunction::load: corrupt file");
+  vector<MX> res(n_out);
+  
+  // Recreate the expression graph, operation by operation
+  vector<MX> w(worksize);
+  for(int k=0; k<n_alg; ++k){
+    int op;
+    vector<int> iarg, ires;
+    d.unpack(op);
+    d.unpack(iarg);
+    d.unpack(ires);
+    
+    // Get the arguments, a negative index corresponds to a null argument
+    vector<MX> x(iarg.size());
+    if(op!=OP_INPUT && op!=OP_OUTPUT){
+      for(int i=0; i<iarg.size(); ++i){
+        casadi_assert_message(iarg[i]<worksize, "MXFunction::load: corrupt file, invalid operation " << k);
+        if(iarg[i]>=0) x[i] = w[iarg[i]];
+      }
+    }
+    for(int i=0; i<ires.size(); ++i){
+      casadi_assert_message(ires[i]<worksize && (op==OP_OUTPUT || op==OP_CALL || ires[i]>=0), "MXFunction::load: corrupt file, invalid operation " << k);
+    }
+    
+    // Number of arguments and results, if fixed
+    int nx = -1, nr = 1;
+    switch(op){
+      case OP_INPUT: nx = 1; break;
+      case OP_OUTPUT: nx = 1; break;
+      case OP_PARAMETER: case OP_CONST: nx = 0; break;
+      case OP_CALL: nr = -1; break;
+      case OP_MAPPING: break;
+      case OP_MATMUL: nx = 2; break;
+      case OP_DENSIFY: case OP_NORM2: case OP_NORM1: case OP_NORMINF: case OP_NORMF: nx = 1; break;
+      default: nx = (op>=0 && op<NUM_BUILT_IN_OPS) ? casadi_math<double>::ndeps(op) : -2;
+    }
+    casadi_assert_message(nx!=-2 && (nx<0 || iarg.size()==nx) && (nr<0 || ires.size()==nr), "MXFunction::load: corrupt file, invalid operation " << k);
+    
+    switch(op){
+      case OP_INPUT:
+        casadi_assert_message(iarg[0]>=0 && iarg[0]<n_in, "MXFunction::load: corrupt file, invalid operation " << k);
+        w[ires[0]] = arg[iarg[0]];
+        break;
+      case OP_OUTPUT:
+        casadi_assert_message(iarg[0]>=0 && iarg[0]<worksize && ires[0]>=0 && ires[0]<n_out, "MXFunction::load: corrupt file, invalid operation " << k);
+        res[ires[0]] = w[iarg[0]];
+        break;
+      case OP_PARAMETER:
+      {
+        string pname;
+        CRSSparsity sp;
+        d.unpack(pname);
+        d.unpack(sp);
+        w[ires[0]] = msym(pname,sp);
+        break;
+      }
+      case OP_CONST:
+      {
+        DMatrix v;
+        d.unpack(v);
+        w[ires[0]] = MX::create(new ConstantMX(v));
+        break;
+      }
+      case OP_CALL:
+      {
+        int ind;
+        d.unpack(ind);
+        casadi_assert_message(ind>=0 && ind<fcn.size(), "MXFunction::load: corrupt file, invalid operation " << k);
+        FX f = fcn[ind];
+        casadi_assert_message(iarg.size()==f.getNumInputs() && ires.size()==f.getNumOutputs(), "MXFunction::load: corrupt file, invalid operation " << k);
+        vector<MX> r = f.call(x);
+        for(int i=0; i<ires.size(); ++i){
+          if(ires[i]>=0) w[ires[i]] = r[i];
+        }
+        break;
+      }
+      case OP_MAPPING:
+      {
+        CRSSparsity sp;
+        d.unpack(sp);
+        Mapping* m = new Mapping(sp);
+        MX mm = MX::create(m);
+        for(int i=0; i<x.size(); ++i){
+          casadi_assert_message(!x[i].isNull() && m->depmap_.count(static_cast<const MXNode*>(x[i].get()))==0, "MXFunction::load: corrupt file, invalid operation " << k);
+          m->depmap_[static_cast<const MXNode*>(x[i].get())] = m->addDependency(x[i]);
+        }
+        for(int onz=0; onz<sp.size(); ++onz){
+          vector<int> nz;
+          d.unpack(nz);
+          casadi_assert_message(nz.size()%2==0, "MXFunction::load: corrupt file, invalid operation " << k);
+          for(int i=0; i<nz.size(); i+=2){
+            Mapping::OutputNZ e = {nz[i],nz[i+1]};
+            casadi_assert_message(e.iind>=0 && e.iind<x.size() && e.inz>=0 && e.inz<x[e.iind].size(), "MXFunction::load: corrupt file, invalid operation " << k);
+            m->output_sorted_[onz].push_back(e);
+          }
+        }
+        w[ires[0]] = mm;
+        break;
+      }
+      case OP_MATMUL:
+        w[ires[0]] = MX::create(new Multiplication(x[0],x[1]));
+        break;
+      case OP_DENSIFY:
+        w[ires[0]] = MX::create(new Densification(x[0]));
+        break;
+      case OP_NORM2:
+        w[ires[0]] = MX::create(new Norm2(x[0]));
+        break;
+      case OP_NORM1:
+        w[ires[0]] = MX::create(new Norm1(x[0]));
+        break;
+      case OP_NORMINF:
+        w[ires[0]] = MX::create(new NormInf(x[0]));
+        break;
+      case OP_NORMF:
+        w[ires[0]] = MX::create(new NormF(x[0]));
+        break;
+      default:
+      {
+        int cls;
+        d.unpack(cls);
+        Operation o = Operation(op);
+        switch(cls){
+          case MX_UNARY:
+            casadi_assert_message(iarg.size()==1 || iarg[0]==iarg[1], "MXFunction::load: corrupt file, invalid operation " << k);
+            w[ires[0]] = UnaryMX::create(o,x[0]);
+            break;
+          case MX_SCALAR_NONZEROS: w[ires[0]] = MX::create(new ScalarNonzerosOp(o,x[0],x[1])); break;
+          case MX_NONZEROS_SCALAR: w[ires[0]] = MX::create(new NonzerosScalarOp(o,x[0],x[1])); break;
+          case MX_NONZEROS_NONZEROS: w[ires[0]] = MX::create(new NonzerosNonzerosOp(o,x[0],x[1])); break;
+          case MX_SPARSE_SPARSE: w[ires[0]] = MX::create(new SparseSparseOp(o,x[0],x[1])); break;
+          default: casadi_error("MXFunction::load: corrupt file, invalid operation " << k);
+        }
+      }
+    }
+  }
+  
+  MXFunction ret(arg,res);
+  ret.setOption("name",name);
+  ret.init();
+  return ret;
+}
+
 void MXFunctionInternal::spInit(bool fwd){
+  // The work vector is overwritten
+  inc_valid_ = false;
+  
   // Start by setting all elements of the work vector to zero
   for(vector<FunctionIO>::iterator it=work_.begin(); it!=work_.end(); ++it){
     //Get a pointer to the int array
@@ -717,6 +1350,79 @@ void MXFunctionInternal::spEvaluate(bool fwd){
   }
 }
 
+void MXFunctionInternal::spEvaluateBlock(bool fwd, int nw, int iind, int oind, const bvec_t* seed, bvec_t* sens, vector<bvec_t>& work){
+  // Offsets of the elements of the work vector, nw words per nonzero
+  vector<int> offset(work_.size()+1,0);
+  for(int i=0; i<work_.size(); ++i) offset[i+1] = offset[i] + work_[i].data.size()*nw;
+  work.resize(offset.back());
+  bvec_t *iwork = getPtr(work);
+  
+  // Pointers to the arguments and results of an operation
+  vector<bvec_t*> arg, res;
+  
+  if(fwd){ // Forward propagation
+    for(vector<AlgEl>::iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+      if(it->op==OP_INPUT){
+        // Pass the seeds, other inputs do not depend on anything
+        int el = it->res.front();
+        if(it->arg.front()==iind){
+          copy(seed,seed+offset[el+1]-offset[el],iwork+offset[el]);
+        } else {
+          std::fill(iwork+offset[el],iwork+offset[el+1],bvec_t(0));
+        }
+      } else if(it->op==OP_OUTPUT){
+        // Get the sensitivities
+        int el = it->arg.front();
+        if(it->res.front()==oind){
+          copy(iwork+offset[el],iwork+offset[el+1],sens);
+        }
+      } else if(it->op==OP_PARAMETER){
+        // Parameters are constant
+        int el = it->res.front();
+        std::fill(iwork+offset[el],iwork+offset[el+1],bvec_t(0));
+      } else {
+        arg.resize(it->arg.size());
+        for(int i=0; i<arg.size(); ++i) arg[i] = it->arg[i]>=0 ? iwork+offset[it->arg[i]] : 0;
+        res.resize(it->res.size());
+        for(int i=0; i<res.size(); ++i) res[i] = it->res[i]>=0 ? iwork+offset[it->res[i]] : 0;
+        it->data->propagateSparsityBlock(arg,res,nw,true);
+      }
+    }
+    
+  } else { // Backward propagation
+    std::fill(work.begin(),work.end(),bvec_t(0));
+    for(vector<AlgEl>::reverse_iterator it=algorithm_.rbegin(); it!=algorithm_.rend(); ++it){
+      if(it->op==OP_INPUT){
+        // Get the sensitivities
+        int el = it->res.front();
+        if(it->arg.front()==iind){
+          copy(iwork+offset[el],iwork+offset[el+1],sens);
+        }
+      } else if(it->op==OP_OUTPUT){
+        // Pass the seeds
+        int el = it->arg.front();
+        if(it->res.front()==oind){
+          bvec_t *w = iwork+offset[el];
+          for(int k=0; k<offset[el+1]-offset[el]; ++k) w[k] |= seed[k];
+        }
+      } else if(it->op!=OP_PARAMETER){
+        arg.resize(it->arg.size());
+        for(int i=0; i<arg.size(); ++i) arg[i] = it->arg[i]>=0 ? iwork+offset[it->arg[i]] : 0;
+        res.resize(it->res.size());
+        for(int i=0; i<res.size(); ++i) res[i] = it->res[i]>=0 ? iwork+offset[it->res[i]] : 0;
+        it->data->propagateSparsityBlock(arg,res,nw,false);
+      }
+      
+      // Clear the seeds for the operations calculated earlier, which may share the elements of the work vector
+      if(it->op!=OP_OUTPUT){
+        for(vector<int>::const_iterator c=it->res.begin(); c!=it->res.end(); ++c){
+          if(*c>=0) std::fill(iwork+offset[*c],iwork+offset[*c+1],bvec_t(0));
+        }
+      }
+    }
+  }
+}
+
 FX MXFunctionInternal::getNumericJacobian(int iind, int oind, bool compact, bool symmetric){
   // Create expressions for the Jacobian
   vector<MX> ret_out;
@@ -1110,7 +1816,105 @@ void MXFunctionInternal::allocTape(){
   }
 }
 
+void MXFunctionInternal::generateCode(const std::string& filename){
+  assertInit();
+  
+  // Make sure that there are no free variables
+  casadi_assert_message(free_vars_.empty(), "Code generation is not possible since variables " << free_vars_ << " are free.");
+  
+  // Output
+  if(verbose()){
+    cout << "Generating: " << filename << " (" << algorithm_.size() << " operations)" << endl;
+  }
+  
+  // Create the c source file
+  ofstream cfile;
+  cfile.open(filename.c_str());
+  
+  // Print header
+  cfile << "/* This function was automatically generated by CasADi */" << endl;
+  cfile << "#include <math.h>" << endl << endl;
+  
+  // Space saving macro
+  cfile << "#define d double" << endl << endl;
+  
+  // Dimensions and sparsity patterns of the inputs and outputs
+  generateInterface(cfile);
+  
+  // The sign function
+  cfile << "double sign(double x){ return x<0 ? -1 : x>0 ? 1 : x;}" << endl << endl;
+  
+  // Generate the function and everything it depends on
+  CodeGenerator gen;
+  string f = gen.getDependency(shared_from_this<FX>());
+  gen.flush(cfile);
+
+  // Evaluate function
+  cfile << "int evaluate(const double** x, double** r){" << endl;
+  cfile << "  return " << f << "(x,r);" << endl;
+  cfile << "}" << endl << endl;
+  
+  // Close the results file
+  cfile.close();
+}
 
+void MXFunctionInternal::generateFunction(std::ostream &stream, const std::string& fname, CodeGenerator& gen) const{
+  casadi_assert_message(free_vars_.empty(), "Code generation is not possible since variables " << free_vars_ << " are free.");
+  
+  // The body is printed to a separate stream so that the functions it depends on end up before it
+  stringstream body;
+  
+  // Names of the arguments and results of an operation
+  vector<string> arg, res;
+  
+  // Print the operations
+  for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+    if(it->op==OP_INPUT){
+      int ind = it->res.front();
+      if(ind>=0){
+        body << "  for(i=0; i<" << work_[ind].data.size() << "; ++i) w" << ind << "[i]=x[" << it->arg.front() << "][i];" << endl;
+      }
+    } else if(it->op==OP_OUTPUT){
+      int ind = it->arg.front();
+      body << "  if(r[" << it->res.front() << "]!=0) for(i=0; i<" << work_[ind].data.size() << "; ++i) r[" << it->res.front() << "][i]=w" << ind << "[i];" << endl;
+    } else if(it->op!=OP_PARAMETER){
+      // Null arguments and results are indicated by "0"
+      arg.resize(it->arg.size());
+      for(int c=0; c<arg.size(); ++c){
+        stringstream ss;
+        if(it->arg[c]>=0){
+          ss << "w" << it->arg[c];
+        } else {
+          ss << "0";
+        }
+        arg[c] = ss.str();
+      }
+      res.resize(it->res.size());
+      for(int c=0; c<res.size(); ++c){
+        stringstream ss;
+        if(it->res[c]>=0){
+          ss << "w" << it->res[c];
+        } else {
+          ss << "0";
+        }
+        res[c] = ss.str();
+      }
+      
+      // Generate the operation
+      it->data->generateOperation(body,arg,res,gen);
+    }
+  }
+  
+  // Function, the work vector is local so that the code is reentrant
+  stream << "static int " << fname << "(const d** x, d** r){" << endl;
+  stream << "  int i;" << endl;
+  for(int i=0; i<work_.size(); ++i){
+    stream << "  d w" << i << "[" << std::max(work_[i].data.size(),1) << "];" << endl;
+  }
+  stream << body.str();
+  stream << "  return 0;" << endl;
+  stream << "}" << endl << endl;
+}
 
 } // namespace CasADi
 
@@ -31,9 +31,13 @@
 #include "mx_function.hpp"
 #include "x_function_internal.hpp"
 #include "../mx/mx_node.hpp"
+#include "code_generator.hpp"
 
 namespace CasADi{
 
+class Serializer;
+class Deserializer;
+
 /** \brief  Internal node class for MXFunction
   \author Joel Andersson 
   \date 2010
@@ -117,6 +121,10 @@ class MXFunctionInternal : public XFunctionInternal<MXFunction,MXFunctionInterna
     DMatrixPtrVV mx_fwdSens_;
     DMatrixPtrVV mx_adjSeed_;
     DMatrixPtrVV mx_adjSens_;
+    
+    // Work vectors of the nodes during numeric evaluation
+    std::vector<int> itmp_;
+    std::vector<double> rtmp_;
 
     /// Get a vector of symbolic variables with the same dimensions as the inputs
     virtual std::vector<MX> symbolicInput() const{ return inputv_;}
@@ -130,6 +138,22 @@ class MXFunctionInternal : public XFunctionInternal<MXFunction,MXFunctionInterna
     /// Reset the sparsity propagation
     virtual void spInit(bool fwd);
     
+    /// Propagate a sparsity pattern through the algorithm, several words per nonzero
+    virtual void spEvaluateBlock(bool fwd, int nw, int iind, int oind, const bvec_t* seed, bvec_t* sens, std::vector<bvec_t>& work);
+    
+    /// Is the class able to propagate several words per nonzero at once? Only in serial sweeps, since nodes without
+    /// a block implementation and embedded functions use temporary matrices and their own input and output arrays
+    virtual bool spCanEvaluateBlock(bool fwd){ return !sp_parallel_;}
+    
+    /// Add the algorithm and the input and output sparsity patterns to a hash, if all nodes support it
+    virtual bool hashStructure(StructureHash& h);
+    
+    /// Write the function in binary format
+    void save(Serializer& s) const;
+    
+    /// Read a function written by save, recreating the expression graph
+    static MXFunction load(Deserializer& d);
+    
     /// Print work vector
     void printWork(int nfdir=0, int nadir=0, std::ostream &stream=std::cout);
     
@@ -139,6 +163,33 @@ class MXFunctionInternal : public XFunctionInternal<MXFunction,MXFunctionInterna
     /// Allocate tape
     void allocTape();
     
+    /// Find the operations that depend on each input, for incremental evaluation
+    void initIncremental();
+    
+    /** \brief Forward the arguments of identity mappings and remove unused mappings
+    * Works on the algorithm before the work vector is allocated, i.e. with arguments and results referring to the
+    * nnodes sorted nodes. On return, new_ind contains the new index of each element of the algorithm, -1 if removed.
+    */
+    void optimizeMappings(int nnodes, std::vector<int>& new_ind);
+    
+    /// Execute a sorted subset of the operations of the algorithm (no derivatives)
+    void evaluateOps(const std::vector<int>& ops);
+    
+    /// The operations needed to calculate the outputs in oind (sorted)
+    std::vector<int> outputSlice(const std::vector<int>& oind) const;
+    
+    /// Execute a slice returned by outputSlice
+    void evaluateSlice(const std::vector<int>& ops){ evaluateOps(ops);}
+    
+    /// Is executing a slice cheaper than a complete evaluation
+    bool sliceWorthwhile(const std::vector<int>& ops) const;
+    
+    /// Generate C code for the function
+    void generateCode(const std::string& filename);
+    
+    /// Generate C code for the evaluation as a static function with a given name, dependencies are added to the code generator
+    void generateFunction(std::ostream &stream, const std::string& fname, CodeGenerator& gen) const;
+    
 };
 
 } // namespace CasADi
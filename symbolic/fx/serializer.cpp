@@ -0,0 +1,199 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "serializer.hpp"
+#include "../stl_vector_tools.hpp"
+#include "../casadi_exception.hpp"
+#include <cstring>
+#include <fstream>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // _WIN32
+
+using namespace std;
+
+namespace CasADi{
+
+// Written after the file type, detects files written with a different byte order or type sizes
+static const int serializer_byte_order = 0x01020304;
+
+Serializer::Serializer(std::ostream& stream) : stream_(stream){
+}
+
+void Serializer::packHeader(const std::string& magic, int version){
+  casadi_assert(magic.size()==8);
+  packRaw(magic.data(),8);
+  pack(version);
+  pack(serializer_byte_order);
+  pack(int(sizeof(int)));
+  pack(int(sizeof(double)));
+}
+
+void Serializer::pack(int v){
+  packRaw(&v,sizeof(int));
+}
+
+void Serializer::pack(double v){
+  packRaw(&v,sizeof(double));
+}
+
+void Serializer::pack(const std::string& v){
+  pack(int(v.size()));
+  packRaw(v.data(),v.size());
+}
+
+void Serializer::pack(const std::vector<int>& v){
+  pack(int(v.size()));
+  if(!v.empty()) packRaw(getPtr(v),v.size()*sizeof(int));
+}
+
+void Serializer::pack(const std::vector<double>& v){
+  pack(int(v.size()));
+  if(!v.empty()) packRaw(getPtr(v),v.size()*sizeof(double));
+}
+
+void Serializer::pack(const CRSSparsity& v){
+  pack(v.size1());
+  pack(v.size2());
+  pack(v.rowind());
+  pack(v.col());
+}
+
+void Serializer::pack(const Matrix<double>& v){
+  pack(v.sparsity());
+  pack(v.data());
+}
+
+void Serializer::packRaw(const void* data, long n){
+  stream_.write(static_cast<const char*>(data),n);
+  casadi_assert_message(stream_.good(),"Serializer: write failed");
+}
+
+Deserializer::Deserializer(const char* data, long size) : data_(data), size_(size), pos_(0){
+}
+
+void Deserializer::unpackHeader(const std::string& magic, int version){
+  casadi_assert_message(size_-pos_>=8 && magic.compare(0,8,data_+pos_,8)==0, "Deserializer: not a file of type \"" << magic << "\"");
+  pos_ += 8;
+  int file_version, byte_order, sz_int, sz_double;
+  unpack(file_version);
+  unpack(byte_order);
+  unpack(sz_int);
+  unpack(sz_double);
+  casadi_assert_message(byte_order==serializer_byte_order && sz_int==sizeof(int) && sz_double==sizeof(double), "Deserializer: the file was written on a machine with a different byte order or type sizes");
+  casadi_assert_message(file_version==version, "Deserializer: file format version " << file_version << " is not supported, expected version " << version);
+}
+
+void Deserializer::unpack(int& v){
+  memcpy(&v,unpackRaw(sizeof(int)),sizeof(int));
+}
+
+void Deserializer::unpack(double& v){
+  memcpy(&v,unpackRaw(sizeof(double)),sizeof(double));
+}
+
+void Deserializer::unpack(std::string& v){
+  int n;
+  unpack(n);
+  casadi_assert_message(n>=0, "Deserializer: corrupt file");
+  const char* p = unpackRaw(n);
+  v.assign(p,p+n);
+}
+
+void Deserializer::unpack(std::vector<int>& v){
+  int n;
+  unpack(n);
+  casadi_assert_message(n>=0, "Deserializer: corrupt file");
+  v.resize(n);
+  if(n>0) memcpy(getPtr(v),unpackRaw(long(n)*sizeof(int)),long(n)*sizeof(int));
+}
+
+void Deserializer::unpack(std::vector<double>& v){
+  int n;
+  unpack(n);
+  casadi_assert_message(n>=0, "Deserializer: corrupt file");
+  v.resize(n);
+  if(n>0) memcpy(getPtr(v),unpackRaw(long(n)*sizeof(double)),long(n)*sizeof(double));
+}
+
+void Deserializer::unpack(CRSSparsity& v){
+  int nrow, ncol;
+  vector<int> rowind, col;
+  unpack(nrow);
+  unpack(ncol);
+  unpack(rowind);
+  unpack(col);
+  casadi_assert_message(nrow>=0 && ncol>=0 && rowind.size()==nrow+1 && rowind.back()==col.size(), "Deserializer: corrupt file");
+  v = CRSSparsity(nrow,ncol,col,rowind);
+}
+
+void Deserializer::unpack(Matrix<double>& v){
+  CRSSparsity sp;
+  vector<double> data;
+  unpack(sp);
+  unpack(data);
+  casadi_assert_message(data.size()==sp.size(), "Deserializer: corrupt file");
+  v = Matrix<double>(sp,data);
+}
+
+const char* Deserializer::unpackRaw(long n){
+  casadi_assert_message(n>=0 && n<=size_-pos_, "Deserializer: unexpected end of file");
+  const char* ret = data_+pos_;
+  pos_ += n;
+  return ret;
+}
+
+MappedFile::MappedFile(const std::string& filename) : data_(0), size_(0), mapped_(false){
+#ifndef _WIN32
+  int fd = open(filename.c_str(),O_RDONLY);
+  casadi_assert_message(fd>=0, "MappedFile: cannot open \"" << filename << "\"");
+  struct stat st;
+  if(fstat(fd,&st)==0 && st.st_size>0){
+    void* p = mmap(0,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    if(p!=MAP_FAILED){
+      data_ = static_cast<const char*>(p);
+      size_ = st.st_size;
+      mapped_ = true;
+    }
+  }
+  close(fd);
+  if(mapped_) return;
+#endif // _WIN32
+
+  // Read the file into a buffer
+  ifstream f(filename.c_str(),ios::binary);
+  casadi_assert_message(f.good(), "MappedFile: cannot open \"" << filename << "\"");
+  buffer_.assign(istreambuf_iterator<char>(f),istreambuf_iterator<char>());
+  data_ = buffer_.empty() ? 0 : getPtr(buffer_);
+  size_ = buffer_.size();
+}
+
+MappedFile::~MappedFile(){
+#ifndef _WIN32
+  if(mapped_) munmap(const_cast<char*>(data_),size_);
+#endif // _WIN32
+}
+
+} // namespace CasADi
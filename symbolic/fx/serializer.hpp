@@ -0,0 +1,124 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef SERIALIZER_HPP
+#define SERIALIZER_HPP
+
+#include "../matrix/matrix.hpp"
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace CasADi{
+
+/** \brief Helper class for writing functions to a binary file
+  The data is written in the native byte order, the header written by packHeader allows the reader to detect
+  files written on an incompatible machine. Large arrays are written as they are in memory, so that they can be
+  read back with a single copy from a memory-mapped file.
+*/
+class Serializer{
+  public:
+    /// Constructor
+    explicit Serializer(std::ostream& stream);
+
+    /// Write the file type (8 characters), the format version and the byte order and type size checks
+    void packHeader(const std::string& magic, int version);
+
+    //@{
+    /// Write a value
+    void pack(int v);
+    void pack(double v);
+    void pack(const std::string& v);
+    void pack(const std::vector<int>& v);
+    void pack(const std::vector<double>& v);
+    void pack(const CRSSparsity& v);
+    void pack(const Matrix<double>& v);
+    //@}
+
+    /// Write a block of memory
+    void packRaw(const void* data, long n);
+
+  private:
+    std::ostream& stream_;
+};
+
+/** \brief Helper class for reading functions from a binary file, see Serializer
+  The data is read from a buffer in memory, typically a memory-mapped file. A file that is truncated or
+  does not match the expected format results in an exception.
+*/
+class Deserializer{
+  public:
+    /// Constructor, the buffer must remain valid for the life time of the object
+    Deserializer(const char* data, long size);
+
+    /// Read and check the file type and the format version, only files of exactly this version can be read
+    void unpackHeader(const std::string& magic, int version);
+
+    //@{
+    /// Read a value
+    void unpack(int& v);
+    void unpack(double& v);
+    void unpack(std::string& v);
+    void unpack(std::vector<int>& v);
+    void unpack(std::vector<double>& v);
+    void unpack(CRSSparsity& v);
+    void unpack(Matrix<double>& v);
+    //@}
+
+    /// Get a pointer to a block of memory of n bytes and advance past it
+    const char* unpackRaw(long n);
+
+  private:
+    const char* data_;
+    long size_, pos_;
+};
+
+/** \brief A file mapped into memory (read-only), read into a buffer if memory mapping is not available
+*/
+class MappedFile{
+  public:
+    /// Open and map a file
+    explicit MappedFile(const std::string& filename);
+
+    /// Unmap the file
+    ~MappedFile();
+
+    /// Start of the data
+    const char* data() const{ return data_;}
+
+    /// Size in bytes
+    long size() const{ return size_;}
+
+  private:
+    // Not copyable
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* data_;
+    long size_;
+    std::vector<char> buffer_;
+    bool mapped_;
+};
+
+} // namespace CasADi
+
+#endif // SERIALIZER_HPP
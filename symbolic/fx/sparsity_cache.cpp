@@ -0,0 +1,296 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "sparsity_cache.hpp"
+#include "../stl_vector_tools.hpp"
+#include <cstdio>
+#include <ctime>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <map>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <utime.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace CasADi{
+
+// Identifies the file format, also detects files written on a machine with a different byte order
+static const int sparsity_cache_magic = 0x43535043;
+static const int sparsity_cache_version = 2;
+
+// Temporary files older than this (in seconds) were left behind by a writer that did not finish
+static const int sparsity_cache_tmp_age = 3600;
+
+StructureHash::StructureHash() : h_(14695981039346656037ULL), h2_(2611923443488327891ULL), n_(0){
+}
+
+void StructureHash::addBytes(const void* p, int n){
+  const unsigned char* c = static_cast<const unsigned char*>(p);
+  for(int i=0; i<n; ++i){
+    // FNV-1a
+    h_ ^= c[i];
+    h_ *= 1099511628211ULL;
+    
+    // Multiply and shift, with the golden ratio as multiplier
+    h2_ = (h2_ + c[i] + 1)*11400714819323198485ULL;
+    h2_ ^= h2_ >> 29;
+  }
+  n_ += n;
+}
+
+void StructureHash::add(int v){
+  // Byte by byte, least significant first, so that the value does not depend on the byte order
+  unsigned char c[4];
+  for(int i=0; i<4; ++i) c[i] = (v >> (8*i)) & 0xff;
+  addBytes(c,4);
+}
+
+void StructureHash::add(const std::vector<int>& v){
+  add(int(v.size()));
+  for(vector<int>::const_iterator it=v.begin(); it!=v.end(); ++it) add(*it);
+}
+
+void StructureHash::add(const std::string& s){
+  add(int(s.size()));
+  addBytes(s.data(),s.size());
+}
+
+void StructureHash::add(const CRSSparsity& sp){
+  if(sp.isNull()){
+    add(-1);
+  } else {
+    add(sp.size1());
+    add(sp.size2());
+    add(sp.rowind());
+    add(sp.col());
+  }
+}
+
+std::string StructureHash::str() const{
+  stringstream ss;
+  ss << hex << setw(16) << setfill('0') << h_;
+  return ss.str();
+}
+
+std::string StructureHash::digest(const std::vector<int>& dims) const{
+  // Least significant byte first
+  string ret;
+  unsigned long long v[3] = {h_, h2_, n_};
+  for(int k=0; k<3; ++k){
+    for(int i=0; i<8; ++i) ret.push_back(char((v[k] >> (8*i)) & 0xff));
+  }
+  for(vector<int>::const_iterator it=dims.begin(); it!=dims.end(); ++it){
+    for(int i=0; i<4; ++i) ret.push_back(char((*it >> (8*i)) & 0xff));
+  }
+  return ret;
+}
+
+SparsityCache::SparsityCache() : max_size_(0){
+}
+
+SparsityCache::SparsityCache(const std::string& dir, long max_size) : dir_(dir), max_size_(max_size){
+  if(!dir_.empty()){
+    // Create the directory if it does not exist (only the last level)
+#ifdef _WIN32
+    _mkdir(dir_.c_str());
+#else
+    mkdir(dir_.c_str(),0755);
+#endif
+  }
+}
+
+std::string SparsityCache::fileName(const std::string& key) const{
+  StructureHash h;
+  h.add(key);
+  return dir_ + "/" + h.str() + ".csp";
+}
+
+bool SparsityCache::load(const std::string& key, std::vector<CRSSparsity>& sp) const{
+  if(!enabled()) return false;
+  string fname = fileName(key);
+  FILE* f = fopen(fname.c_str(),"rb");
+  if(f==0) return false;
+
+  // Number of integers in the file, bounds all sizes read from it before anything is allocated
+  bool ok = fseek(f,0,SEEK_END)==0;
+  long nint = ok ? ftell(f)/long(sizeof(int)) : 0;
+  ok = ok && nint>=4 && fseek(f,0,SEEK_SET)==0;
+
+  // Header and key, a different key with the same hash is a miss
+  int header[4];
+  ok = ok && fread(header,sizeof(int),4,f)==4 && header[0]==sparsity_cache_magic && header[1]==sparsity_cache_version;
+  long nint_key = (long(key.size())+sizeof(int)-1)/sizeof(int);
+  ok = ok && header[2]>=0 && header[2]<=1000 && header[3]==int(key.size()) && 4+nint_key<=nint;
+  nint -= 4 + nint_key;
+  if(ok){
+    string file_key(key.size(),'\0');
+    ok = key.empty() || (fread(&file_key[0],1,key.size(),f)==key.size() && file_key==key);
+    
+    // The key is padded to a whole number of integers
+    char pad[sizeof(int)];
+    int npad = (sizeof(int) - key.size()%sizeof(int))%sizeof(int);
+    ok = ok && (npad==0 || fread(pad,1,npad,f)==npad);
+  }
+  vector<CRSSparsity> ret;
+  if(ok) ret.resize(header[2]);
+  for(vector<CRSSparsity>::iterator it=ret.begin(); ok && it!=ret.end(); ++it){
+    int dim[3];
+    ok = nint>=3 && fread(dim,sizeof(int),3,f)==3;
+    nint -= 3;
+    if(!ok || dim[0]<0) continue; // null pattern
+    int nrow=dim[0], ncol=dim[1], nnz=dim[2];
+    ok = ncol>=0 && nnz>=0 && long(nrow)+1+long(nnz)<=nint;
+    if(!ok) break;
+    nint -= long(nrow)+1+long(nnz);
+    vector<int> rowind(nrow+1), col(nnz);
+    ok = fread(getPtr(rowind),sizeof(int),nrow+1,f)==nrow+1 && (nnz==0 || fread(getPtr(col),sizeof(int),nnz,f)==nnz);
+
+    // Validate before constructing the pattern
+    ok = ok && rowind.front()==0 && rowind.back()==nnz;
+    for(int i=0; ok && i<nrow; ++i){
+      ok = rowind[i]<=rowind[i+1];
+      for(int el=rowind[i]; ok && el<rowind[i+1]; ++el){
+        ok = col[el]>=0 && col[el]<ncol && (el==rowind[i] || col[el-1]<col[el]);
+      }
+    }
+    if(ok) *it = CRSSparsity(nrow,ncol,col,rowind);
+  }
+
+  // Nothing may follow
+  ok = ok && fgetc(f)==EOF;
+  fclose(f);
+  if(!ok) return false;
+
+  // Mark as recently used
+  utime(fname.c_str(),0);
+  sp = ret;
+  return true;
+}
+
+void SparsityCache::save(const std::string& key, const std::vector<CRSSparsity>& sp) const{
+  if(!enabled()) return;
+
+  // Write to a temporary file first so that other processes and threads never see a partially written entry
+  string fname = fileName(key);
+#ifdef _WIN32
+  stringstream ss;
+  ss << fname << ".tmp" << getpid() << "_" << GetCurrentThreadId();
+  string tmpname = ss.str();
+  FILE* f = fopen(tmpname.c_str(),"wb");
+#else
+  string tmpname = fname + ".tmpXXXXXX";
+  int fd = mkstemp(&tmpname[0]);
+  // mkstemp creates the file readable by the owner only, other processes may share the cache
+  if(fd>=0) fchmod(fd,0644);
+  FILE* f = fd<0 ? 0 : fdopen(fd,"wb");
+  if(f==0 && fd>=0){
+    close(fd);
+    remove(tmpname.c_str());
+  }
+#endif
+  if(f==0) return;
+
+  bool ok = true;
+  int header[4] = {sparsity_cache_magic, sparsity_cache_version, int(sp.size()), int(key.size())};
+  ok = fwrite(header,sizeof(int),4,f)==4;
+  
+  // The full key, padded to a whole number of integers
+  ok = ok && (key.empty() || fwrite(key.data(),1,key.size(),f)==key.size());
+  int npad = (sizeof(int) - key.size()%sizeof(int))%sizeof(int);
+  const char pad[sizeof(int)] = {0};
+  ok = ok && (npad==0 || fwrite(pad,1,npad,f)==npad);
+  for(vector<CRSSparsity>::const_iterator it=sp.begin(); ok && it!=sp.end(); ++it){
+    if(it->isNull()){
+      int dim[3] = {-1,-1,-1};
+      ok = fwrite(dim,sizeof(int),3,f)==3;
+    } else {
+      int dim[3] = {it->size1(), it->size2(), it->size()};
+      ok = fwrite(dim,sizeof(int),3,f)==3 && fwrite(getPtr(it->rowind()),sizeof(int),it->size1()+1,f)==it->size1()+1;
+      ok = ok && (it->size()==0 || fwrite(getPtr(it->col()),sizeof(int),it->size(),f)==it->size());
+    }
+  }
+  ok = fclose(f)==0 && ok;
+
+#ifdef _WIN32
+  // Renaming does not replace an existing file
+  if(ok) remove(fname.c_str());
+#endif
+  if(!ok || rename(tmpname.c_str(),fname.c_str())!=0){
+    remove(tmpname.c_str());
+    return;
+  }
+
+  // Keep the size of the cache bounded
+  evict();
+}
+
+void SparsityCache::evict() const{
+  if(!enabled()) return;
+  DIR* d = opendir(dir_.c_str());
+  if(d==0) return;
+
+  // Collect the entries with their last access and size
+  vector<pair<time_t,string> > entries;
+  map<string,long> sizes;
+  long total_size = 0;
+  time_t now = time(0);
+  for(struct dirent* e=readdir(d); e!=0; e=readdir(d)){
+    string name = e->d_name;
+    string fname = dir_ + "/" + name;
+    struct stat st;
+    
+    // Temporary files of writers that were interrupted, recent ones may still be in use
+    if(name.find(".csp.tmp")!=string::npos){
+      if(stat(fname.c_str(),&st)==0 && now-st.st_mtime>sparsity_cache_tmp_age) remove(fname.c_str());
+      continue;
+    }
+    
+    if(name.size()<=4 || name.compare(name.size()-4,4,".csp")!=0) continue;
+    if(stat(fname.c_str(),&st)!=0) continue;
+    entries.push_back(make_pair(st.st_mtime,fname));
+    sizes[fname] = st.st_size;
+    total_size += st.st_size;
+  }
+  closedir(d);
+  if(max_size_<=0) return;
+
+  // Remove the least recently used entries first
+  sort(entries.begin(),entries.end());
+  for(vector<pair<time_t,string> >::const_iterator it=entries.begin(); it!=entries.end() && total_size>max_size_; ++it){
+    if(remove(it->second.c_str())==0){
+      total_size -= sizes[it->second];
+    }
+  }
+}
+
+} // namespace CasADi
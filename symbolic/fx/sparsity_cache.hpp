@@ -0,0 +1,118 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef SPARSITY_CACHE_HPP
+#define SPARSITY_CACHE_HPP
+
+#include "../matrix/crs_sparsity.hpp"
+#include <string>
+#include <vector>
+
+namespace CasADi{
+
+/** \brief Stable 64-bit hash (FNV-1a) of the structure of a function
+  The value only depends on the data added, in the order it was added, and is therefore the same
+  between processes and program runs, which makes it suitable as a key of a persistent cache.
+  A second, independent 64-bit hash is kept as well, so that the digest used as a key of a cache
+  has a fixed size however much data is added, and collisions are still very unlikely.
+*/
+class StructureHash{
+  public:
+    /// Constructor
+    StructureHash();
+
+    /// Add an integer
+    void add(int v);
+
+    /// Add a vector of integers, including its length
+    void add(const std::vector<int>& v);
+
+    /// Add a string, including its length
+    void add(const std::string& s);
+
+    /// Add a sparsity pattern, a null pattern is distinguished from an empty one
+    void add(const CRSSparsity& sp);
+
+    /// Get the hash value
+    unsigned long long value() const{ return h_;}
+
+    /// Get the hash value as a string of 16 hexadecimal digits
+    std::string str() const;
+
+    /// Get both hash values, the number of bytes added and dims, in a byte order independent encoding
+    std::string digest(const std::vector<int>& dims=std::vector<int>()) const;
+
+  private:
+    /// Add raw bytes
+    void addBytes(const void* p, int n);
+
+    /// Current value
+    unsigned long long h_;
+
+    /// Current value of the second hash
+    unsigned long long h2_;
+
+    /// Number of bytes added
+    unsigned long long n_;
+};
+
+/** \brief Persistent on-disk cache of sparsity patterns
+  Each entry is a list of sparsity patterns stored in a compact binary file "<hash of key>.csp" in the
+  cache directory, together with the key (a fixed-size digest, see StructureHash), which must match when the entry is read. Entries are
+  touched when read and the least recently used ones are removed when the total size of the cache
+  exceeds a maximum. Files that cannot be read or do not validate are treated as missing, so that the
+  cache can always be deleted or shared between processes.
+*/
+class SparsityCache{
+  public:
+    /// Default constructor, the cache is disabled
+    SparsityCache();
+
+    /// Constructor, an empty directory disables the cache, max_size is in bytes (no limit if non-positive)
+    SparsityCache(const std::string& dir, long max_size);
+
+    /// Is the cache enabled
+    bool enabled() const{ return !dir_.empty();}
+
+    /// Read an entry, returns false if not available
+    bool load(const std::string& key, std::vector<CRSSparsity>& sp) const;
+
+    /// Write an entry and evict old entries if the cache is too large, failure to write is not an error
+    void save(const std::string& key, const std::vector<CRSSparsity>& sp) const;
+
+    /// Remove stale temporary files and the least recently used entries until the cache is no larger than the maximum size
+    void evict() const;
+
+  private:
+    /// File name corresponding to a key
+    std::string fileName(const std::string& key) const;
+
+    /// Cache directory
+    std::string dir_;
+
+    /// Maximum total size in bytes
+    long max_size_;
+};
+
+} // namespace CasADi
+
+#endif // SPARSITY_CACHE_HPP
@@ -31,6 +31,7 @@
 #include "../sx/sx_node.hpp"
 #include "../sx/sx_tools.hpp"
 #include "mx_function.hpp"
+#include "serializer.hpp"
 
 namespace CasADi{
 
@@ -120,6 +121,11 @@ void SXFunction::generateCode(const string& filename){
   (*this)->generateCode(filename);
 }
 
+void SXFunction::evaluateBatch(const vector<vector<double> >& arg, vector<vector<double> >& res, int npoints){
+  assertInit();
+  (*this)->evaluateBatch(arg,res,npoints);
+}
+
 const vector<SXAlgEl>& SXFunction::algorithm() const{
   return (*this)->algorithm_;
 }
@@ -133,6 +139,20 @@ void SXFunction::clearSymbolic(){
   (*this)->clearSymbolic();
 }
 
+void SXFunction::save(const std::string& filename) const{
+  assertInit();
+  ofstream f(filename.c_str(),ios::binary);
+  casadi_assert_message(f.good(),"SXFunction::save: cannot open \"" << filename << "\" for writing");
+  Serializer s(f);
+  (*this)->save(s);
+}
+
+SXFunction SXFunction::load(const std::string& filename, bool symbolic){
+  MappedFile f(filename);
+  Deserializer d(f.data(),f.size());
+  return SXFunctionInternal::load(d,symbolic);
+}
+
 SXFunction::SXFunction(const MXFunction& f){
   MXFunction f2 = f;
   SXFunction t = f2.expand();
@@ -131,9 +131,20 @@ public:
   /** \brief Get all function outputs */
   const std::vector<SXMatrix> & outputExpr() const;
   
-  /** \brief Export / Generate C code for the function */
+  /** \brief Export / Generate C code for the function
+   * Besides evaluate, the file contains the entry points evaluateFwd and evaluateAdj, which calculate
+   * one forward or adjoint directional derivative, as well as jacobian and getJacSparsity, which
+   * return the nonzeros and the sparsity pattern of a Jacobian block with respect to the nonzeros
+   * of the inputs and outputs, in the same format as getSparsity.
+   */
   void generateCode(const std::string& filename);
   
+  /** \brief Evaluate the function numerically for several points at once
+   * The nonzeros of the inputs and outputs are stored in structure-of-arrays format,
+   * i.e. nonzero k of point p is located at index k*npoints + p.
+   */
+  void evaluateBatch(const std::vector<std::vector<double> >& arg, std::vector<std::vector<double> >& res, int npoints);
+  
 #ifndef SWIG
   /** \brief Access the algorithm directly */
   const std::vector<SXAlgEl>& algorithm() const;
@@ -162,6 +173,19 @@ public:
   
   /** \brief Clear the function from its symbolic representation, to free up memory, no symbolic evaluations are possible after this */
   void clearSymbolic();
+  
+  /** \brief Save the (initialized) function to a binary file
+   * The file contains the algorithm, the constants, the names of the free variables and of the inputs and the sparsity of the inputs and outputs.
+   */
+  void save(const std::string& filename) const;
+  
+  /** \brief Load an initialized function from a file written by save
+   * The file is memory-mapped and the algorithm is copied out of it as it is, without parsing it or creating any expressions.
+   * The function does not evaluate from the mapped memory, so loading still costs one copy of the algorithm. This is sufficient
+   * for numeric evaluation, directional derivatives and sparsity calculations. Set symbolic to true to recreate the expression
+   * graph as well, which is needed for symbolic operations such as jac, hess and evaluation with symbolic arguments.
+   */
+  static SXFunction load(const std::string& filename, bool symbolic=false);
  
   /** \brief Get all the free variables of the function */
   std::vector<SX> getFree() const;
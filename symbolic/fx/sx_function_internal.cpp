@@ -24,15 +24,36 @@
 #include <cassert>
 #include <limits>
 #include <stack>
+#include <queue>
 #include <deque>
 #include <fstream>
 #include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <cstring>
 #include "../stl_vector_tools.hpp"
+#include "code_generator.hpp"
+#include "serializer.hpp"
 #include "../sx/sx_tools.hpp"
 #include "../sx/sx_node.hpp"
 #include "../casadi_types.hpp"
 #include "../matrix/crs_sparsity_internal.hpp"
 
+#ifdef WITH_OPENMP
+#include <omp.h>
+#endif //WITH_OPENMP
+
+#ifdef WITH_THREADSAFE_SYMBOLICS
+#include <mutex>
+#endif // WITH_THREADSAFE_SYMBOLICS
+
+#ifdef WITH_DL
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // WITH_DL
+
 #ifdef WITH_LLVM
 #include "llvm/DerivedTypes.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
@@ -53,12 +74,66 @@ namespace CasADi{
 
 using namespace std;
 
+#ifdef WITH_THREADSAFE_SYMBOLICS
+// Serializes the use of the temporary markers of the nodes when sorting graphs, since nodes such as the constants 0 and 1 are shared between all graphs
+static std::mutex sort_mutex_;
+#endif // WITH_THREADSAFE_SYMBOLICS
+
+#ifdef WITH_DL
+/// Default directory for the binaries of "jit_compile": $XDG_CACHE_HOME/casadi_jit, $HOME/.cache/casadi_jit or /tmp/casadi_jit_<uid>
+static string jitDefaultCacheDir(){
+  const char* xdg = getenv("XDG_CACHE_HOME");
+  if(xdg && *xdg) return string(xdg) + "/casadi_jit";
+  const char* home = getenv("HOME");
+  if(home && *home){
+    string cache = string(home) + "/.cache";
+    mkdir(cache.c_str(),0700); // may already exist
+    return cache + "/casadi_jit";
+  }
+  stringstream ss;
+  ss << "/tmp/casadi_jit_" << getuid();
+  return ss.str();
+}
+
+/// Check that a file or directory is owned by the current user and cannot be written by anybody else
+static bool jitPrivate(const string& name, bool dir){
+  struct stat st;
+  if(lstat(name.c_str(),&st)!=0) return false;
+  if(dir ? !S_ISDIR(st.st_mode) : !S_ISREG(st.st_mode)) return false;
+  return st.st_uid==getuid() && (st.st_mode & (S_IWGRP | S_IWOTH))==0;
+}
+
+/// Create a new, empty file with a unique name in a directory, readable and writable only by the current user
+static string jitTempFile(const string& dir){
+  string name = dir + "/casadi_jit_XXXXXX";
+  vector<char> buf(name.begin(),name.end());
+  buf.push_back(0);
+  int fd = mkstemp(getPtr(buf));
+  casadi_assert_message(fd>=0,"SXFunctionInternal::init: Cannot create a temporary file in \"" << dir << "\"");
+  close(fd);
+  return string(getPtr(buf));
+}
+
+/// Quote a path for the shell
+static string jitQuote(const string& s){
+  string ret = "'";
+  for(string::const_iterator it=s.begin(); it!=s.end(); ++it){
+    if(*it=='\'') ret += "'\\''";
+    else ret += *it;
+  }
+  return ret + "'";
+}
+#endif // WITH_DL
+
 
 SXFunctionInternal::SXFunctionInternal(const vector<SXMatrix >& inputv, const vector<SXMatrix >& outputv) : 
   XFunctionInternal<SXFunction,SXFunctionInternal,SXMatrix,SXNode>(inputv,outputv) {
-  setOption("name","unnamed_sx_function");
-  addOption("just_in_time",OT_BOOLEAN,false,"Just-in-time compilation for numeric evaluation (experimental)");
-
+  addOptions();
+  
+#ifdef WITH_THREADSAFE_SYMBOLICS
+  std::unique_lock<std::mutex> sort_lock(sort_mutex_);
+#endif // WITH_THREADSAFE_SYMBOLICS
+  
   // Check for duplicate entries among the input expressions
   bool has_duplicates = false;
   for(vector<SXMatrix >::iterator it = inputv_.begin(); it != inputv_.end(); ++it){
@@ -78,6 +153,9 @@ SXFunctionInternal::SXFunctionInternal(const vector<SXMatrix >& inputv, const ve
       itc->setTemp(0);
     }
   }
+#ifdef WITH_THREADSAFE_SYMBOLICS
+  sort_lock.unlock();
+#endif // WITH_THREADSAFE_SYMBOLICS
   
   if(has_duplicates){
     cout << "Input expressions:" << endl;
@@ -90,10 +168,80 @@ SXFunctionInternal::SXFunctionInternal(const vector<SXMatrix >& inputv, const ve
   casadi_assert(!outputv_.empty()); // NOTE: Remove?
 }
 
+SXFunctionInternal::SXFunctionInternal(const vector<CRSSparsity>& input_sparsity, const vector<CRSSparsity>& output_sparsity) : 
+  XFunctionInternal<SXFunction,SXFunctionInternal,SXMatrix,SXNode>(vector<SXMatrix>(),vector<SXMatrix>()) {
+  addOptions();
+  
+  // Allocate space for inputs and outputs
+  setNumInputs(input_sparsity.size());
+  for(int i=0; i<input_sparsity.size(); ++i)
+    input(i) = DMatrix(input_sparsity[i]);
+  setNumOutputs(output_sparsity.size());
+  for(int i=0; i<output_sparsity.size(); ++i)
+    output(i) = DMatrix(output_sparsity[i]);
+}
+
+void SXFunctionInternal::addOptions(){
+  setOption("name","unnamed_sx_function");
+  vectorized_sweeps_ = false;
+  super_ = false;
+  checkpointing_ = false;
+  parallel_ = false;
+  jit_compile_ = false;
+  addOption("just_in_time",OT_BOOLEAN,false,"Just-in-time compilation for numeric evaluation (experimental)");
+  addOption("jit_compile",OT_BOOLEAN,false,"Generate C code for the function, compile it with the system C compiler and load the result dynamically (requires CasADi to be compiled with WITH_DL=ON)");
+  addOption("jit_compiler",OT_STRING,"gcc","C compiler used with \"jit_compile\"");
+  addOption("jit_flags",OT_STRING,"-O2","Compiler flags used with \"jit_compile\"");
+  addOption("jit_cache_dir",OT_STRING,"","Directory where the compiled functions are stored and reused between runs, keyed by the generated code. Must be owned by the current user and not writable by group or others. Default: $XDG_CACHE_HOME/casadi_jit, $HOME/.cache/casadi_jit or /tmp/casadi_jit_<uid>, created with mode 0700");
+  addOption("parallelization",OT_STRING,"serial","Evaluate the operations of the algorithm that do not depend on each other in parallel, level by level (the levels are evaluated by a single thread unless CasADi is compiled with WITH_OPENMP=ON)","serial|openmp");
+  addOption("superinstructions",OT_BOOLEAN,false,"Evaluate using a denser bytecode with fused multiply-add, square and negation chains and inline constants when no derivatives are requested");
+  addOption("tape_memory_limit",OT_REAL,0.0,"Memory limit in MB for the partial derivatives stored for sensitivity analysis. If the complete tape does not fit, checkpoints of the work vector are stored at the beginning of algorithm segments and the partial derivatives are recalculated segment by segment during the backward sweep. Zero means no limit.");
+  addOption("vectorized_sweeps",OT_BOOLEAN,false,"Propagate all forward/adjoint directions in a single sweep through the algorithm, using a direction-contiguous work vector. Always true when the tape is checkpointed, see \"tape_memory_limit\"");
+  addOption("scheduling",OT_STRING,"none","Reorder the algorithm after sorting. \"locality\" evaluates each operation as soon as its arguments are available, so that values are used shortly after they have been calculated, and loads constants and inputs just before they are first needed","none|locality");
+  addOption("work_allocation",OT_STRING,"stack","Assignment of the elements of the work vector. \"stack\" reuses the most recently freed element, \"linear_scan\" the lowest numbered free element, which keeps the work vector small and the active elements close together","stack|linear_scan");
+}
+
 SXFunctionInternal::~SXFunctionInternal(){
 }
 
 void SXFunctionInternal::evaluate(int nfdir, int nadir){
+  // Evaluate the compiled function
+  if(jit_compile_ && nfdir==0 && nadir==0){
+    for(int ind=0; ind<getNumInputs(); ++ind){
+      jit_fcn_.input(ind).set(inputNoCheck(ind));
+    }
+    jit_fcn_.evaluate();
+    for(int ind=0; ind<getNumOutputs(); ++ind){
+      jit_fcn_.output(ind).get(outputNoCheck(ind));
+    }
+    return;
+  }
+  
+  // Re-execute only the operations affected by the inputs that changed
+  if(incremental_ && nfdir==0 && nadir==0){
+    evaluateIncremental();
+    return;
+  }
+  inc_valid_ = false;
+  
+  // Level scheduled evaluation
+  if(parallel_){
+    evaluateParallel(nfdir,nadir);
+    return;
+  }
+  
+  // Checkpointed tape
+  if(checkpointing_ && (nfdir>0 || nadir>0)){
+    evaluateCheckpointed(nfdir,nadir);
+    return;
+  }
+  
+  // Fused bytecode, no taping
+  if(super_ && nfdir==0 && nadir==0){
+    evaluateSuper();
+    return;
+  }
+  
   // Compiletime optimization for certain common cases
   switch(nfdir){
     case 0:
@@ -186,6 +334,23 @@ void SXFunctionInternal::evaluateGen(T1 nfdir_c, T2 nadir_c){
   // Quick return if no sensitivities
   if(!taping) return;
 
+  // Propagate all directions at once, if requested
+  if(vectorized_sweeps_ && (nfdir>1 || nadir>1)){
+    // Make sure that the work vector is large enough
+    const int ndir_max = std::max(nfdir,nadir);
+    if(dwork_.size()<work_.size()*ndir_max) dwork_.resize(work_.size()*ndir_max);
+    
+    // Calculate forward sensitivities, the directions for each work element are stored contiguously
+    if(nfdir>0) propagateFwd(0,algorithm_.size(),getPtr(pdwork_),nfdir);
+    
+    // Calculate adjoint sensitivities
+    if(nadir>0){
+      fill(dwork_.begin(),dwork_.begin()+work_.size()*nadir,0);
+      propagateAdj(0,algorithm_.size(),getPtr(pdwork_)+pdwork_.size(),nadir);
+    }
+    return;
+  }
+  
   // Calculate forward sensitivities
   for(int dir=0; dir<nfdir; ++dir){
     vector<TapeEl<double> >::const_iterator it2 = pdwork_.begin();
@@ -231,6 +396,343 @@ void SXFunctionInternal::evaluateGen(T1 nfdir_c, T2 nadir_c){
   }
 }
 
+void SXFunctionInternal::propagateFwd(int alg_begin, int alg_end, const TapeEl<double>* pd, int nfdir){
+  double *dwork = getPtr(dwork_);
+  vector<AlgEl>::const_iterator it_end = algorithm_.begin()+alg_end;
+  for(vector<AlgEl>::const_iterator it = algorithm_.begin()+alg_begin; it!=it_end; ++it){
+    double *r = dwork + it->res*nfdir;
+    switch(it->op){
+      case OP_CONST:
+        for(int dir=0; dir<nfdir; ++dir) r[dir] = 0; 
+        break;
+      case OP_INPUT: 
+        for(int dir=0; dir<nfdir; ++dir) r[dir] = fwdSeedNoCheck(it->arg.i[0],dir).data()[it->arg.i[1]]; 
+        break;
+      case OP_OUTPUT:
+        r = dwork + it->arg.i[0]*nfdir;
+        for(int dir=0; dir<nfdir; ++dir) fwdSensNoCheck(it->res,dir).data()[it->arg.i[1]] = r[dir]; 
+        break;
+      default: // Unary or binary operation
+      {
+        // Load the partial derivatives once for all directions
+        const double d0 = pd->d[0], d1 = pd->d[1];
+        const double *a0 = dwork + it->arg.i[0]*nfdir;
+        const double *a1 = dwork + it->arg.i[1]*nfdir;
+        for(int dir=0; dir<nfdir; ++dir) r[dir] = d0*a0[dir] + d1*a1[dir];
+        ++pd; 
+        break;
+      }
+    }
+  }
+}
+
+void SXFunctionInternal::propagateAdj(int alg_begin, int alg_end, const TapeEl<double>* pd_end, int nadir){
+  double *dwork = getPtr(dwork_);
+  const TapeEl<double>* pd = pd_end;
+  vector<AlgEl>::const_reverse_iterator it_end(algorithm_.begin()+alg_begin);
+  for(vector<AlgEl>::const_reverse_iterator it(algorithm_.begin()+alg_end); it!=it_end; ++it){
+    double *r = dwork + it->res*nadir;
+    switch(it->op){
+      case OP_CONST:
+        for(int dir=0; dir<nadir; ++dir) r[dir] = 0;
+        break;
+      case OP_INPUT:
+        for(int dir=0; dir<nadir; ++dir){
+          adjSensNoCheck(it->arg.i[0],dir).data()[it->arg.i[1]] = r[dir];
+          r[dir] = 0;
+        }
+        break;
+      case OP_OUTPUT:
+        r = dwork + it->arg.i[0]*nadir;
+        for(int dir=0; dir<nadir; ++dir) r[dir] += adjSeedNoCheck(it->res,dir).data()[it->arg.i[1]];
+        break;
+      default: // Unary or binary operation
+      {
+        // Load the partial derivatives once for all directions
+        --pd;
+        const double d0 = pd->d[0], d1 = pd->d[1];
+        double *a0 = dwork + it->arg.i[0]*nadir;
+        double *a1 = dwork + it->arg.i[1]*nadir;
+        for(int dir=0; dir<nadir; ++dir){
+          const double seed = r[dir];
+          r[dir] = 0;
+          a0[dir] += d0*seed;
+          a1[dir] += d1*seed;
+        }
+      }
+    }
+  }
+}
+
+void SXFunctionInternal::evaluateSegment(int alg_begin, int alg_end){
+  vector<TapeEl<double> >::iterator it1 = pdwork_.begin();
+  vector<AlgEl>::const_iterator it_end = algorithm_.begin()+alg_end;
+  for(vector<AlgEl>::const_iterator it = algorithm_.begin()+alg_begin; it!=it_end; ++it){
+    switch(it->op){
+      // Start by adding all of the built operations
+      CASADI_MATH_DERF_BUILTIN(work_[it->arg.i[0]],work_[it->arg.i[1]],work_[it->res],it1++->d)
+
+      // Constant
+      case OP_CONST: work_[it->res] = it->arg.d; break;
+
+      // Load function input to work vector
+      case OP_INPUT: work_[it->res] = inputNoCheck(it->arg.i[0]).data()[it->arg.i[1]]; break;
+      
+      // Get function output from work vector
+      case OP_OUTPUT: outputNoCheck(it->res).data()[it->arg.i[1]] = work_[it->arg.i[0]]; break;
+    }
+  }
+}
+
+void SXFunctionInternal::evaluateCheckpointed(int nfdir, int nadir){
+  if (!free_vars_.empty()) {
+    std::stringstream ss;
+    repr(ss);
+    casadi_error("Cannot evaluate \"" << ss.str() << "\" since variables " << free_vars_ << " are free.");
+  }
+
+  // Make sure that the work vector for the directions is large enough
+  const int ndir_max = std::max(nfdir,nadir);
+  if(dwork_.size()<work_.size()*ndir_max) dwork_.resize(work_.size()*ndir_max);
+  
+  // Number of segments
+  int nseg = seg_begin_.size()-1;
+  
+  // Forward sweep: save the work vector at the beginning of each segment, then evaluate the segment and propagate the forward seeds
+  for(int seg=0; seg<nseg; ++seg){
+    if(seg>0) copy(work_.begin(),work_.end(),ckpt_.begin()+(seg-1)*work_.size());
+    evaluateSegment(seg_begin_[seg],seg_begin_[seg+1]);
+    if(nfdir>0) propagateFwd(seg_begin_[seg],seg_begin_[seg+1],getPtr(pdwork_),nfdir);
+  }
+  if(nadir==0) return;
+  
+  // Backward sweep: restore the checkpoint, recalculate the partial derivatives of the segment and propagate the adjoint seeds
+  fill(dwork_.begin(),dwork_.begin()+work_.size()*nadir,0);
+  for(int seg=nseg-1; seg>=0; --seg){
+    if(seg<nseg-1){ // The partial derivatives of the last segment are still available
+      if(seg>0) copy(ckpt_.begin()+(seg-1)*work_.size(),ckpt_.begin()+seg*work_.size(),work_.begin());
+      evaluateSegment(seg_begin_[seg],seg_begin_[seg+1]);
+    }
+    propagateAdj(seg_begin_[seg],seg_begin_[seg+1],getPtr(pdwork_)+seg_ntape_[seg],nadir);
+  }
+}
+
+/// Memory in bytes needed for the checkpoints and the partial derivatives of one segment, for an algorithm of length n, a work vector of length nwork, segments of length len and tape elements of sz_t bytes
+static double checkpointMemory(int n, int nwork, int len, int sz_t){
+  return (double((n+len-1)/len)-1)*nwork*sizeof(double) + double(len)*sz_t;
+}
+
+void SXFunctionInternal::initCheckpointing(double budget){
+  int n = algorithm_.size();
+  int nwork = work_.size();
+  
+  // Segment length minimizing the memory
+  const int sz_d = sizeof(double), sz_t = sizeof(TapeEl<double>);
+  int len_min = std::max(1,std::min(n,int(sqrt(double(n)*nwork*sz_d/sz_t))));
+  
+  // The longest segments, i.e. the fewest checkpoints, within the budget
+  int len = len_min;
+  if(checkpointMemory(n,nwork,len_min,sz_t)>budget){
+    casadi_warning("SXFunctionInternal::initCheckpointing: the tape cannot be made smaller than " << checkpointMemory(n,nwork,len_min,sz_t) << " bytes, exceeding \"tape_memory_limit\"");
+  } else {
+    int len_max = n;
+    while(len<len_max){
+      int len_mid = len + (len_max-len+1)/2;
+      if(checkpointMemory(n,nwork,len_mid,sz_t)<=budget){
+        len = len_mid;
+      } else {
+        len_max = len_mid-1;
+      }
+    }
+  }
+  double mem = checkpointMemory(n,nwork,len,sz_t);
+  
+  // Segments and the number of partial derivatives in each
+  seg_begin_.clear();
+  seg_ntape_.clear();
+  int max_ntape = 0;
+  for(int k=0; k<n; k+=len){
+    seg_begin_.push_back(k);
+    int ntape = 0;
+    for(int i=k; i<std::min(k+len,n); ++i){
+      int op = algorithm_[i].op;
+      if(op!=OP_CONST && op!=OP_INPUT && op!=OP_OUTPUT) ntape++;
+    }
+    seg_ntape_.push_back(ntape);
+    max_ntape = std::max(max_ntape,ntape);
+  }
+  seg_begin_.push_back(n);
+  
+  // Allocate memory
+  pdwork_.resize(max_ntape);
+  ckpt_.resize((seg_begin_.size()-2)*nwork);
+  
+  stats_["tape_segments"] = int(seg_ntape_.size());
+  stats_["tape_segment_length"] = len;
+  stats_["tape_memory"] = mem;
+  if(verbose()){
+    cout << "SXFunctionInternal::initCheckpointing: " << seg_ntape_.size() << " segments of " << len << " operations, "
+         << mem << " bytes instead of " << double(accumulate(seg_ntape_.begin(),seg_ntape_.end(),0))*sz_t << " bytes" << endl;
+  }
+}
+
+void SXFunctionInternal::initIncremental(){
+  // Inputs that each element of the work vector depends on, one bit per input
+  const int nw = (getNumInputs()+bvec_size-1)/bvec_size;
+  vector<bvec_t> wdep(work_.size()*nw,0), dep(nw);
+  inc_ops_.assign(getNumInputs(),vector<int>());
+  for(int k=0; k<algorithm_.size(); ++k){
+    const AlgEl& e = algorithm_[k];
+    fill(dep.begin(),dep.end(),bvec_t(0));
+    switch(e.op){
+      case OP_CONST:
+      case OP_PARAMETER:
+        break;
+      case OP_INPUT:
+        dep[e.arg.i[0]/bvec_size] = bvec_t(1) << (e.arg.i[0]%bvec_size);
+        break;
+      case OP_OUTPUT:
+        copy(wdep.begin()+e.arg.i[0]*nw,wdep.begin()+(e.arg.i[0]+1)*nw,dep.begin());
+        break;
+      default:
+        for(int c=0; c<casadi_math<double>::ndeps(e.op); ++c){
+          for(int i=0; i<nw; ++i) dep[i] |= wdep[e.arg.i[c]*nw+i];
+        }
+    }
+    if(e.op!=OP_OUTPUT) copy(dep.begin(),dep.end(),wdep.begin()+e.res*nw);
+    
+    // Add to the list of each input the operation depends on
+    for(int i=0; i<nw; ++i){
+      bvec_t b = dep[i];
+      for(int ind=i*bvec_size; b!=0; ++ind, b>>=1){
+        if(b & 1) inc_ops_[ind].push_back(k);
+      }
+    }
+  }
+}
+
+void SXFunctionInternal::evaluateIncremental(){
+  // Evaluate everything the first time or if the work vector has been used for something else
+  if(!incrementalOps(inc_buf_)){
+    evaluateGen(int_compiletime<0>(),int_compiletime<0>());
+    return;
+  }
+  
+  // Re-execute the affected operations, the other elements of the work vector are still valid
+  evaluateOps(inc_buf_);
+}
+
+void SXFunctionInternal::evaluateOps(const std::vector<int>& ops){
+  if (!free_vars_.empty()) {
+    std::stringstream ss;
+    repr(ss);
+    casadi_error("Cannot evaluate \"" << ss.str() << "\" since variables " << free_vars_ << " are free.");
+  }
+  
+  for(vector<int>::const_iterator k=ops.begin(); k!=ops.end(); ++k){
+    const AlgEl* it = &algorithm_[*k];
+    switch(it->op){
+      CASADI_MATH_FUN_BUILTIN(work_[it->arg.i[0]],work_[it->arg.i[1]],work_[it->res])
+      case OP_CONST: work_[it->res] = it->arg.d; break;
+      case OP_INPUT: work_[it->res] = inputNoCheck(it->arg.i[0]).data()[it->arg.i[1]]; break;
+      case OP_OUTPUT: outputNoCheck(it->res).data()[it->arg.i[1]] = work_[it->arg.i[0]]; break;
+    }
+  }
+}
+
+void SXFunctionInternal::evaluateSlice(const std::vector<int>& ops){
+  if(super_){
+    evaluateSuper(ops);
+  } else {
+    evaluateOps(ops);
+  }
+}
+
+bool SXFunctionInternal::sliceWorthwhile(const std::vector<int>& ops) const{
+  if(jit_compile_ || parallel_) return false;
+  
+  // Skip at least a quarter of the operations
+  return 4*ops.size() <= 3*(super_ ? super_alg_.size() : algorithm_.size());
+}
+
+std::vector<int> SXFunctionInternal::outputSlice(const std::vector<int>& oind) const{
+  vector<bool> requested(getNumOutputs(),false);
+  for(vector<int>::const_iterator it=oind.begin(); it!=oind.end(); ++it) requested[*it] = true;
+  
+  // Backward sweep marking the elements of the work vector needed, an element is no longer needed before the operation assigning it
+  vector<bool> needed(work_.size(),false);
+  vector<int> ret;
+  for(int k=algorithm_.size()-1; k>=0; --k){
+    const AlgEl& e = algorithm_[k];
+    if(e.op==OP_OUTPUT){
+      if(!requested[e.res]) continue;
+      needed[e.arg.i[0]] = true;
+    } else {
+      if(!needed[e.res]) continue;
+      needed[e.res] = false;
+      if(e.op!=OP_CONST && e.op!=OP_PARAMETER && e.op!=OP_INPUT){
+        for(int c=0; c<casadi_math<double>::ndeps(e.op); ++c) needed[e.arg.i[c]] = true;
+      }
+    }
+    ret.push_back(k);
+  }
+  reverse(ret.begin(),ret.end());
+  
+  // An operation fused into a superinstruction is only used by it, so the superinstructions needed are those of the operations needed
+  if(super_){
+    vector<bool> in_slice(algorithm_.size(),false);
+    for(vector<int>::const_iterator it=ret.begin(); it!=ret.end(); ++it) in_slice[*it] = true;
+    ret.clear();
+    for(int k=0; k<super_src_.size(); ++k){
+      if(in_slice[super_src_[k]]) ret.push_back(k);
+    }
+  }
+  return ret;
+}
+
+void SXFunctionInternal::evaluateBatch(const vector<vector<double> >& arg, vector<vector<double> >& res, int npoints){
+  casadi_assert_message(npoints>=0,"SXFunctionInternal::evaluateBatch: Number of points must be nonnegative");
+  if (!free_vars_.empty()) {
+    std::stringstream ss;
+    repr(ss);
+    casadi_error("Cannot evaluate \"" << ss.str() << "\" since variables " << free_vars_ << " are free.");
+  }
+  
+  // Check the dimensions of the inputs
+  casadi_assert_message(arg.size()==getNumInputs(),"SXFunctionInternal::evaluateBatch: Wrong number of inputs. Expecting " << getNumInputs() << ", got " << arg.size());
+  for(int ind=0; ind<arg.size(); ++ind){
+    casadi_assert_message(arg[ind].size()==input(ind).size()*npoints,"SXFunctionInternal::evaluateBatch: Dimension mismatch for input " << ind << ". Expecting " << input(ind).size() << "*" << npoints << " elements, got " << arg[ind].size());
+  }
+  
+  // Allocate the outputs
+  res.resize(getNumOutputs());
+  for(int ind=0; ind<res.size(); ++ind){
+    res[ind].resize(output(ind).size()*npoints);
+  }
+  if(npoints==0) return;
+  
+  // Work vector with each element widened to npoints lanes
+  bwork_.resize(work_.size()*npoints);
+  double *w = getPtr(bwork_);
+  
+  // Evaluate the algorithm, one operation for all points at a time
+  for(vector<AlgEl>::const_iterator it = algorithm_.begin(); it!=algorithm_.end(); ++it){
+    switch(it->op){
+      case OP_CONST:
+        std::fill(w+it->res*npoints,w+(it->res+1)*npoints,it->arg.d);
+        break;
+      case OP_INPUT:
+        copy(arg[it->arg.i[0]].begin()+it->arg.i[1]*npoints,arg[it->arg.i[0]].begin()+(it->arg.i[1]+1)*npoints,w+it->res*npoints);
+        break;
+      case OP_OUTPUT:
+        copy(w+it->arg.i[0]*npoints,w+(it->arg.i[0]+1)*npoints,res[it->res].begin()+it->arg.i[1]*npoints);
+        break;
+      default:
+        casadi_math<double>::fun(it->op,w+it->arg.i[0]*npoints,w+it->arg.i[1]*npoints,w+it->res*npoints,npoints);
+    }
+  }
+}
+
 SXMatrix SXFunctionInternal::hess(int iind, int oind){
   casadi_assert_message(output(oind).numel() == 1, "Function must be scalar");
   SXMatrix g = grad(iind,oind);
@@ -316,22 +818,12 @@ void SXFunctionInternal::print(ostream &stream) const{
 }
 
 void SXFunctionInternal::printVector(std::ostream &cfile, const std::string& name, const vector<int>& v){
-  cfile << "int " << name << "[] = {";
-  for(int i=0; i<v.size(); ++i){
-    if(i!=0) cfile << ",";
-    cfile << v[i];
-  }
-  cfile << "};" << endl;
+  CodeGenerator::printVector(cfile,name,v);
 }
 
 void SXFunctionInternal::generateCode(const string& src_name){
   assertInit();
   
-  // Make sure that there are no free variables
-  if (!free_vars_.empty()) {
-    casadi_error("Code generation is not possible since variables " << free_vars_ << " are free.");
-  }
-  
    // Output
   if(verbose()){
     cout << "Generating: " << src_name << " (" << algorithm_.size() << " elementary operations)" << endl;
@@ -339,6 +831,18 @@ void SXFunctionInternal::generateCode(const string& src_name){
   // Create the c source file
   ofstream cfile;
   cfile.open (src_name.c_str());
+  generateCode(cfile,true);
+  
+  // Close the results file
+  cfile.close();
+}
+
+void SXFunctionInternal::generateCode(std::ostream &cfile, bool with_derivatives){
+  // Make sure that there are no free variables
+  if (!free_vars_.empty()) {
+    casadi_error("Code generation is not possible since variables " << free_vars_ << " are free.");
+  }
+  
   cfile.precision(numeric_limits<double>::digits10+2);
   cfile << scientific; // This is really only to force a decimal dot, would be better if it can be avoided
   
@@ -349,84 +853,23 @@ void SXFunctionInternal::generateCode(const string& src_name){
   // Space saving macro
   cfile << "#define d double" << endl << endl;
 
-  // Number of inputs/outputs
-  int n_i = input_.size();
-  int n_o = output_.size();
-  int n_io = n_i + n_o;
-
-  // Dimensions
-  cfile << "int n_in_ = " << n_i << ";" << endl;
-  cfile << "int n_out_ = " << n_o << ";" << endl;
-
-  // Number of rows and columns
-  vector<int> nrow(n_io), ncol(n_io);
-  for(int i=0; i<n_i; ++i){
-    nrow[i] = input(i).size1();
-    ncol[i] = input(i).size2();
-  }
-  for(int i=0; i<n_o; ++i){
-    nrow[i+n_i] = output(i).size1();
-    ncol[i+n_i] = output(i).size2();
-  }
-  
-  // Print to file
-  printVector(cfile,"nrow_",nrow);
-  printVector(cfile,"ncol_",ncol);
-  
-  // Print row offsets
-  for(int i=0; i<n_io; ++i){
-    stringstream name;
-    name << "rowind_" << i << "_";
-    const vector<int>& rowind = i<n_i ? input(i).rowind() : output(i-n_i).rowind();
-    printVector(cfile,name.str(),rowind);
-  }
-  
-  // Array of pointers to the arrays above
-  cfile << "int *rowind_[] = {";
-  for(int i=0; i<n_io; ++i){
-    if(i!=0) cfile << ",";
-    cfile << "rowind_" << i << "_"; 
-  }
-  cfile << "};" << endl;
-  
-  // Print columns
-  for(int i=0; i<n_io; ++i){
-    stringstream name;
-    name << "col_" << i << "_";
-    const vector<int>& col = i<n_i ? input(i).col() : output(i-n_i).col();
-    printVector(cfile,name.str(),col);
-  }
-  
-  // Array of pointers to the arrays above
-  cfile << "int *col_[] = {";
-  for(int i=0; i<n_io; ++i){
-    if(i!=0) cfile << ",";
-    cfile << "col_" << i << "_"; 
-  }
-  cfile << "};" << endl << endl;
-  
-  // Function to get dimensions
-  cfile << "int init(int *n_in, int *n_out){" << endl;
-  cfile << "  *n_in = n_in_;" << endl;
-  cfile << "  *n_out = n_out_;" << endl;
-  cfile << "  return 0;" << endl;
-  cfile << "}" << endl << endl;
-
-  // Input sizes
-  cfile << "int getSparsity(int i, int *nrow, int *ncol, int **rowind, int **col){" << endl;
-  cfile << "  *nrow = nrow_[i];" << endl;
-  cfile << "  *ncol = ncol_[i];" << endl;
-  cfile << "  *rowind = rowind_[i];" << endl;
-  cfile << "  *col = col_[i];" << endl;
-  cfile << "  return 0;" << endl;
-  cfile << "}" << endl << endl;
+  // Dimensions and sparsity patterns of the inputs and outputs
+  generateInterface(cfile);
 
   // The sign function
   cfile << "double sign(double x){ return x<0 ? -1 : x>0 ? 1 : x;}" << endl << endl;
   
   // Evaluate function
   cfile << "int evaluate(const double** x, double** r){" << endl;
+  generateBody(cfile);
+  cfile << "return 0;" << endl;
+  cfile << "}" << endl << endl;
+  
+  // Derivative functions
+  if(with_derivatives) generateDerivatives(cfile);
+}
 
+void SXFunctionInternal::generateBody(std::ostream &cfile) const{
   // Which variables have been declared
   vector<bool> declared(work_.size(),false);
  
@@ -461,18 +904,129 @@ void SXFunctionInternal::generateCode(const string& src_name){
    }
    cfile  << ";" << endl;
  }
+}
 
-  cfile << "return 0;" << endl;
+void SXFunctionInternal::generateDerivatives(std::ostream &cfile){
+  casadi_assert_message(inputv_.size()==getNumInputs(),"Code generation of derivatives is not possible after clearSymbolic has been called.");
+  int n_i = input_.size();
+  int n_o = output_.size();
+  
+  // Symbolic seeds
+  vector<vector<SXMatrix> > fseed(1,vector<SXMatrix>(n_i)), fsens(1), aseed(1,vector<SXMatrix>(n_o)), asens(1), dummy;
+  for(int i=0; i<n_i; ++i) fseed[0][i] = ssym("fseed",input(i).sparsity());
+  for(int i=0; i<n_o; ++i) aseed[0][i] = ssym("aseed",output(i).sparsity());
+  
+  // Forward and adjoint sensitivities by source code transformation
+  vector<SXMatrix> res = outputv_;
+  evalSX(inputv_,res,fseed,fsens,dummy,dummy,true);
+  evalSX(inputv_,res,dummy,dummy,aseed,asens,true);
+  
+  // Generate a function for each with the seeds appended to the inputs and the sensitivities appended to the outputs
+  for(int dir=0; dir<2; ++dir){
+    const string name = dir==0 ? "evaluateFwd" : "evaluateAdj";
+    const vector<SXMatrix>& seed = dir==0 ? fseed[0] : aseed[0];
+    const vector<SXMatrix>& sens = dir==0 ? fsens[0] : asens[0];
+    vector<SXMatrix> d_in = inputv_, d_out = outputv_;
+    d_in.insert(d_in.end(),seed.begin(),seed.end());
+    d_out.insert(d_out.end(),sens.begin(),sens.end());
+    SXFunction d_fcn(d_in,d_out);
+    d_fcn.init();
+    
+    cfile << "static int " << name << "_(const double** x, double** r){" << endl;
+    d_fcn->generateBody(cfile);
+    cfile << "return 0;" << endl;
+    cfile << "}" << endl << endl;
+    
+    // Wrapper with separate arguments for the seeds and sensitivities
+    cfile << "int " << name << "(const double** x, double** r, const double** seed, double** sens){" << endl;
+    cfile << "  const double* xx[" << std::max(d_in.size(),size_t(1)) << "];" << endl;
+    cfile << "  double* rr[" << std::max(d_out.size(),size_t(1)) << "];" << endl;
+    cfile << "  int i;" << endl;
+    cfile << "  for(i=0; i<" << n_i << "; ++i) xx[i] = x[i];" << endl;
+    cfile << "  for(i=0; i<" << seed.size() << "; ++i) xx[i+" << n_i << "] = seed[i];" << endl;
+    cfile << "  for(i=0; i<" << n_o << "; ++i) rr[i] = r[i];" << endl;
+    cfile << "  for(i=0; i<" << sens.size() << "; ++i) rr[i+" << n_o << "] = sens[i];" << endl;
+    cfile << "  return " << name << "_(xx,rr);" << endl;
+    cfile << "}" << endl << endl;
+  }
+  
+  // Jacobian blocks, with respect to the nonzeros of the inputs and outputs
+  vector<int> jac_nrow(n_i*n_o), jac_ncol(n_i*n_o);
+  for(int oind=0; oind<n_o; ++oind){
+    for(int iind=0; iind<n_i; ++iind){
+      int k = iind*n_o + oind;
+      SXMatrix J = jac(iind,oind,true);
+      jac_nrow[k] = J.size1();
+      jac_ncol[k] = J.size2();
+      
+      stringstream name;
+      name << "jac_rowind_" << k << "_";
+      printVector(cfile,name.str(),J.rowind());
+      name.str("");
+      name << "jac_col_" << k << "_";
+      printVector(cfile,name.str(),J.size()==0 ? vector<int>(1,0) : J.col()); // arrays in C cannot be empty
+      
+      // Function evaluating the nonzeros of the block
+      SXFunction j_fcn(inputv_,J);
+      j_fcn.init();
+      cfile << "static int jacobian_" << k << "_(const double** x, double** r){" << endl;
+      j_fcn->generateBody(cfile);
+      cfile << "return 0;" << endl;
+      cfile << "}" << endl << endl;
+    }
+  }
+  
+  // Arrays in C cannot be empty, add a dummy element if the function has no inputs or no outputs
+  if(n_i*n_o==0){
+    jac_nrow.push_back(0);
+    jac_ncol.push_back(0);
+  }
+  printVector(cfile,"jac_nrow_",jac_nrow);
+  printVector(cfile,"jac_ncol_",jac_ncol);
+  
+  // Array of pointers to the arrays above
+  cfile << "int *jac_rowind_[] = {";
+  for(int k=0; k<n_i*n_o; ++k){
+    if(k!=0) cfile << ",";
+    cfile << "jac_rowind_" << k << "_"; 
+  }
+  if(n_i*n_o==0) cfile << "0";
+  cfile << "};" << endl;
+  cfile << "int *jac_col_[] = {";
+  for(int k=0; k<n_i*n_o; ++k){
+    if(k!=0) cfile << ",";
+    cfile << "jac_col_" << k << "_"; 
+  }
+  if(n_i*n_o==0) cfile << "0";
+  cfile << "};" << endl << endl;
+  
+  // Sparsity of the Jacobian blocks
+  cfile << "int getJacSparsity(int iind, int oind, int *nrow, int *ncol, int **rowind, int **col){" << endl;
+  cfile << "  int k = iind*n_out_ + oind;" << endl;
+  cfile << "  *nrow = jac_nrow_[k];" << endl;
+  cfile << "  *ncol = jac_ncol_[k];" << endl;
+  cfile << "  *rowind = jac_rowind_[k];" << endl;
+  cfile << "  *col = jac_col_[k];" << endl;
+  cfile << "  return 0;" << endl;
   cfile << "}" << endl << endl;
   
-  // Close the results file
-  cfile.close();
+  // Evaluate the nonzeros of a Jacobian block
+  cfile << "int jacobian(int iind, int oind, const double** x, double* J){" << endl;
+  cfile << "  double* r[1];" << endl;
+  cfile << "  r[0] = J;" << endl;
+  cfile << "  switch(iind*n_out_ + oind){" << endl;
+  for(int k=0; k<n_i*n_o; ++k){
+    cfile << "    case " << k << ": return jacobian_" << k << "_(x,r);" << endl;
+  }
+  cfile << "  }" << endl;
+  cfile << "  return 1;" << endl;
+  cfile << "}" << endl << endl;
 }
 
-void SXFunctionInternal::init(){
-  
-  // Call the init function of the base class
-  XFunctionInternal<SXFunction,SXFunctionInternal,SXMatrix,SXNode>::init();
+void SXFunctionInternal::sortAlgorithm(){
+#ifdef WITH_THREADSAFE_SYMBOLICS
+  std::unique_lock<std::mutex> sort_lock(sort_mutex_);
+#endif // WITH_THREADSAFE_SYMBOLICS
   
   // Stack used to sort the computational graph
   stack<SXNode*> s;
@@ -525,6 +1079,18 @@ void SXFunctionInternal::init(){
   
   // Use live variables?
   bool live_variables = getOption("live_variables");
+  
+  // Operations evaluated simultaneously must not share elements of the work vector
+  if(parallel_ && live_variables){
+    if(verbose()) cout << "SXFunctionInternal::init: live variables disabled for parallel evaluation" << endl;
+    live_variables = false;
+  }
+  
+  // The intermediate values must be kept between incremental evaluations
+  if(incremental_ && live_variables){
+    if(verbose()) cout << "SXFunctionInternal::init: live variables disabled for incremental evaluation" << endl;
+    live_variables = false;
+  }
 
   // Input instructions
   vector<pair<int,SXNode*> > symb_loc;
@@ -669,38 +1235,318 @@ void SXFunctionInternal::init(){
     it->second->temp = it->first+1;
   }
   
-  // Add input instructions
-  for(int ind=0; ind<inputv_.size(); ++ind){
-    int nz=0;
-    for(vector<SX>::iterator itc = inputv_[ind].begin(); itc != inputv_[ind].end(); ++itc, ++nz){
-      int i = itc->getTemp()-1;
-      if(i>=0){
-        // Mark as input
-        algorithm_[i].op = OP_INPUT;
-        
-        // Location of the input
-        algorithm_[i].arg.i[0] = ind;
-        algorithm_[i].arg.i[1] = nz;
-        
-        // Mark input as read
-        itc->setTemp(0);
-      }
+  // Add input instructions
+  for(int ind=0; ind<inputv_.size(); ++ind){
+    int nz=0;
+    for(vector<SX>::iterator itc = inputv_[ind].begin(); itc != inputv_[ind].end(); ++itc, ++nz){
+      int i = itc->getTemp()-1;
+      if(i>=0){
+        // Mark as input
+        algorithm_[i].op = OP_INPUT;
+        
+        // Location of the input
+        algorithm_[i].arg.i[0] = ind;
+        algorithm_[i].arg.i[1] = nz;
+        
+        // Mark input as read
+        itc->setTemp(0);
+      }
+    }
+  }
+  
+  // Locate free variables
+  free_vars_.clear();
+  for(vector<pair<int,SXNode*> >::const_iterator it=symb_loc.begin(); it!=symb_loc.end(); ++it){
+    if(it->second->temp!=0){
+      // Save to list of free parameters
+      free_vars_.push_back(SX::create(it->second));
+      
+      // Remove marker
+      it->second->temp=0;
+    }
+  }
+#ifdef WITH_THREADSAFE_SYMBOLICS
+  sort_lock.unlock();
+#endif // WITH_THREADSAFE_SYMBOLICS
+}
+
+void SXFunctionInternal::initNumeric(){
+  // Operations sharing elements of the work vector cannot be evaluated simultaneously
+  if(parallel_){
+    casadi_warning("SXFunctionInternal::init: parallel evaluation is not available without symbolic representation, switching to serial mode");
+    parallel_ = false;
+  }
+  
+  // Work vector size and number of partial derivatives on the tape
+  int worksize = 0, ntape = 0;
+  for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+    if(it->op==OP_OUTPUT){
+      worksize = std::max(worksize,it->arg.i[0]+1);
+    } else {
+      worksize = std::max(worksize,it->res+1);
+      if(it->op!=OP_CONST && it->op!=OP_PARAMETER && it->op!=OP_INPUT) ntape++;
+    }
+  }
+  work_.resize(worksize,numeric_limits<double>::quiet_NaN());
+  s_work_.clear();
+  pdwork_.resize(ntape);
+  
+  // Incremental evaluation requires that no element of the work vector is overwritten
+  if(incremental_){
+    vector<bool> written(worksize,false);
+    for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end() && incremental_; ++it){
+      if(it->op==OP_OUTPUT) continue;
+      if(written[it->res]){
+        casadi_warning("SXFunctionInternal::init: incremental evaluation is not available since the algorithm reuses elements of the work vector (option \"live_variables\")");
+        incremental_ = false;
+      }
+      written[it->res] = true;
+    }
+  }
+}
+
+void SXFunctionInternal::scheduleAlgorithm(bool reorder, bool reuse){
+  int nalg = algorithm_.size();
+  
+  // Size of the current work vector
+  int worksize = 0;
+  for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+    worksize = std::max(worksize,1+(it->op==OP_OUTPUT ? it->arg.i[0] : it->res));
+  }
+  
+  // Number of arguments and the operation defining each argument (the algorithm without the work vector)
+  vector<int> nargs(nalg), argdef(2*nalg,-1);
+  vector<int> def(worksize,-1);
+  for(int k=0; k<nalg; ++k){
+    const AlgEl& ae = algorithm_[k];
+    switch(ae.op){
+      case OP_CONST: case OP_PARAMETER: case OP_INPUT: nargs[k] = 0; break;
+      case OP_OUTPUT: nargs[k] = 1; break;
+      default: nargs[k] = casadi_math<double>::ndeps(ae.op);
+    }
+    for(int c=0; c<nargs[k]; ++c){
+      argdef[2*k+c] = def[ae.arg.i[c]];
+      casadi_assert_message(argdef[2*k+c]>=0, "SXFunctionInternal::scheduleAlgorithm: element " << ae.arg.i[c] << " of the work vector is used before it is defined");
+    }
+    if(ae.op!=OP_OUTPUT) def[ae.res] = k;
+  }
+  
+  // Order of the operations in the new algorithm
+  vector<int> order;
+  order.reserve(nalg);
+  if(reorder){
+    // Consumers of each operation with arguments, in the original order
+    vector<int> cons_begin(nalg+1,0), cons;
+    for(int k=0; k<nalg; ++k){
+      for(int c=0; c<nargs[k]; ++c){
+        int d = argdef[2*k+c];
+        if(nargs[d]>0) cons_begin[d+1]++;
+      }
+    }
+    for(int k=0; k<nalg; ++k) cons_begin[k+1] += cons_begin[k];
+    cons.resize(cons_begin.back());
+    vector<int> pending(nalg,0), cons_pos(cons_begin.begin(),cons_begin.end()-1);
+    for(int k=0; k<nalg; ++k){
+      for(int c=0; c<nargs[k]; ++c){
+        int d = argdef[2*k+c];
+        if(nargs[d]>0){
+          cons[cons_pos[d]++] = k;
+          pending[k]++;
+        }
+      }
+    }
+    
+    // Free parameters first, in the original order, since evalSX reads free_vars_ sequentially
+    vector<bool> emitted(nalg,false);
+    for(int k=0; k<nalg; ++k){
+      if(algorithm_[k].op==OP_PARAMETER){
+        order.push_back(k);
+        emitted[k] = true;
+      }
+    }
+    
+    // Operations whose arguments are all available, the earliest one on top
+    stack<int> ready;
+    for(int k=nalg-1; k>=0; --k){
+      if(nargs[k]>0 && pending[k]==0) ready.push(k);
+    }
+    
+    // Evaluate the most recently enabled operation first
+    while(!ready.empty()){
+      int k = ready.top();
+      ready.pop();
+      
+      // Constants and inputs are loaded just before they are first needed
+      for(int c=0; c<nargs[k]; ++c){
+        int d = argdef[2*k+c];
+        if(!emitted[d]){
+          order.push_back(d);
+          emitted[d] = true;
+        }
+      }
+      order.push_back(k);
+      emitted[k] = true;
+      
+      // Consumers that can now be evaluated, the first one on top
+      for(int i=cons_begin[k+1]-1; i>=cons_begin[k]; --i){
+        if(--pending[cons[i]]==0) ready.push(cons[i]);
+      }
+    }
+    
+    // Constants and inputs that are not used
+    for(int k=0; k<nalg; ++k){
+      if(!emitted[k]) order.push_back(k);
+    }
+    casadi_assert(order.size()==nalg);
+  } else {
+    for(int k=0; k<nalg; ++k) order.push_back(k);
+  }
+  
+  // Position of the last use of each operation
+  vector<int> last_use(nalg,-1);
+  for(int i=0; i<nalg; ++i){
+    int k = order[i];
+    for(int c=0; c<nargs[k]; ++c){
+      last_use[argdef[2*k+c]] = i;
+    }
+  }
+  
+  // Linear scan: free the elements of the arguments after their last use, store the result in the lowest free element
+  vector<int> place(nalg,-1);
+  priority_queue<int,vector<int>,greater<int> > unused;
+  vector<AlgEl> algorithm(nalg);
+  worksize = 0;
+  for(int i=0; i<nalg; ++i){
+    int k = order[i];
+    AlgEl ae = algorithm_[k];
+    for(int c=0; c<nargs[k]; ++c){
+      int d = argdef[2*k+c];
+      ae.arg.i[c] = place[d];
+      if(reuse && last_use[d]==i && (c==0 || argdef[2*k]!=d)) unused.push(place[d]);
+    }
+    if(nargs[k]==1 && ae.op!=OP_OUTPUT){
+      ae.arg.i[1] = ae.arg.i[0];
+    }
+    if(ae.op!=OP_OUTPUT){
+      if(reuse && !unused.empty()){
+        ae.res = place[k] = unused.top();
+        unused.pop();
+      } else {
+        ae.res = place[k] = worksize++;
+      }
+      
+      // Result that is never used
+      if(reuse && last_use[k]<0) unused.push(place[k]);
+    }
+    algorithm[i] = ae;
+  }
+  algorithm_.swap(algorithm);
+  
+  // The constants and operations of the expression graph follow the algorithm
+  vector<int> ind(nalg,-1);
+  int nconst=0, nop=0;
+  for(int k=0; k<nalg; ++k){
+    switch(algorithm[k].op){
+      case OP_CONST: ind[k] = nconst++; break;
+      case OP_PARAMETER: case OP_INPUT: case OP_OUTPUT: break;
+      default: ind[k] = nop++;
+    }
+  }
+  if(constants_.size()==nconst && operations_.size()==nop){
+    vector<SX> constants, operations;
+    constants.reserve(nconst);
+    operations.reserve(nop);
+    for(int i=0; i<nalg; ++i){
+      int k = order[i];
+      switch(algorithm[k].op){
+        case OP_CONST: constants.push_back(constants_[ind[k]]); break;
+        case OP_PARAMETER: case OP_INPUT: case OP_OUTPUT: break;
+        default: operations.push_back(operations_[ind[k]]);
+      }
+    }
+    constants_.swap(constants);
+    operations_.swap(operations);
+  }
+  
+  if(verbose()){
+    cout << "SXFunctionInternal::scheduleAlgorithm: work array is " << worksize << (reorder ? " after reordering" : "") << endl;
+  }
+  
+  // Reallocate the work vectors
+  work_.resize(worksize,numeric_limits<double>::quiet_NaN());
+  if(!s_work_.empty()) s_work_.resize(worksize);
+}
+
+void SXFunctionInternal::init(){
+  
+  // Call the init function of the base class
+  XFunctionInternal<SXFunction,SXFunctionInternal,SXMatrix,SXNode>::init();
+  
+  // Evaluate the algorithm in parallel?
+  parallel_ = getOption("parallelization")=="openmp";
+  #ifndef WITH_OPENMP
+  if(parallel_){
+    casadi_warning("OpenMP parallelization is not available, the levels will be evaluated by a single thread. Recompile CasADi setting the option WITH_OPENMP to ON.");
+  }
+  #endif // WITH_OPENMP
+  
+  // Re-execute only the operations affected by changed inputs?
+  incremental_ = getOption("incremental");
+  bool compiled = getOption("jit_compile") || getOption("just_in_time");
+  if(incremental_ && (parallel_ || compiled)){
+    casadi_warning("SXFunctionInternal::init: option \"incremental\" is ignored for parallel evaluation and for compiled functions");
+    incremental_ = false;
+  }
+  
+  if(outputv_.empty()){
+    // No symbolic representation (loaded from file or cleared), keep the algorithm
+    initNumeric();
+  } else {
+    // Sort the expression graph into an algorithm
+    sortAlgorithm();
+  }
+  
+  // Reorder the algorithm and reassign the work vector for locality
+  string scheduling = getOption("scheduling");
+  string work_allocation = getOption("work_allocation");
+  if(scheduling=="locality" || work_allocation=="linear_scan"){
+    bool reuse = getOption("live_variables") && !parallel_ && !incremental_;
+    scheduleAlgorithm(scheduling=="locality",reuse);
+  }
+  
+  // Sort the algorithm into levels for parallel evaluation
+  if(parallel_) initParallel();
+  
+  // Find the operations that depend on each input
+  inc_valid_ = false;
+  if(incremental_) initIncremental();
+  output_slices_.clear();
+  
+  // Store checkpoints instead of the complete tape if the latter exceeds the memory limit (in MB)
+  checkpointing_ = false;
+  double tape_memory_limit = getOption("tape_memory_limit");
+  if(tape_memory_limit>0){
+    double budget = tape_memory_limit*1024*1024;
+    if(parallel_){
+      casadi_warning("Option \"tape_memory_limit\" is ignored for parallel evaluation");
+    } else if(double(pdwork_.size())*sizeof(TapeEl<double>) > budget){
+      checkpointing_ = true;
+      initCheckpointing(budget);
     }
   }
   
-  // Locate free variables
-  free_vars_.clear();
-  for(vector<pair<int,SXNode*> >::const_iterator it=symb_loc.begin(); it!=symb_loc.end(); ++it){
-    if(it->second->temp!=0){
-      // Save to list of free parameters
-      free_vars_.push_back(SX::create(it->second));
-      
-      // Remove marker
-      it->second->temp=0;
+  // Rewrite the algorithm into the superinstruction bytecode
+  super_ = getOption("superinstructions") && free_vars_.empty();
+  if(super_) initSuper();
+  
+  // Allocate memory for directional derivatives, the checkpointed tape is always swept with all directions at once
+  vectorized_sweeps_ = getOption("vectorized_sweeps");
+  if(checkpointing_ && !vectorized_sweeps_){
+    if(hasSetOption("vectorized_sweeps")){
+      casadi_warning("Option \"vectorized_sweeps\" false is ignored when the tape is checkpointed, since every additional backward sweep would recalculate all segments");
     }
+    vectorized_sweeps_ = true;
   }
-  
-  // Allocate memory for directional derivatives
   SXFunctionInternal::updateNumSens(false);
   
   // Initialize just-in-time compilation
@@ -898,15 +1744,540 @@ void SXFunctionInternal::init(){
     #endif //WITH_LLVM
   }
   
+  // Compile the generated code and load it dynamically
+  jit_compile_ = getOption("jit_compile");
+  if(jit_compile_){
+    #ifdef WITH_DL
+    // Generate the C code
+    stringstream code;
+    generateCode(code,false);
+    
+    // Compiler command
+    string compiler = getOption("jit_compiler");
+    string flags = getOption("jit_flags");
+    
+    // Hash the code together with the compiler command (64-bit FNV-1a), the code contains the algorithm and the sparsity patterns
+    string key = code.str() + compiler + " " + flags;
+    unsigned long long hash = 14695981039346656037ULL;
+    for(string::const_iterator it=key.begin(); it!=key.end(); ++it){
+      hash ^= static_cast<unsigned char>(*it);
+      hash *= 1099511628211ULL;
+    }
+    
+    // Cache directory, private to the current user since the binaries found there are loaded into the process
+    string cache_dir = getOption("jit_cache_dir");
+    if(cache_dir.empty()) cache_dir = jitDefaultCacheDir();
+    mkdir(cache_dir.c_str(),0700); // may already exist
+    casadi_assert_message(jitPrivate(cache_dir,true),"SXFunctionInternal::init: The directory \"" << cache_dir << "\" set by \"jit_cache_dir\" must exist, be owned by the current user and not be writable by group or others");
+    
+    stringstream base_name;
+    base_name << cache_dir << "/casadi_jit_" << std::hex << hash;
+    string bin_name = base_name.str() + ".so";
+    string key_name = base_name.str() + ".key";
+    
+    // A binary in the cache is only used if the complete key stored next to it matches, a mere hash collision is not enough
+    bool cache_hit = false;
+    if(jitPrivate(bin_name,false) && jitPrivate(key_name,false)){
+      ifstream kfile(key_name.c_str(),ios::binary);
+      stringstream stored;
+      stored << kfile.rdbuf();
+      cache_hit = kfile.good() && stored.str()==key;
+    }
+    if(!cache_hit){
+      // Write the source code to a unique file
+      string src_name = jitTempFile(cache_dir);
+      ofstream cfile(src_name.c_str());
+      cfile << code.str();
+      cfile.close();
+      casadi_assert_message(cfile.good(),"SXFunctionInternal::init: Cannot write \"" << src_name << "\"");
+      
+      // Compile to a unique file first, so that other processes never load a partially written binary
+      string tmp_name = jitTempFile(cache_dir);
+      string cmd = compiler + " " + flags + " -fPIC -shared -x c " + jitQuote(src_name) + " -o " + jitQuote(tmp_name) + " -lm";
+      if(verbose()) cout << "SXFunctionInternal::init: " << cmd << endl;
+      int flag = system(cmd.c_str());
+      remove(src_name.c_str());
+      if(flag!=0) remove(tmp_name.c_str());
+      casadi_assert_message(flag==0,"SXFunctionInternal::init: Compilation failed: \"" << cmd << "\"");
+      
+      // Store the key, then move the binary into place
+      string tmp_key_name = jitTempFile(cache_dir);
+      ofstream kfile(tmp_key_name.c_str(),ios::binary);
+      kfile << key;
+      kfile.close();
+      flag = !kfile.good() || rename(tmp_key_name.c_str(),key_name.c_str())!=0 || rename(tmp_name.c_str(),bin_name.c_str())!=0;
+      if(flag){
+        remove(tmp_key_name.c_str());
+        remove(tmp_name.c_str());
+      }
+      casadi_assert_message(flag==0,"SXFunctionInternal::init: Cannot move the compiled function to \"" << bin_name << "\"");
+    }
+    stats_["jit_cache_hit"] = cache_hit;
+    stats_["jit_binary"] = bin_name;
+    
+    // Load the binary
+    jit_fcn_ = ExternalFunction(bin_name);
+    jit_fcn_.init();
+    casadi_assert(jit_fcn_.getNumInputs()==getNumInputs() && jit_fcn_.getNumOutputs()==getNumOutputs());
+    
+    if(verbose()){
+      cout << "SXFunctionInternal::init: loaded " << bin_name << (cache_hit ? " (from cache)" : "") << endl;
+    }
+    #else // WITH_DL
+    casadi_error("Option \"jit_compile\" true requires CasADi to have been compiled with WITH_DL=ON");
+    #endif // WITH_DL
+  }
+  
   // Print
   if(verbose()){
     cout << "SXFunctionInternal::init Initialized " << getOption("name") << " (" << algorithm_.size() << " elementary operations)" << endl;
   }
 }
 
+/// Check that the arguments of instruction m still hold the values they had when it was executed, if m is removed
+static bool superArgsValid(int m, const vector<SXFunctionInternal::SuperEl>& bc, const vector<int>& argdef, 
+                           const vector<bool>& removed, const vector<int>& def, const vector<int>& prevdef){
+  const SXFunctionInternal::SuperEl& e = bc[m];
+  for(int i=0; i<3; ++i){
+    int a = argdef[3*m+i];
+    if(a<0) continue;
+    
+    // The instruction which last wrote to the argument, not counting m
+    int d = def[e.arg[i]];
+    if(d==m){
+      d = prevdef[m];
+      while(d>=0 && removed[d]) d = prevdef[d];
+    }
+    if(d!=a) return false;
+  }
+  return true;
+}
+
+/// Remove an instruction from the bytecode, the previous value of its result becomes the current one
+static void superRemove(int m, const vector<SXFunctionInternal::SuperEl>& bc, vector<bool>& removed, vector<int>& def, const vector<int>& prevdef){
+  removed[m] = true;
+  int& d = def[bc[m].res];
+  if(d==m){
+    d = prevdef[m];
+    while(d>=0 && removed[d]) d = prevdef[d];
+  }
+}
+
+void SXFunctionInternal::initSuper(){
+  int n = algorithm_.size();
+  
+  // Instruction which last wrote to each element of the work vector
+  vector<int> def(work_.size(),-1);
+  
+  // Number of instructions using the result of each instruction
+  vector<int> nuse(n,0);
+  for(int k=0; k<n; ++k){
+    const AlgEl& a = algorithm_[k];
+    if(a.op==OP_OUTPUT){
+      nuse[def[a.arg.i[0]]]++;
+    } else {
+      if(a.op!=OP_CONST && a.op!=OP_INPUT){
+        nuse[def[a.arg.i[0]]]++;
+        if(casadi_math<double>::ndeps(a.op)==2 && a.arg.i[1]!=a.arg.i[0]) nuse[def[a.arg.i[1]]]++;
+      }
+      def[a.res] = k;
+    }
+  }
+  
+  // Bytecode before removing the fused instructions, the instructions defining the arguments of each instruction
+  // and the instruction which wrote to the result before it
+  vector<SuperEl> bc(n);
+  vector<int> argdef(3*n,-1), prevdef(n,-1);
+  vector<bool> removed(n,false);
+  std::fill(def.begin(),def.end(),-1);
+  
+  for(int k=0; k<n; ++k){
+    const AlgEl& a = algorithm_[k];
+    SuperEl& e = bc[k];
+    int* ad = &argdef[3*k];
+    e.op = a.op;
+    e.res = a.res;
+    e.c = 0;
+    
+    if(a.op==OP_CONST){
+      e.c = a.arg.d;
+      e.arg[0] = e.arg[1] = e.arg[2] = 0;
+    } else if(a.op==OP_INPUT || a.op==OP_OUTPUT){
+      e.arg[0] = a.arg.i[0];
+      e.arg[1] = a.arg.i[1];
+      e.arg[2] = 0;
+      if(a.op==OP_OUTPUT) ad[0] = def[e.arg[0]];
+    } else {
+      // Unary or binary operation
+      e.arg[0] = a.arg.i[0];
+      e.arg[1] = a.arg.i[1];
+      e.arg[2] = 0;
+      ad[0] = def[e.arg[0]];
+      if(casadi_math<double>::ndeps(e.op)==2) ad[1] = def[e.arg[1]];
+      
+      // Inline constant operands
+      if(ad[1]>=0 && e.arg[0]!=e.arg[1]){
+        for(int i=1; i>=0; --i){
+          int m = ad[i];
+          if(bc[m].op!=OP_CONST || removed[m]) continue;
+          int op = -1;
+          double c = bc[m].c;
+          switch(e.op){
+            case OP_ADD: op = SOP_ADD_C; break;
+            case OP_SUB: if(i==1){ op = SOP_ADD_C; c = -c;} else { op = SOP_C_SUB;} break;
+            case OP_MUL: op = SOP_MUL_C; break;
+            case OP_DIV: op = i==1 ? SOP_DIV_C : SOP_C_DIV; break;
+            case OP_POW: case OP_CONSTPOW: if(i==1) op = SOP_POW_C; break;
+          }
+          if(op<0) continue;
+          
+          // The remaining argument becomes the first one
+          e.op = op;
+          e.c = c;
+          e.arg[0] = e.arg[1] = e.arg[1-i];
+          ad[0] = ad[1-i];
+          ad[1] = -1;
+          
+          // Remove the constant if this was its last use
+          if(--nuse[m]==0) superRemove(m,bc,removed,def,prevdef);
+          break;
+        }
+      }
+      
+      // Squarings and negations are expressed as c * x^(2^k)
+      if(e.op==OP_NEG){
+        e.op = SOP_POW2K;
+        e.c = -1;
+        e.arg[2] = 0;
+      } else if(e.op==OP_MUL && e.arg[0]==e.arg[1]){
+        e.op = SOP_POW2K;
+        e.c = 1;
+        e.arg[2] = 1;
+        ad[1] = -1;
+      }
+      
+      // Merge with the squaring or negation that calculated the argument
+      if(e.op==SOP_POW2K){
+        int m = ad[0];
+        const SuperEl& d = bc[m];
+        if(d.op==SOP_POW2K && nuse[m]==1 && superArgsValid(m,bc,argdef,removed,def,prevdef)){
+          e.c = e.arg[2]==0 ? e.c*d.c : e.c;
+          e.arg[2] += d.arg[2];
+          e.arg[0] = e.arg[1] = d.arg[0];
+          ad[0] = argdef[3*m];
+          superRemove(m,bc,removed,def,prevdef);
+        }
+      }
+      
+      // Fuse a multiplication with the addition or subtraction using it
+      if((e.op==OP_ADD || e.op==OP_SUB) && e.arg[0]!=e.arg[1]){
+        for(int i=1; i>=0; --i){
+          int m = ad[i];
+          const SuperEl& d = bc[m];
+          bool is_mul = d.op==OP_MUL || (d.op==SOP_POW2K && d.arg[2]==1 && d.c==1);
+          bool is_mul_c = d.op==SOP_MUL_C;
+          if(!(is_mul || is_mul_c) || nuse[m]!=1 || !superArgsValid(m,bc,argdef,removed,def,prevdef)) continue;
+          if(is_mul_c && !(e.op==OP_ADD)) continue;
+          
+          // The other term
+          int z = e.arg[1-i], z_def = ad[1-i];
+          if(e.op==OP_ADD){
+            e.op = is_mul ? SOP_MULADD : SOP_MULADD_C;
+          } else {
+            e.op = i==0 ? SOP_MULSUB : SOP_NMULADD;
+          }
+          e.arg[0] = d.arg[0];
+          e.arg[1] = d.op==SOP_MUL_C ? d.arg[0] : d.arg[1];
+          e.arg[2] = z;
+          e.c = d.c;
+          ad[0] = argdef[3*m];
+          ad[1] = d.op==OP_MUL ? argdef[3*m+1] : -1;
+          ad[2] = z_def;
+          superRemove(m,bc,removed,def,prevdef);
+          break;
+        }
+      }
+    }
+    
+    // Mark the result as written
+    if(e.op!=OP_OUTPUT){
+      prevdef[k] = def[e.res];
+      def[e.res] = k;
+    }
+  }
+  
+  // Collect the remaining instructions, using the specialized forms of the chains
+  super_alg_.clear();
+  super_alg_.reserve(n);
+  super_src_.clear();
+  for(int k=0; k<n; ++k){
+    if(removed[k]) continue;
+    super_src_.push_back(k);
+    SuperEl e = bc[k];
+    if(e.op==SOP_POW2K){
+      if(e.arg[2]==0 && e.c==-1){
+        e.op = OP_NEG;
+      } else if(e.arg[2]==0 && e.c==1){
+        e.op = OP_ASSIGN;
+      } else if(e.arg[2]==1 && e.c==1){
+        e.op = SOP_SQR;
+      }
+    }
+    super_alg_.push_back(e);
+  }
+  
+  stats_["num_instructions"] = n;
+  stats_["num_superinstructions"] = int(super_alg_.size());
+  if(verbose()){
+    cout << "SXFunctionInternal::initSuper: " << n << " instructions rewritten into " << super_alg_.size() << " superinstructions" << endl;
+  }
+}
+
+inline void SXFunctionInternal::evaluateSuperEl(const SuperEl* it, double* w){
+  switch(it->op){
+    // Built-in operations
+    CASADI_MATH_FUN_BUILTIN(w[it->arg[0]],w[it->arg[1]],w[it->res])
+    
+    // Constant
+    case OP_CONST: w[it->res] = it->c; break;
+    
+    // Load function input to work vector
+    case OP_INPUT: w[it->res] = inputNoCheck(it->arg[0]).data()[it->arg[1]]; break;
+    
+    // Get function output from work vector
+    case OP_OUTPUT: outputNoCheck(it->res).data()[it->arg[1]] = w[it->arg[0]]; break;
+    
+    // Operations with an inline constant
+    case SOP_ADD_C: w[it->res] = w[it->arg[0]] + it->c; break;
+    case SOP_C_SUB: w[it->res] = it->c - w[it->arg[0]]; break;
+    case SOP_MUL_C: w[it->res] = w[it->arg[0]] * it->c; break;
+    case SOP_DIV_C: w[it->res] = w[it->arg[0]] / it->c; break;
+    case SOP_C_DIV: w[it->res] = it->c / w[it->arg[0]]; break;
+    case SOP_POW_C: w[it->res] = std::pow(w[it->arg[0]],it->c); break;
+    
+    // Squarings and negations
+    case SOP_SQR: w[it->res] = w[it->arg[0]] * w[it->arg[0]]; break;
+    case SOP_POW2K:
+    {
+      double y = w[it->arg[0]];
+      for(int i=0; i<it->arg[2]; ++i) y *= y;
+      w[it->res] = it->c * y;
+      break;
+    }
+    
+    // Fused multiply-add
+    case SOP_MULADD: w[it->res] = w[it->arg[0]] * w[it->arg[1]] + w[it->arg[2]]; break;
+    case SOP_MULSUB: w[it->res] = w[it->arg[0]] * w[it->arg[1]] - w[it->arg[2]]; break;
+    case SOP_NMULADD: w[it->res] = w[it->arg[2]] - w[it->arg[0]] * w[it->arg[1]]; break;
+    case SOP_MULADD_C: w[it->res] = w[it->arg[0]] * it->c + w[it->arg[2]]; break;
+  }
+}
+
+void SXFunctionInternal::evaluateSuper(){
+  double* w = getPtr(work_);
+  for(vector<SuperEl>::const_iterator it=super_alg_.begin(); it!=super_alg_.end(); ++it){
+    evaluateSuperEl(&*it,w);
+  }
+}
+
+void SXFunctionInternal::evaluateSuper(const std::vector<int>& ops){
+  double* w = getPtr(work_);
+  for(vector<int>::const_iterator k=ops.begin(); k!=ops.end(); ++k){
+    evaluateSuperEl(&super_alg_[*k],w);
+  }
+}
+
+void SXFunctionInternal::initParallel(){
+  // Level of each element of the work vector
+  vector<int> work_level(work_.size(),0);
+  
+  // Level of each element of the algorithm, inputs and constants at level 0
+  vector<int> alg_level(algorithm_.size());
+  int nlevels = 0;
+  
+  // Index of each element of the algorithm in the tape
+  tape_ind_.resize(algorithm_.size());
+  int ntape = 0;
+  
+  // Number of times each element of the work vector is used
+  par_cons_offset_.resize(work_.size()+1);
+  fill(par_cons_offset_.begin(),par_cons_offset_.end(),0);
+  
+  for(int k=0; k<algorithm_.size(); ++k){
+    const AlgEl& e = algorithm_[k];
+    int ndeps = casadi_math<double>::ndeps(e.op);
+    
+    // An operation can be evaluated when all its dependencies have been evaluated
+    int level = 0;
+    for(int c=0; c<ndeps; ++c){
+      level = std::max(level,work_level[e.arg.i[c]]+1);
+      par_cons_offset_[e.arg.i[c]+1]++;
+    }
+    alg_level[k] = level;
+    nlevels = std::max(nlevels,level+1);
+    if(e.op!=OP_OUTPUT) work_level[e.res] = level;
+    
+    // Operations with partial derivatives
+    bool has_tape = e.op!=OP_CONST && e.op!=OP_INPUT && e.op!=OP_OUTPUT;
+    tape_ind_[k] = has_tape ? ntape++ : -1;
+  }
+  casadi_assert(ntape==pdwork_.size());
+  
+  // Sort the algorithm by level, keeping the order within each level
+  par_level_offset_.resize(nlevels+1);
+  fill(par_level_offset_.begin(),par_level_offset_.end(),0);
+  for(int k=0; k<algorithm_.size(); ++k){
+    par_level_offset_[alg_level[k]+1]++;
+  }
+  for(int i=0; i<nlevels; ++i){
+    par_level_offset_[i+1] += par_level_offset_[i];
+  }
+  par_alg_.resize(algorithm_.size());
+  vector<int> pos(par_level_offset_.begin(),par_level_offset_.end()-1);
+  for(int k=0; k<algorithm_.size(); ++k){
+    par_alg_[pos[alg_level[k]]++] = k;
+  }
+  
+  // All uses of each element of the work vector, encoded as 2*(place in the algorithm) + (argument index)
+  for(int i=0; i<work_.size(); ++i){
+    par_cons_offset_[i+1] += par_cons_offset_[i];
+  }
+  par_cons_.resize(par_cons_offset_.back());
+  pos.assign(par_cons_offset_.begin(),par_cons_offset_.end()-1);
+  for(int k=0; k<algorithm_.size(); ++k){
+    const AlgEl& e = algorithm_[k];
+    int ndeps = casadi_math<double>::ndeps(e.op);
+    for(int c=0; c<ndeps; ++c){
+      par_cons_[pos[e.arg.i[c]]++] = 2*k + c;
+    }
+  }
+  
+  // Statistics
+  stats_["num_levels"] = nlevels;
+  stats_["average_level_width"] = nlevels==0 ? 0. : double(algorithm_.size())/nlevels;
+  
+  if(verbose()){
+    cout << "SXFunctionInternal::initParallel: " << algorithm_.size() << " operations sorted into " << nlevels << " levels" << endl;
+  }
+}
+
+void SXFunctionInternal::evaluateParallel(int nfdir, int nadir){
+  if (!free_vars_.empty()) {
+    std::stringstream ss;
+    repr(ss);
+    casadi_error("Cannot evaluate \"" << ss.str() << "\" since variables " << free_vars_ << " are free.");
+  }
+#ifdef WITH_OPENMP
+  double time_start = omp_get_wtime();
+#endif // WITH_OPENMP
+  
+  // Work vectors, directional derivatives are stored direction-contiguously
+  const int ndir_max = std::max(nfdir,nadir);
+  if(dwork_.size()<work_.size()*ndir_max) dwork_.resize(work_.size()*ndir_max);
+  double *w = getPtr(work_);
+  double *dw = getPtr(dwork_);
+  TapeEl<double> *pd = getPtr(pdwork_);
+  const bool taping = nfdir>0 || nadir>0;
+  const int nlevels = int(par_level_offset_.size())-1;
+  int num_threads = 1;
+  
+  // Without OpenMP, the levels are evaluated by a single thread
+#ifdef WITH_OPENMP
+  #pragma omp parallel
+#endif // WITH_OPENMP
+  {
+#ifdef WITH_OPENMP
+    #pragma omp master
+    num_threads = omp_get_num_threads();
+#endif // WITH_OPENMP
+    
+    // Nondifferentiated function and forward sensitivities, level by level
+    for(int level=0; level<nlevels; ++level){
+#ifdef WITH_OPENMP
+      #pragma omp for schedule(static)
+#endif // WITH_OPENMP
+      for(int j=par_level_offset_[level]; j<par_level_offset_[level+1]; ++j){
+        int k = par_alg_[j];
+        const AlgEl& e = algorithm_[k];
+        double *r = dw + e.res*nfdir;
+        switch(e.op){
+          case OP_CONST:
+            w[e.res] = e.arg.d;
+            for(int dir=0; dir<nfdir; ++dir) r[dir] = 0;
+            break;
+          case OP_INPUT:
+            w[e.res] = inputNoCheck(e.arg.i[0]).data()[e.arg.i[1]];
+            for(int dir=0; dir<nfdir; ++dir) r[dir] = fwdSeedNoCheck(e.arg.i[0],dir).data()[e.arg.i[1]];
+            break;
+          case OP_OUTPUT:
+            outputNoCheck(e.res).data()[e.arg.i[1]] = w[e.arg.i[0]];
+            r = dw + e.arg.i[0]*nfdir;
+            for(int dir=0; dir<nfdir; ++dir) fwdSensNoCheck(e.res,dir).data()[e.arg.i[1]] = r[dir];
+            break;
+          default:
+            if(taping){
+              double *d = pd[tape_ind_[k]].d;
+              casadi_math<double>::derF(e.op,w[e.arg.i[0]],w[e.arg.i[1]],w[e.res],d);
+              const double *a0 = dw + e.arg.i[0]*nfdir;
+              const double *a1 = dw + e.arg.i[1]*nfdir;
+              for(int dir=0; dir<nfdir; ++dir) r[dir] = d[0]*a0[dir] + d[1]*a1[dir];
+            } else {
+              casadi_math<double>::fun(e.op,w[e.arg.i[0]],w[e.arg.i[1]],w[e.res]);
+            }
+        }
+      }
+    }
+    
+    // Adjoint sensitivities, in reverse order. Each operation gathers the seeds from the operations that use its result, 
+    // all of which are on higher levels, so that no two threads write to the same element
+    for(int level=nlevels-1; nadir>0 && level>=0; --level){
+#ifdef WITH_OPENMP
+      #pragma omp for schedule(static)
+#endif // WITH_OPENMP
+      for(int j=par_level_offset_[level]; j<par_level_offset_[level+1]; ++j){
+        int k = par_alg_[j];
+        const AlgEl& e = algorithm_[k];
+        if(e.op==OP_OUTPUT || e.op==OP_CONST) continue;
+        
+        // Collect the seeds
+        double *r = dw + e.res*nadir;
+        for(int dir=0; dir<nadir; ++dir) r[dir] = 0;
+        for(int c=par_cons_offset_[e.res]; c<par_cons_offset_[e.res+1]; ++c){
+          const AlgEl& ce = algorithm_[par_cons_[c]/2];
+          if(ce.op==OP_OUTPUT){
+            for(int dir=0; dir<nadir; ++dir) r[dir] += adjSeedNoCheck(ce.res,dir).data()[ce.arg.i[1]];
+          } else {
+            const double d = pd[tape_ind_[par_cons_[c]/2]].d[par_cons_[c]%2];
+            const double *s = dw + ce.res*nadir;
+            for(int dir=0; dir<nadir; ++dir) r[dir] += d*s[dir];
+          }
+        }
+        
+        // Save to the adjoint sensitivities
+        if(e.op==OP_INPUT){
+          for(int dir=0; dir<nadir; ++dir) adjSensNoCheck(e.arg.i[0],dir).data()[e.arg.i[1]] = r[dir];
+        }
+      }
+    }
+  }
+  
+  // Statistics
+  stats_["num_threads"] = num_threads;
+#ifdef WITH_OPENMP
+  stats_["t_evaluate"] = omp_get_wtime()-time_start;
+#endif // WITH_OPENMP
+}
+
 void SXFunctionInternal::updateNumSens(bool recursive){
   // Call the base class if needed
   if(recursive) XFunctionInternal<SXFunction,SXFunctionInternal,SXMatrix,SXNode>::updateNumSens(recursive);
+  
+  // Work vector for propagating all directions in a single sweep
+  if(vectorized_sweeps_){
+    dwork_.resize(work_.size()*std::max(nfdir_,nadir_));
+  } else {
+    dwork_.clear();
+  }
 }
 
 void SXFunctionInternal::evalSX(const vector<SXMatrix>& arg, vector<SXMatrix>& res, 
@@ -915,6 +2286,7 @@ void SXFunctionInternal::evalSX(const vector<SXMatrix>& arg, vector<SXMatrix>& r
                                 bool output_given, int offset_begin, int offset_end){
 
   if(verbose()) cout << "SXFunctionInternal::eval begin" << endl;
+  casadi_assert_message(!outputv_.empty(),"SXFunctionInternal::evalSX: the function has no symbolic representation, it has been loaded for numeric evaluation only or clearSymbolic has been called");
   
   // Assert number of inputs
   casadi_assert_message(inputv_.size() == arg.size(),"Wrong number of inputs. Expecting " << inputv_.size() << ", got " << arg.size());
@@ -1178,6 +2550,140 @@ SXFunctionInternal* SXFunctionInternal::clone() const{
 }
 
 
+void SXFunctionInternal::save(Serializer& s) const{
+  s.packHeader("CASADISX",1);
+  s.pack(getOption("name").toString());
+  s.pack(getNumInputs());
+  for(int ind=0; ind<getNumInputs(); ++ind){
+    s.pack(input(ind).sparsity());
+    
+    // Names of the symbolic inputs, empty if the expression graph is not available
+    for(int k=0; k<input(ind).size(); ++k){
+      bool named = ind<inputv_.size() && inputv_[ind].at(k).isSymbolic();
+      s.pack(named ? inputv_[ind].at(k).getName() : string());
+    }
+  }
+  s.pack(getNumOutputs());
+  for(int ind=0; ind<getNumOutputs(); ++ind) s.pack(output(ind).sparsity());
+  s.pack(int(free_vars_.size()));
+  for(vector<SX>::const_iterator it=free_vars_.begin(); it!=free_vars_.end(); ++it) s.pack(it->getName());
+  
+  // The algorithm as it is in memory, the constants are stored in place
+  s.pack(int(sizeof(AlgEl)));
+  s.pack(int(algorithm_.size()));
+  if(!algorithm_.empty()) s.packRaw(getPtr(algorithm_),long(algorithm_.size())*sizeof(AlgEl));
+}
+
+SXFunction SXFunctionInternal::load(Deserializer& d, bool symbolic){
+  d.unpackHeader("CASADISX",1);
+  string name;
+  d.unpack(name);
+  int n_in, n_out, n_free;
+  d.unpack(n_in);
+  casadi_assert_message(n_in>=0, "SXFunction::load: corrupt file");
+  vector<CRSSparsity> input_sparsity(n_in);
+  vector<vector<string> > input_names(n_in);
+  for(int ind=0; ind<n_in; ++ind){
+    d.unpack(input_sparsity[ind]);
+    input_names[ind].resize(input_sparsity[ind].size());
+    for(vector<string>::iterator it=input_names[ind].begin(); it!=input_names[ind].end(); ++it){
+      d.unpack(*it);
+    }
+  }
+  d.unpack(n_out);
+  casadi_assert_message(n_out>=0, "SXFunction::load: corrupt file");
+  vector<CRSSparsity> output_sparsity(n_out);
+  for(int ind=0; ind<n_out; ++ind) d.unpack(output_sparsity[ind]);
+  d.unpack(n_free);
+  casadi_assert_message(n_free>=0, "SXFunction::load: corrupt file");
+  vector<SX> free_vars(n_free);
+  for(int k=0; k<n_free; ++k){
+    string fname;
+    d.unpack(fname);
+    free_vars[k] = SX(fname);
+  }
+  
+  // Copy the algorithm out of the buffer, it is not parsed
+  int sz_el, n_alg;
+  d.unpack(sz_el);
+  d.unpack(n_alg);
+  casadi_assert_message(sz_el==sizeof(AlgEl) && n_alg>=0, "SXFunction::load: incompatible file");
+  vector<AlgEl> algorithm(n_alg);
+  if(n_alg>0) memcpy(getPtr(algorithm),d.unpackRaw(long(n_alg)*sizeof(AlgEl)),long(n_alg)*sizeof(AlgEl));
+  
+  // Make sure that the algorithm is safe to evaluate
+  int worksize = 0, n_param = 0;
+  for(vector<AlgEl>::const_iterator it=algorithm.begin(); it!=algorithm.end(); ++it){
+    bool ok = it->op>=0 && it->op<NUM_BUILT_IN_OPS;
+    switch(ok ? it->op : -1){
+      case OP_INPUT:
+        ok = it->res>=0 && it->arg.i[0]>=0 && it->arg.i[0]<n_in && it->arg.i[1]>=0 && it->arg.i[1]<input_sparsity[it->arg.i[0]].size();
+        break;
+      case OP_OUTPUT:
+        ok = it->arg.i[0]>=0 && it->arg.i[0]<worksize && it->res>=0 && it->res<n_out && it->arg.i[1]>=0 && it->arg.i[1]<output_sparsity[it->res].size();
+        break;
+      case OP_CONST:
+        ok = it->res>=0;
+        break;
+      case OP_PARAMETER:
+        ok = it->res>=0 && n_param++<n_free;
+        break;
+      case -1:
+        break;
+      default:
+        ok = it->res>=0 && it->arg.i[0]>=0 && it->arg.i[0]<worksize && it->arg.i[1]>=0 && it->arg.i[1]<worksize;
+    }
+    casadi_assert_message(ok, "SXFunction::load: corrupt file, invalid operation " << (it-algorithm.begin()));
+    if(it->op!=OP_OUTPUT) worksize = std::max(worksize,it->res+1);
+  }
+  
+  SXFunction ret;
+  if(symbolic){
+    // Recreate the expression graph by evaluating the algorithm symbolically
+    vector<SXMatrix> arg(n_in), res(n_out);
+    for(int ind=0; ind<n_in; ++ind){
+      stringstream ss;
+      ss << "x" << ind;
+      arg[ind] = ssym(ss.str(),input_sparsity[ind]);
+      
+      // Use the saved names, if any
+      for(int k=0; k<input_names[ind].size(); ++k){
+        if(!input_names[ind][k].empty()) arg[ind].at(k) = SX(input_names[ind][k]);
+      }
+    }
+    for(int ind=0; ind<n_out; ++ind){
+      res[ind] = SXMatrix(output_sparsity[ind]);
+    }
+    vector<SX> w(worksize);
+    vector<SX>::const_iterator p_it = free_vars.begin();
+    for(vector<AlgEl>::const_iterator it=algorithm.begin(); it!=algorithm.end(); ++it){
+      switch(it->op){
+        case OP_INPUT: w[it->res] = arg[it->arg.i[0]].data()[it->arg.i[1]]; break;
+        case OP_OUTPUT: res[it->res].data()[it->arg.i[1]] = w[it->arg.i[0]]; break;
+        case OP_CONST: w[it->res] = it->arg.d; break;
+        case OP_PARAMETER: w[it->res] = *p_it++; break;
+        default:
+        {
+          SX f;
+          switch(it->op){
+            CASADI_MATH_FUN_BUILTIN(w[it->arg.i[0]],w[it->arg.i[1]],f)
+          }
+          w[it->res] = f;
+        }
+      }
+    }
+    ret = SXFunction(arg,res);
+  } else {
+    // Use the algorithm as it is
+    ret.assignNode(new SXFunctionInternal(input_sparsity,output_sparsity));
+    ret->algorithm_.swap(algorithm);
+    ret->free_vars_ = free_vars;
+  }
+  ret.setOption("name",name);
+  ret.init();
+  return ret;
+}
+
 void SXFunctionInternal::clearSymbolic(){
   inputv_.clear();
   outputv_.clear();
@@ -1185,6 +2691,9 @@ void SXFunctionInternal::clearSymbolic(){
 }
 
 void SXFunctionInternal::spInit(bool fwd){
+  // The work vector is overwritten
+  inc_valid_ = false;
+  
   // We need a work array containing unsigned long rather than doubles. Since the two datatypes have the same size (64 bits)
   // we can save overhead by reusing the double array
   bvec_t *iwork = get_bvec_t(work_);
@@ -1241,5 +2750,120 @@ void SXFunctionInternal::spEvaluate(bool fwd){
   }
 }
 
+bool SXFunctionInternal::hashStructure(StructureHash& h){
+  h.add(string("SXFunction"));
+  for(int ind=0; ind<getNumInputs(); ++ind) h.add(inputNoCheck(ind).sparsity());
+  for(int ind=0; ind<getNumOutputs(); ++ind) h.add(outputNoCheck(ind).sparsity());
+
+  // The values of the constants do not affect the sparsity
+  h.add(int(algorithm_.size()));
+  for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+    h.add(it->op);
+    h.add(it->res);
+    if(it->op!=OP_CONST){
+      h.add(it->arg.i[0]);
+      h.add(it->arg.i[1]);
+    }
+  }
+  return true;
+}
+
+template<int NW>
+void SXFunctionInternal::spEvaluateBlockGen(bool fwd, int iind, int oind, const bvec_t* seed, bvec_t* sens, vector<bvec_t>& work) const{
+  // Work vector, NW words per element
+  work.resize(work_.size()*NW);
+  bvec_t *iwork = getPtr(work);
+  
+  if(fwd){
+    // Propagate sparsity forward
+    for(vector<AlgEl>::const_iterator it=algorithm_.begin(); it!=algorithm_.end(); ++it){
+      bvec_t* r = iwork + it->res*NW;
+      switch(it->op){
+        case OP_CONST:
+        case OP_PARAMETER:
+          for(int k=0; k<NW; ++k) r[k] = 0;
+          break;
+        case OP_INPUT:
+          if(it->arg.i[0]==iind){
+            const bvec_t* s = seed + it->arg.i[1]*NW;
+            for(int k=0; k<NW; ++k) r[k] = s[k];
+          } else {
+            for(int k=0; k<NW; ++k) r[k] = 0;
+          }
+          break;
+        case OP_OUTPUT:
+          if(it->res==oind){
+            const bvec_t* a = iwork + it->arg.i[0]*NW;
+            bvec_t* s = sens + it->arg.i[1]*NW;
+            for(int k=0; k<NW; ++k) s[k] = a[k];
+          }
+          break;
+        default: // Unary or binary operation
+          {
+            const bvec_t* a0 = iwork + it->arg.i[0]*NW;
+            const bvec_t* a1 = iwork + it->arg.i[1]*NW;
+            for(int k=0; k<NW; ++k) r[k] = a0[k] | a1[k];
+          }
+      }
+    }
+        
+  } else { // Backward propagation
+    fill(work.begin(),work.end(),bvec_t(0));
+
+    // Propagate sparsity backward
+    for(vector<AlgEl>::const_reverse_iterator it=algorithm_.rbegin(); it!=algorithm_.rend(); ++it){
+      switch(it->op){
+        case OP_CONST:
+        case OP_PARAMETER:
+          {
+            bvec_t* r = iwork + it->res*NW;
+            for(int k=0; k<NW; ++k) r[k] = 0;
+          }
+          break;
+        case OP_INPUT:
+          {
+            bvec_t* r = iwork + it->res*NW;
+            if(it->arg.i[0]==iind){
+              bvec_t* s = sens + it->arg.i[1]*NW;
+              for(int k=0; k<NW; ++k) s[k] = r[k];
+            }
+            for(int k=0; k<NW; ++k) r[k] = 0;
+          }
+          break;
+        case OP_OUTPUT:
+          if(it->res==oind){
+            bvec_t* a = iwork + it->arg.i[0]*NW;
+            const bvec_t* s = seed + it->arg.i[1]*NW;
+            for(int k=0; k<NW; ++k) a[k] |= s[k];
+          }
+          break;
+        default: // Unary or binary operation
+          {
+            bvec_t* r = iwork + it->res*NW;
+            bvec_t* a0 = iwork + it->arg.i[0]*NW;
+            bvec_t* a1 = iwork + it->arg.i[1]*NW;
+            for(int k=0; k<NW; ++k){
+              bvec_t s = r[k];
+              r[k] = 0;
+              a0[k] |= s;
+              a1[k] |= s;
+            }
+          }
+      }
+    }
+  }
+}
+
+void SXFunctionInternal::spEvaluateBlock(bool fwd, int nw, int iind, int oind, const bvec_t* seed, bvec_t* sens, vector<bvec_t>& work){
+  switch(nw){
+    case 1: spEvaluateBlockGen<1>(fwd,iind,oind,seed,sens,work); break;
+    case 2: spEvaluateBlockGen<2>(fwd,iind,oind,seed,sens,work); break;
+    case 4: spEvaluateBlockGen<4>(fwd,iind,oind,seed,sens,work); break;
+    case 8: spEvaluateBlockGen<8>(fwd,iind,oind,seed,sens,work); break;
+    case 16: spEvaluateBlockGen<16>(fwd,iind,oind,seed,sens,work); break;
+    default: casadi_error("SXFunctionInternal::spEvaluateBlock: block width " << nw << " not supported");
+  }
+}
+
 } // namespace CasADi
 
@@ -25,6 +25,7 @@
 
 #include "sx_function.hpp"
 #include "x_function_internal.hpp"
+#include "external_function.hpp"
 
 #ifdef WITH_LLVM
 // Some forward declarations
@@ -36,6 +37,9 @@ namespace llvm{
 
 namespace CasADi{
 
+class Serializer;
+class Deserializer;
+
 /** \brief  Internal node class for SXFunction
   A regular user should never work with any Node class. Use SXFunction directly.
   \author Joel Andersson 
@@ -48,6 +52,12 @@ class SXFunctionInternal : public XFunctionInternal<SXFunction,SXFunctionInterna
     /** \brief  Constructor (only to be called from SXFunction, therefore protected) */
     SXFunctionInternal(const std::vector<Matrix<SX> >& inputv, const std::vector<Matrix<SX> >& outputv);
 
+    /** \brief  Constructor without symbolic representation, the algorithm is to be set before initialization */
+    SXFunctionInternal(const std::vector<CRSSparsity>& input_sparsity, const std::vector<CRSSparsity>& output_sparsity);
+    
+    /** \brief  Add the options of the class (called from the constructors) */
+    void addOptions();
+
   public:
 
   /** \brief  Make a deep copy */
@@ -79,6 +89,67 @@ class SXFunctionInternal : public XFunctionInternal<SXFunction,SXFunctionInterna
   template<typename T1, typename T2>
   void evaluateGen(T1 nfdir_c, T2 nadir_c);
   
+  /** \brief  Evaluate the function numerically, operations on the same level in parallel */
+  void evaluateParallel(int nfdir, int nadir);
+  
+  /** \brief  Sort the algorithm into levels for parallel evaluation */
+  void initParallel();
+  
+  /** \brief  Evaluate a part of the algorithm, saving the partial derivatives to the beginning of the tape */
+  void evaluateSegment(int alg_begin, int alg_end);
+  
+  /** \brief  Evaluate the function numerically with sensitivities, storing checkpoints instead of the complete tape */
+  void evaluateCheckpointed(int nfdir, int nadir);
+  
+  /** \brief  Divide the algorithm into segments such that the checkpoints and the tape of a segment fit in the memory budget (in bytes) */
+  void initCheckpointing(double budget);
+  
+  /** \brief  Evaluate the function numerically using the superinstruction bytecode */
+  void evaluateSuper();
+  
+  /** \brief  Execute a sorted subset of the superinstruction bytecode (no derivatives) */
+  void evaluateSuper(const std::vector<int>& ops);
+  
+  /** \brief  Rewrite the algorithm into the superinstruction bytecode */
+  void initSuper();
+  
+  /** \brief  Re-execute the operations that depend on the inputs that changed since the previous evaluation */
+  void evaluateIncremental();
+  
+  /** \brief  Execute a sorted subset of the operations of the algorithm (no derivatives) */
+  void evaluateOps(const std::vector<int>& ops);
+  
+  /** \brief  The operations needed to calculate the outputs in oind (sorted), indices in the superinstruction bytecode if it is used */
+  std::vector<int> outputSlice(const std::vector<int>& oind) const;
+  
+  /** \brief  Execute a slice returned by outputSlice */
+  void evaluateSlice(const std::vector<int>& ops);
+  
+  /** \brief  Is executing a slice cheaper than a complete evaluation
+      False if the function is compiled or evaluated level by level, which cannot be restricted to a slice */
+  bool sliceWorthwhile(const std::vector<int>& ops) const;
+  
+  /** \brief  Find the operations that depend on each input, for incremental evaluation */
+  void initIncremental();
+  
+  /** \brief  Sort the expression graph into the algorithm and allocate the work vector */
+  void sortAlgorithm();
+  
+  /** \brief  Allocate the work vector and the tape for an algorithm without symbolic representation */
+  void initNumeric();
+  
+  /** \brief  Optionally reorder the algorithm for locality, then reassign the work vector, reusing the lowest free element if reuse is true */
+  void scheduleAlgorithm(bool reorder, bool reuse);
+  
+  /** \brief  Write the function in binary format */
+  void save(Serializer& s) const;
+  
+  /** \brief  Read a function written by save, optionally recreating the expression graph */
+  static SXFunction load(Deserializer& d, bool symbolic);
+  
+  /** \brief  Evaluate the function numerically for several points at once */
+  void evaluateBatch(const std::vector<std::vector<double> >& arg, std::vector<std::vector<double> >& res, int npoints);
+  
   /** \brief  evaluate symbolically while also propagating directional derivatives */
   virtual void evalSX(const std::vector<SXMatrix>& arg, std::vector<SXMatrix>& res, 
                       const std::vector<std::vector<SXMatrix> >& fseed, std::vector<std::vector<SXMatrix> >& fsens, 
@@ -107,10 +178,62 @@ class SXFunctionInternal : public XFunctionInternal<SXFunction,SXFunctionInterna
   
   /** \brief  all binary nodes of the tree in the order of execution */
   std::vector<AlgEl> algorithm_;
+  
+  /** \brief  Fused operations of the superinstruction bytecode, numbered after the built-in operations */
+  enum SuperOp{
+    SOP_ADD_C=NUM_BUILT_IN_OPS, // x + c
+    SOP_C_SUB,                  // c - x
+    SOP_MUL_C,                  // x * c
+    SOP_DIV_C,                  // x / c
+    SOP_C_DIV,                  // c / x
+    SOP_POW_C,                  // pow(x,c)
+    SOP_SQR,                    // x * x
+    SOP_POW2K,                  // c * x^(2^k), chains of squarings and negations
+    SOP_MULADD,                 // x * y + z
+    SOP_MULSUB,                 // x * y - z
+    SOP_NMULADD,                // z - x * y
+    SOP_MULADD_C                // x * c + z
+  };
+  
+  /** \brief  An element of the superinstruction bytecode */
+  struct SuperEl{
+    /// Built-in or fused operation
+    int op;
+    
+    /// Index of the result
+    int res;
+    
+    /// Arguments x, y and z, or the exponent k for SOP_POW2K in the last entry
+    int arg[3];
+    
+    /// Immediate constant
+    double c;
+  };
+  
+  /** \brief  The algorithm rewritten with fused operations and inline constants */
+  std::vector<SuperEl> super_alg_;
+  
+  /** \brief  Index in the algorithm of the last operation fused into each superinstruction */
+  std::vector<int> super_src_;
+  
+  /** \brief  Execute a superinstruction */
+  inline void evaluateSuperEl(const SuperEl* it, double* w);
 
   /** \brief  Working vector for numeric calculation */
   std::vector<double> work_;
   std::vector<TapeEl<double> > pdwork_;
+  
+  /** \brief  Working vector for directional derivatives, all directions of a work element stored contiguously */
+  std::vector<double> dwork_;
+
+  /** \brief  Propagate forward seeds, all directions at once, through a part of the algorithm given the partial derivatives */
+  void propagateFwd(int alg_begin, int alg_end, const TapeEl<double>* pd, int nfdir);
+  
+  /** \brief  Propagate adjoint seeds, all directions at once, backwards through a part of the algorithm given the end of the partial derivatives */
+  void propagateAdj(int alg_begin, int alg_end, const TapeEl<double>* pd_end, int nadir);
+  
+  /** \brief  Working vector for batch evaluation, all points of a work element stored contiguously */
+  std::vector<double> bwork_;
 
   /// work vector for symbolic calculations (allocated first time)
   std::vector<SX> s_work_;
@@ -133,6 +256,15 @@ class SXFunctionInternal : public XFunctionInternal<SXFunction,SXFunctionInterna
 
   /** \brief  Print to a c file */
   void generateCode(const std::string& filename);
+  
+  /** \brief  Print the C code to a stream, optionally with forward, adjoint and Jacobian routines */
+  void generateCode(std::ostream &cfile, bool with_derivatives);
+  
+  /** \brief  Print the body of the evaluate function */
+  void generateBody(std::ostream &cfile) const;
+  
+  /** \brief  Print the forward, adjoint and Jacobian routines */
+  void generateDerivatives(std::ostream &cfile);
       
   /** \brief Clear the function from its symbolic representation, to free up memory, no symbolic evaluations are possible after this */
   void clearSymbolic();
@@ -146,9 +278,55 @@ class SXFunctionInternal : public XFunctionInternal<SXFunction,SXFunctionInterna
   /// Reset the sparsity propagation
   virtual void spInit(bool fwd);
 
+  /// Propagate a sparsity pattern through the algorithm, several words per nonzero
+  virtual void spEvaluateBlock(bool fwd, int nw, int iind, int oind, const bvec_t* seed, bvec_t* sens, std::vector<bvec_t>& work);
+  
+  /// Propagate a sparsity pattern through the algorithm, NW words per nonzero
+  template<int NW>
+  void spEvaluateBlockGen(bool fwd, int iind, int oind, const bvec_t* seed, bvec_t* sens, std::vector<bvec_t>& work) const;
+
+  /// Is the class able to propagate several words per nonzero at once?
+  virtual bool spCanEvaluateBlock(bool fwd){ return true;}
+
+  /// Add the algorithm and the input and output sparsity patterns to a hash
+  virtual bool hashStructure(StructureHash& h);
+
   /// With just-in-time compilation
   bool just_in_time_;
   
+  /// Propagate all directions in a single sweep
+  bool vectorized_sweeps_;
+  
+  /// Evaluate using the superinstruction bytecode
+  bool super_;
+  
+  /// Store checkpoints of the work vector instead of the complete tape
+  bool checkpointing_;
+  
+  /// First element of the algorithm in each segment (and the end), number of partial derivatives in each segment
+  std::vector<int> seg_begin_, seg_ntape_;
+  
+  /// Work vector at the beginning of each segment after the first
+  std::vector<double> ckpt_;
+  
+  /// Evaluate operations on the same level in parallel
+  bool parallel_;
+  
+  /// Evaluate using generated, compiled and dynamically loaded code
+  bool jit_compile_;
+  
+  /// The dynamically loaded function
+  ExternalFunction jit_fcn_;
+  
+  /// Elements of the algorithm sorted by level, and the offset of each level
+  std::vector<int> par_alg_, par_level_offset_;
+  
+  /// Uses of each element of the work vector (2*place in the algorithm + argument index), and the offset for each element
+  std::vector<int> par_cons_, par_cons_offset_;
+  
+  /// Place in the tape of each element of the algorithm, -1 if none
+  std::vector<int> tape_ind_;
+  
   #ifdef WITH_LLVM
   llvm::Module *jit_module_;
   llvm::Function *jit_function_;
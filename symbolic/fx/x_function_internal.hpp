@@ -25,6 +25,8 @@
 
 #include <map>
 #include <stack>
+#include <algorithm>
+#include <limits>
 #include "fx_internal.hpp"
 #include "../matrix/sparsity_tools.hpp"
 
@@ -69,6 +71,13 @@ class XFunctionInternal : public FXInternal{
     /** \brief Generate a function that calculates nfdir forward derivatives and nadir adjoint derivatives */
     virtual FX getDerivative(int nfdir, int nadir);
     
+    /** \brief  Incremental evaluation: get the sorted list of operations that depend on the inputs that changed since the previous call
+        Returns false if the work vector is not up to date, in which case the complete algorithm must be evaluated */
+    bool incrementalOps(std::vector<int>& ops);
+    
+    /** \brief  Evaluate only the outputs with index in oind, skipping the operations that are not needed for them */
+    virtual void evaluateOutputs(const std::vector<int>& oind);
+    
     // Data members (all public)
     
     /** \brief  Inputs of the function (needed for symbolic calculations) */
@@ -76,15 +85,37 @@ class XFunctionInternal : public FXInternal{
 
     /** \brief  Outputs of the function (needed for symbolic calculations) */
     std::vector<MatType> outputv_;
+    
+    /** \brief  Re-execute only the operations that depend on inputs that changed */
+    bool incremental_;
+    
+    /** \brief  Incremental evaluation: the operations of the algorithm that depend on each input */
+    std::vector<std::vector<int> > inc_ops_;
+    
+    /** \brief  Incremental evaluation: the inputs at the previous evaluation */
+    std::vector<std::vector<double> > inc_input_;
+    
+    /** \brief  Incremental evaluation: is the work vector up to date with inc_input_ */
+    bool inc_valid_;
+    
+    /** \brief  Incremental evaluation: operations to re-execute (work) */
+    std::vector<int> inc_buf_;
+    
+    /** \brief  Incremental evaluation: marker for each operation (work) */
+    std::vector<bool> inc_mark_;
+    
+    /** \brief  Operations of the algorithm needed for each combination of requested outputs (cached) */
+    std::map<std::vector<int>,std::vector<int> > output_slices_;
 };
 
 // Template implementations
 
 template<typename PublicType, typename DerivedType, typename MatType, typename NodeType>
 XFunctionInternal<PublicType,DerivedType,MatType,NodeType>::XFunctionInternal(
-    const std::vector<MatType>& inputv, const std::vector<MatType>& outputv) : inputv_(inputv),  outputv_(outputv){
+    const std::vector<MatType>& inputv, const std::vector<MatType>& outputv) : inputv_(inputv),  outputv_(outputv), incremental_(false), inc_valid_(false){
       addOption("topological_sorting",OT_STRING,"depth-first","Topological sorting algorithm","depth-first|breadth-first");
       addOption("live_variables",OT_BOOLEAN,true,"Reuse variables in the work vector");
+      addOption("incremental",OT_BOOLEAN,false,"Keep all intermediate values and, when evaluating without derivatives, re-execute only the operations that depend on inputs that changed since the previous evaluation. Disables live_variables.");
   
   // Make sure that inputs are symbolic
   for(int i=0; i<inputv.size(); ++i){
@@ -116,6 +147,74 @@ XFunctionInternal<PublicType,DerivedType,MatType,NodeType>::XFunctionInternal(
 }
 
 
+template<typename PublicType, typename DerivedType, typename MatType, typename NodeType>
+bool XFunctionInternal<PublicType,DerivedType,MatType,NodeType>::incrementalOps(std::vector<int>& ops){
+  bool valid = inc_valid_;
+  inc_valid_ = true;
+  inc_input_.resize(getNumInputs());
+  ops.clear();
+  
+  // Find the inputs that changed
+  std::vector<const std::vector<int>*> changed;
+  for(int ind=0; ind<getNumInputs(); ++ind){
+    const std::vector<double>& v = inputNoCheck(ind).data();
+    if(valid && v==inc_input_[ind]) continue;
+    inc_input_[ind] = v;
+    if(valid && !inc_ops_[ind].empty()) changed.push_back(&inc_ops_[ind]);
+  }
+  
+  if(changed.size()==1){
+    ops = *changed.front();
+  } else if(changed.size()>1){
+    // Mark the operations depending on any of the inputs and collect them in order, within the range of operations affected
+    int first = std::numeric_limits<int>::max(), last = -1;
+    for(typename std::vector<const std::vector<int>*>::const_iterator c=changed.begin(); c!=changed.end(); ++c){
+      const std::vector<int>& dep = **c;
+      if(inc_mark_.size()<=dep.back()) inc_mark_.resize(dep.back()+1,false);
+      for(std::vector<int>::const_iterator it=dep.begin(); it!=dep.end(); ++it) inc_mark_[*it] = true;
+      first = std::min(first,dep.front());
+      last = std::max(last,dep.back());
+    }
+    for(int k=first; k<=last; ++k){
+      if(inc_mark_[k]){
+        ops.push_back(k);
+        inc_mark_[k] = false;
+      }
+    }
+  }
+  return valid;
+}
+
+template<typename PublicType, typename DerivedType, typename MatType, typename NodeType>
+void XFunctionInternal<PublicType,DerivedType,MatType,NodeType>::evaluateOutputs(const std::vector<int>& oind){
+  DerivedType* d = static_cast<DerivedType*>(this);
+  
+  // Sorted list of requested outputs, evaluate completely if all outputs are requested
+  std::vector<int> key = oind;
+  std::sort(key.begin(),key.end());
+  key.erase(std::unique(key.begin(),key.end()),key.end());
+  if(key.size()==getNumOutputs()){
+    d->evaluate(0,0);
+    return;
+  }
+  
+  // Find the operations needed, the first time a combination is requested
+  typename std::map<std::vector<int>,std::vector<int> >::iterator it = output_slices_.find(key);
+  if(it==output_slices_.end()){
+    it = output_slices_.insert(std::make_pair(key,d->outputSlice(key))).first;
+  }
+  
+  // Evaluate completely if the slice would bypass a faster evaluation or skip little work
+  if(!d->sliceWorthwhile(it->second)){
+    d->evaluate(0,0);
+    return;
+  }
+  
+  // The skipped operations leave the work vector out of date
+  d->evaluateSlice(it->second);
+  inc_valid_ = false;
+}
+
 template<typename PublicType, typename DerivedType, typename MatType, typename NodeType>
 void XFunctionInternal<PublicType,DerivedType,MatType,NodeType>::sort_depth_first(std::stack<NodeType*>& s, std::vector<NodeType*>& nodes){
 
@@ -530,6 +629,15 @@ MatType XFunctionInternal<PublicType,DerivedType,MatType,NodeType>::jac(int iind
   // A vector used to resolve collitions between directions
   std::vector<int> hits;
   
+  // For a bidirectional partition, the output nonzeros recovered in adjoint mode
+  std::vector<bool> adj_row;
+  if(nfdir>0 && nadir>0){
+    adj_row.resize(jsp.size1(),false);
+    for(int el=0; el<D2.size(); ++el){
+      adj_row[D2.col(el)] = true;
+    }
+  }
+  
   // Evaluate until everything has been determinated
   while (offset_nfdir < nfdir || offset_nadir < nadir) {
       
@@ -539,10 +647,10 @@ MatType XFunctionInternal<PublicType,DerivedType,MatType,NodeType>::jac(int iind
     
     // Forward seeds
     fseed.resize(nfdir_batch);
-    for(int d=0; d<nfdir; ++d){
+    for(int d=0; d<nfdir_batch; ++d){
       // initialize to zero
       fseed[d].resize(getNumInputs());
-      for(int ind=0; ind<fseed[offset_nfdir+d].size(); ++ind){
+      for(int ind=0; ind<fseed[d].size(); ++ind){
         fseed[d][ind] = MatType(input(ind).sparsity(),0);
       }
       
@@ -562,7 +670,7 @@ MatType XFunctionInternal<PublicType,DerivedType,MatType,NodeType>::jac(int iind
     for(int d=0; d<nadir_batch; ++d){
       //initialize to zero
       aseed[d].resize(getNumOutputs());
-      for(int ind=0; ind<aseed[offset_nadir+d].size(); ++ind){
+      for(int ind=0; ind<aseed[d].size(); ++ind){
         aseed[d][ind] = MatType(output(ind).sparsity(),0);
       }
       
@@ -582,7 +690,7 @@ MatType XFunctionInternal<PublicType,DerivedType,MatType,NodeType>::jac(int iind
     for(int d=0; d<nfdir_batch; ++d){
       // initialize to zero
       fsens[d].resize(getNumOutputs());
-      for(int oind=0; oind<fsens[offset_nfdir+d].size(); ++oind){
+      for(int oind=0; oind<fsens[d].size(); ++oind){
         fsens[d][oind] = MatType(output(oind).sparsity(),0);
       }
     }
@@ -592,7 +700,7 @@ MatType XFunctionInternal<PublicType,DerivedType,MatType,NodeType>::jac(int iind
     for(int d=0; d<nadir_batch; ++d){
       // initialize to zero
       asens[d].resize(getNumInputs());
-      for(int ind=0; ind<asens[offset_nadir+d].size(); ++ind){
+      for(int ind=0; ind<asens[d].size(); ++ind){
         asens[d][ind] = MatType(input(ind).sparsity(),0);
       }
     }
@@ -649,6 +757,9 @@ MatType XFunctionInternal<PublicType,DerivedType,MatType,NodeType>::jac(int iind
           // Get the output nonzero
           int r_out = jsp_trans.col(el_out);
           
+          // Skip if recovered in adjoint mode
+          if(!adj_row.empty() && adj_row[r_out]) continue;
+          
           // Get the forward sensitivity nonzero
           int f_out = nzmap[r_out];
           if(f_out<0) continue; // Skip if structurally zero
@@ -0,0 +1,59 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "binary_plan.hpp"
+
+using namespace std;
+
+namespace CasADi{
+
+BinaryPlan::BinaryPlan() : nnz(0), x_direct(true), y_direct(true){
+}
+
+BinaryPlan::BinaryPlan(const std::vector<unsigned char>& mapping) : nnz(0){
+  // Walk the merged patterns once
+  int el0=0, el1=0;
+  for(vector<unsigned char>::const_iterator it=mapping.begin(); it!=mapping.end(); ++it){
+    bool nz0 = *it & 1;
+    bool nz1 = *it & 2;
+    bool skip_nz = *it & 4;
+    if(!skip_nz){
+      if(nz0){
+        x_src.push_back(el0);
+        x_dst.push_back(nnz);
+      }
+      if(nz1){
+        y_src.push_back(el1);
+        y_dst.push_back(nnz);
+      }
+      nnz++;
+    }
+    el0 += nz0;
+    el1 += nz1;
+  }
+  
+  // Both lists are increasing, so they are the identity if no nonzero is skipped or missing
+  x_direct = x_src.size()==nnz && el0==nnz;
+  y_direct = y_src.size()==nnz && el1==nnz;
+}
+
+} // namespace CasADi
@@ -0,0 +1,55 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef BINARY_PLAN_HPP
+#define BINARY_PLAN_HPP
+
+#include <vector>
+
+namespace CasADi{
+
+/** \brief Precomputed structure of an elementwise binary operation z = f(x,y) for fixed sparsity patterns
+  Built from the mapping returned by CRSSparsity::patternUnion, the plan lists, for each argument, which of its
+  nonzeros ends up at which nonzero of z. Gathering the arguments with these lists into buffers of the size of z,
+  zero where the argument is structurally zero, turns the evaluation into a loop over the nonzeros of z which does
+  not need to walk the sparsity patterns.
+*/
+struct BinaryPlan{
+  /// Default constructor, an empty plan
+  BinaryPlan();
+  
+  /// Construct the plan from the mapping of CRSSparsity::patternUnion
+  explicit BinaryPlan(const std::vector<unsigned char>& mapping);
+  
+  /// Number of nonzeros of z
+  int nnz;
+  
+  /// Nonzero x_src[k] of x (y_src[k] of y) corresponds to nonzero x_dst[k] (y_dst[k]) of z
+  std::vector<int> x_src, x_dst, y_src, y_dst;
+  
+  /// The nonzeros of x (y) are exactly the nonzeros of z, no gathering is needed
+  bool x_direct, y_direct;
+};
+
+} // namespace CasADi
+
+#endif // BINARY_PLAN_HPP
@@ -412,22 +412,38 @@ void CRSSparsity::getNZInplace(std::vector<int>& indices) const{
   (*this)->getNZInplace(indices);
 }
 
-CRSSparsity CRSSparsity::unidirectionalColoring(const CRSSparsity& AT) const{
+CRSSparsity CRSSparsity::unidirectionalColoring(const CRSSparsity& AT, int ordering, int recolor, bool parallel) const{
   if(AT.isNull()){
-    return (*this)->unidirectionalColoring(transpose());
+    return (*this)->unidirectionalColoring(transpose(),ordering,recolor,parallel);
   } else {
-    return (*this)->unidirectionalColoring(AT);
+    return (*this)->unidirectionalColoring(AT,ordering,recolor,parallel);
   }
 }
 
-CRSSparsity CRSSparsity::starColoring(int ordering) const{
-  return (*this)->starColoring(ordering);
+int CRSSparsity::bidirectionalColoring(CRSSparsity& D1, CRSSparsity& D2, int adj_penalty, const CRSSparsity& AT, int ordering, int recolor, bool parallel) const{
+  if(AT.isNull()){
+    return (*this)->bidirectionalColoring(transpose(),D1,D2,adj_penalty,ordering,recolor,parallel);
+  } else {
+    return (*this)->bidirectionalColoring(AT,D1,D2,adj_penalty,ordering,recolor,parallel);
+  }
+}
+
+CRSSparsity CRSSparsity::starColoring(int ordering, int recolor) const{
+  return (*this)->starColoring(ordering,recolor);
 }
 
 std::vector<int> CRSSparsity::largestFirstOrdering() const{
   return (*this)->largestFirstOrdering();
 }
 
+std::vector<int> CRSSparsity::smallestLastOrdering(const CRSSparsity& AT) const{
+  return (*this)->smallestLastOrdering(AT);
+}
+
+std::vector<int> CRSSparsity::incidenceDegreeOrdering(const CRSSparsity& AT) const{
+  return (*this)->incidenceDegreeOrdering(AT);
+}
+
 CRSSparsity CRSSparsity::pmult(const std::vector<int>& p, bool permute_rows, bool permute_columns, bool invert_permutation) const{
   return (*this)->pmult(p,permute_rows,permute_columns,invert_permutation);
 }
@@ -336,17 +336,45 @@ class CRSSparsity : public SharedObject{
     /// Get the location of all nonzero elements (inplace version)
     void getElements(std::vector<int>& loc, bool row_major=true) const;
     
-    /** \brief Perform a unidirectional coloring: A greedy distance-2 coloring algorithm (Algorithm 3.1 in A. H. GEBREMEDHIN, F. MANNE, A. POTHEN) */
-    CRSSparsity unidirectionalColoring(const CRSSparsity& AT=CRSSparsity()) const;
+    /** \brief Perform a unidirectional coloring: A greedy distance-2 coloring algorithm (Algorithm 3.1 in A. H. GEBREMEDHIN, F. MANNE, A. POTHEN) 
+      Ordering options: None (0), largest first (1), smallest last (2), incidence degree (3).
+      Each recoloring pass recolors the rows class by class, in reverse order of the colors, which never increases the number of colors.
+      If parallel is true and CasADi was compiled with WITH_OPENMP, the rows are colored speculatively in parallel, with conflicts resolved in
+      additional rounds; the result then depends on the thread scheduling.
+      */
+    CRSSparsity unidirectionalColoring(const CRSSparsity& AT=CRSSparsity(), int ordering=0, int recolor=0, bool parallel=false) const;
+
+#ifndef SWIG
+    /** \brief Perform a bidirectional coloring for Jacobian compression using both forward and adjoint mode
+      The densest rows are recovered in adjoint mode, with the rows coloring returned in D2, and the remaining
+      rows are recovered in forward mode, with the column coloring returned in D1. The Jacobian entries in
+      the rows seeded by D2 must be taken from the adjoint sweeps, all other entries from the forward sweeps.
+      The last three arguments are passed on to unidirectionalColoring.
+      Returns the cost D1.size1() + adj_penalty*D2.size1() or -1 (and null D1,D2) if no partition was found.
+      */
+    int bidirectionalColoring(CRSSparsity& D1, CRSSparsity& D2, int adj_penalty=2, const CRSSparsity& AT=CRSSparsity(), int ordering=0, int recolor=0, bool parallel=false) const;
+#endif // SWIG
 
     /** \brief Perform a star coloring of a symmetric matrix:
       A greedy distance-2 coloring algorithm (Algorithm 4.1 in A. H. GEBREMEDHIN, F. MANNE, A. POTHEN) 
-      Ordering options: None (0), largest first (1)
+      Ordering options: None (0), largest first (1), smallest last (2), incidence degree (3).
+      A recoloring pass is only kept if it reduces the number of colors.
       */
-    CRSSparsity starColoring(int ordering = 1) const;
+    CRSSparsity starColoring(int ordering = 1, int recolor = 0) const;
     
     /** \brief Order the rows by decreasing degree */
     std::vector<int> largestFirstOrdering() const;
+
+    /** \brief Smallest last ordering (Matula and Beck)
+      Ordering of the adjacency graph of a symmetric pattern if AT is null, otherwise of the graph
+      in which two rows are adjacent if they share a column (as colored by unidirectionalColoring(AT)).
+      */
+    std::vector<int> smallestLastOrdering(const CRSSparsity& AT=CRSSparsity()) const;
+
+    /** \brief Incidence degree ordering: repeatedly pick the row with the most already ordered neighbors
+      The graph is chosen as in smallestLastOrdering.
+      */
+    std::vector<int> incidenceDegreeOrdering(const CRSSparsity& AT=CRSSparsity()) const;
     
     /** \brief Permute rows and/or columns
       Multiply the sparsity with a permutation matrix from the left and/or from the right
@@ -2753,19 +2753,63 @@ void CRSSparsityInternal::getNZInplace(std::vector<int>& indices) const{
   fill(it,indices.end(),-1);
 }
 
-CRSSparsity CRSSparsityInternal::unidirectionalColoring(const CRSSparsity& AT) const{
+CRSSparsity CRSSparsityInternal::unidirectionalColoring(const CRSSparsity& AT, int ordering, int recolor, bool parallel) const{
   
-  // Allocate temporary vectors
-  vector<int> forbiddenColors;
-  forbiddenColors.reserve(nrow_);
-  vector<int> color(nrow_,0);
+  // Order in which the rows are colored, empty means natural ordering
+  vector<int> ord = coloringOrdering(ordering,AT);
+
+  // Greedy coloring
+  vector<int> color;
+  int num_colors;
+#ifdef WITH_OPENMP
+  if(parallel){
+    num_colors = greedyColoringParallel(AT,ord,color);
+  } else {
+    num_colors = greedyColoring(AT,ord,color);
+  }
+#else // WITH_OPENMP
+  num_colors = greedyColoring(AT,ord,color);
+#endif // WITH_OPENMP
   
-  // Access the sparsity of the transpose
+  // The rows sharing a column need different colors
+  int min_colors = 1;
   const vector<int>& AT_rowind = AT.rowind();
-  const vector<int>& AT_col = AT.col();
+  for(int c=0; c<ncol_; ++c){
+    min_colors = max(min_colors,AT_rowind[c+1]-AT_rowind[c]);
+  }
+  
+  // Recoloring passes: visiting the color classes in reverse order never increases the number of colors
+  vector<int> new_color;
+  for(int pass=0; pass<recolor && num_colors>min_colors; ++pass){
+    colorClassOrdering(num_colors,color,ord,false);
+    int new_num_colors = greedyColoring(AT,ord,new_color);
+    if(new_num_colors>num_colors) break;
+    color.swap(new_color);
+    num_colors = new_num_colors;
+  }
+  
+  // Return the coloring as a seed matrix
+  return sp_triplet(num_colors,nrow_,color,range(nrow_));
+}
+
+int CRSSparsityInternal::greedyColoring(const CRSSparsity& AT, const std::vector<int>& ord, std::vector<int>& color) const{
+  
+  // Natural ordering if none given
+  bool natural = ord.empty();
+
+  // Access the sparsity of the transpose
+  const int* AT_rowind = getPtr(AT.rowind());
+  const int* AT_col = getPtr(AT.col());
+  
+  // Colors forbidden for the current row, marked with the index of the row
+  vector<int> forbiddenColors;
+  forbiddenColors.reserve(64);
+  color.resize(nrow_);
+  fill(color.begin(),color.end(),-1);
   
   // Loop over rows
-  for(int i=0; i<nrow_; ++i){
+  for(int k=0; k<nrow_; ++k){
+    int i = natural ? k : ord[k];
     
     // Loop over nonzero elements
     for(int el=rowind_[i]; el<rowind_[i+1]; ++el){
@@ -2773,21 +2817,18 @@ CRSSparsity CRSSparsityInternal::unidirectionalColoring(const CRSSparsity& AT) c
       // Get column
       int c = col_[el];
         
-      // Loop over previous rows that have an element in column c
+      // Loop over other rows that have an element in column c
       for(int el_prev=AT_rowind[c]; el_prev<AT_rowind[c+1]; ++el_prev){
         
         // Get the row
         int i_prev = AT_col[el_prev];
         
-        // Escape loop if we have arrived at the current row
-        if(i_prev>=i)
-          break;
+        // In natural ordering, escape loop if we have arrived at the current row
+        if(natural && i_prev>=i) break;
         
-        // Get the color of the row
+        // Mark the color of the row, if any, as forbidden for the current row
         int color_prev = color[i_prev];
-        
-        // Mark the color as forbidden for the current row
-        forbiddenColors[color_prev] = i;
+        if(color_prev>=0) forbiddenColors[color_prev] = i;
       }
     }
     
@@ -2801,69 +2842,290 @@ CRSSparsity CRSSparsityInternal::unidirectionalColoring(const CRSSparsity& AT) c
     
     // Add color if reached end
     if(color_i==forbiddenColors.size())
-      forbiddenColors.push_back(0);
+      forbiddenColors.push_back(-1);
   }
+
+  return forbiddenColors.size();
+}
+
+#ifdef WITH_OPENMP
+int CRSSparsityInternal::greedyColoringParallel(const CRSSparsity& AT, const std::vector<int>& ord, std::vector<int>& color) const{
+
+  // Access the sparsity of the transpose
+  const int* AT_rowind = getPtr(AT.rowind());
+  const int* AT_col = getPtr(AT.col());
   
-  // Create return sparsity containing the coloring
-  CRSSparsity ret(forbiddenColors.size(),nrow_);
-  vector<int>& rowind = ret.rowindRef();
-  vector<int>& col = ret.colRef();
+  // Rows to be colored, in order
+  vector<int> work = ord.empty() ? range(nrow_) : ord;
   
-  // Get the number of columns for each row
-  for(int i=0; i<color.size(); ++i){
-    rowind[color[i]+1]++;
+  // Position of each row in the ordering
+  vector<int> pos(nrow_);
+  for(int k=0; k<nrow_; ++k) pos[work[k]] = k;
+  
+  color.resize(nrow_);
+  fill(color.begin(),color.end(),-1);
+  vector<char> conflict;
+  
+  // Colors at the start of the round: the threads only read from this copy, so no row is read while it is being colored
+  vector<int> color_old;
+
+  // Speculative coloring rounds: color all rows in the work list concurrently, then recolor the rows that got the same color as a row coming earlier in the ordering
+  while(!work.empty()){
+    int nwork = work.size();
+    color_old = color;
+    const int* color_old_ptr = getPtr(color_old);
+    
+    #pragma omp parallel
+    {
+      // Colors forbidden for the current row, marked with a per-thread counter
+      vector<int> forbiddenColors;
+      int mark = 0;
+      
+      #pragma omp for schedule(dynamic,256)
+      for(int k=0; k<nwork; ++k){
+        int i = work[k];
+        mark++;
+        for(int el=rowind_[i]; el<rowind_[i+1]; ++el){
+          int c = col_[el];
+          for(int el_prev=AT_rowind[c]; el_prev<AT_rowind[c+1]; ++el_prev){
+            int i_prev = AT_col[el_prev];
+            if(i_prev==i) continue;
+            int color_prev = color_old_ptr[i_prev];
+            if(color_prev>=0){
+              if(color_prev>=forbiddenColors.size()) forbiddenColors.resize(color_prev+1,0);
+              forbiddenColors[color_prev] = mark;
+            }
+          }
+        }
+        int color_i;
+        for(color_i=0; color_i<forbiddenColors.size(); ++color_i){
+          if(forbiddenColors[color_i]!=mark) break;
+        }
+        color[i] = color_i;
+      }
+    }
+    
+    // Detect conflicts
+    conflict.resize(nwork);
+    #pragma omp parallel for schedule(dynamic,256)
+    for(int k=0; k<nwork; ++k){
+      int i = work[k];
+      conflict[k] = 0;
+      for(int el=rowind_[i]; el<rowind_[i+1] && !conflict[k]; ++el){
+        int c = col_[el];
+        for(int el_prev=AT_rowind[c]; el_prev<AT_rowind[c+1]; ++el_prev){
+          int i_prev = AT_col[el_prev];
+          if(i_prev!=i && color[i_prev]==color[i] && pos[i_prev]<pos[i]){
+            conflict[k] = 1;
+            break;
+          }
+        }
+      }
+    }
+    
+    // Rows that need to be recolored
+    int nconflict = 0;
+    for(int k=0; k<nwork; ++k){
+      if(conflict[k]){
+        color[work[k]] = -1;
+        work[nconflict++] = work[k];
+      }
+    }
+    work.resize(nconflict);
   }
   
-  // Cumsum
-  for(int j=0; j<forbiddenColors.size(); ++j){
-    rowind[j+1] += rowind[j];
+  // Remove unused colors
+  vector<int> color_map;
+  for(int i=0; i<nrow_; ++i){
+    if(color[i]>=color_map.size()) color_map.resize(color[i]+1,-1);
+    color_map[color[i]] = 0;
+  }
+  int num_colors = 0;
+  for(vector<int>::iterator it=color_map.begin(); it!=color_map.end(); ++it){
+    if(*it==0) *it = num_colors++;
+  }
+  for(int i=0; i<nrow_; ++i){
+    color[i] = color_map[color[i]];
+  }
+  return num_colors;
+}
+#endif // WITH_OPENMP
+
+void CRSSparsityInternal::colorClassOrdering(int num_colors, const std::vector<int>& color, std::vector<int>& ord, bool smallest_first){
+  // Size of each color class
+  vector<int> class_size(num_colors,0);
+  for(vector<int>::const_iterator it=color.begin(); it!=color.end(); ++it){
+    class_size[*it]++;
   }
   
-  // Get column for each row
-  col.resize(color.size());
-  for(int j=0; j<col.size(); ++j){
-    col[rowind[color[j]]++] = j;
+  // Order of the classes: reverse order of the colors, or by increasing size
+  vector<int> class_ord(num_colors);
+  for(int c=0; c<num_colors; ++c){
+    class_ord[c] = num_colors-1-c;
+  }
+  if(smallest_first){
+    vector<pair<int,int> > size_and_class(num_colors);
+    for(int c=0; c<num_colors; ++c){
+      size_and_class[c] = make_pair(class_size[class_ord[c]],class_ord[c]);
+    }
+    stable_sort(size_and_class.begin(),size_and_class.end());
+    for(int c=0; c<num_colors; ++c){
+      class_ord[c] = size_and_class[c].second;
+    }
   }
   
-  // Swap index back one step
-  for(int j=rowind.size()-2; j>=0; --j){
-    rowind[j+1] = rowind[j];
+  // Offset of each class in the new ordering
+  vector<int> offset(num_colors);
+  int k=0;
+  for(int c=0; c<num_colors; ++c){
+    offset[class_ord[c]] = k;
+    k += class_size[class_ord[c]];
   }
-  rowind[0] = 0;
   
-  // Return the coloring
-  return ret;
+  // Bucket sort the vertices, keeping the current order within each class
+  ord.resize(color.size());
+  for(int i=0; i<color.size(); ++i){
+    ord[offset[color[i]]++] = i;
+  }
 }
 
-CRSSparsity CRSSparsityInternal::starColoring(int ordering) const{
-  // Reorder, if necessary
-  if(ordering!=0){
-    casadi_assert(ordering==1);
-    
-    // Ordering
-    vector<int> ord = largestFirstOrdering();
+int CRSSparsityInternal::bidirectionalColoring(const CRSSparsity& AT, CRSSparsity& D1, CRSSparsity& D2, int adj_penalty, int ordering, int recolor, bool parallel) const{
+  D1 = D2 = CRSSparsity();
+  if(nrow_<2) return -1;
 
-    // Create a new sparsity pattern 
-    CRSSparsity sp_permuted = pmult(ord,true,true,true);
+  // Access the sparsity of the transpose
+  const vector<int>& AT_rowind = AT.rowind();
+  const vector<int>& AT_col = AT.col();
+  
+  // Rows ordered by decreasing number of nonzeros
+  vector<int> ord = largestFirstOrdering();
+  
+  // Rows recovered in adjoint mode
+  vector<bool> adj_row(nrow_,false);
+  
+  // Cost of the best partition found so far
+  int best_cost = -1;
+  
+  // Number of rows recovered in adjoint mode for the previous candidate
+  int nadj_prev = 0;
+  
+  // Try recovering the k densest rows in adjoint mode, increasing k at least geometrically
+  for(int k=1; k<nrow_; ++k){
     
-    // Star coloring for the permuted matrix
-    CRSSparsity ret_permuted = sp_permuted.starColoring(0);
-        
-    // Permute result back
-    return ret_permuted.pmult(ord,false,true,false);
+    // Only split where the number of nonzeros drops
+    int nnz_adj = rowind_[ord[k-1]+1]-rowind_[ord[k-1]];
+    int nnz_fwd = rowind_[ord[k]+1]-rowind_[ord[k]];
+    if(nnz_adj<=nnz_fwd || k<2*nadj_prev) continue;
+    
+    // The forward part needs at least nnz_fwd colors, no improvement possible
+    if(best_cost>=0 && nnz_fwd+adj_penalty>=best_cost) continue;
+    
+    // Mark the rows recovered in adjoint mode
+    for(int i=nadj_prev; i<k; ++i) adj_row[ord[i]] = true;
+    nadj_prev = k;
+    
+    // Rows recovered in forward mode
+    vector<int> fwd_rowind(1,0), fwd_col;
+    fwd_rowind.reserve(nrow_+1);
+    for(int i=0; i<nrow_; ++i){
+      if(!adj_row[i]) fwd_col.insert(fwd_col.end(),col_.begin()+rowind_[i],col_.begin()+rowind_[i+1]);
+      fwd_rowind.push_back(fwd_col.size());
+    }
+    CRSSparsity A_fwd(nrow_,ncol_,fwd_col,fwd_rowind);
+    
+    // Rows recovered in adjoint mode, stored only by the transpose
+    vector<int> adjT_rowind(1,0), adjT_col;
+    adjT_rowind.reserve(ncol_+1);
+    for(int j=0; j<ncol_; ++j){
+      for(int el=AT_rowind[j]; el<AT_rowind[j+1]; ++el){
+        if(adj_row[AT_col[el]]) adjT_col.push_back(AT_col[el]);
+      }
+      adjT_rowind.push_back(adjT_col.size());
+    }
+    CRSSparsity A_adjT(ncol_,nrow_,adjT_col,adjT_rowind);
+    
+    // Color the columns of the forward part
+    CRSSparsity D1_k = A_fwd.transpose().unidirectionalColoring(A_fwd,ordering,recolor,parallel);
+    
+    // Color the rows of the adjoint part, the remaining rows are all given the first color
+    CRSSparsity D2_all = A_adjT.transpose().unidirectionalColoring(A_adjT,ordering,recolor,parallel);
+    
+    // Keep only the rows recovered in adjoint mode in the seed matrix
+    vector<int> D2_rowind(1,0), D2_col;
+    D2_col.reserve(k);
+    for(int d=0; d<D2_all.size1(); ++d){
+      for(int el=D2_all.rowind(d); el<D2_all.rowind(d+1); ++el){
+        if(adj_row[D2_all.col(el)]) D2_col.push_back(D2_all.col(el));
+      }
+      if(D2_col.size()>D2_rowind.back()) D2_rowind.push_back(D2_col.size());
+    }
+    CRSSparsity D2_k(D2_rowind.size()-1,nrow_,D2_col,D2_rowind);
+    
+    // Save if better
+    int cost = D1_k.size1() + adj_penalty*D2_k.size1();
+    if(best_cost<0 || cost<best_cost){
+      best_cost = cost;
+      D1 = D1_k;
+      D2 = D2_k;
+    }
   }
   
+  return best_cost;
+}
+
+CRSSparsity CRSSparsityInternal::starColoring(int ordering, int recolor) const{
+  casadi_assert_message(nrow_==ncol_, "CRSSparsityInternal::starColoring: Matrix must be square and symmetric");
+  
+  // Order in which the rows are colored, empty means natural ordering
+  vector<int> ord = coloringOrdering(ordering,CRSSparsity());
+  
+  // Greedy star coloring
+  vector<int> color;
+  int num_colors = starColoringGreedy(ord,color);
+  
+  // Recoloring passes, keeping the result only if it is better. The reverse class order has no guarantee for
+  // star colorings and does badly when the vertices of high degree end up last, so the smallest classes go first.
+  vector<int> new_color;
+  for(int pass=0; pass<recolor && num_colors>1; ++pass){
+    colorClassOrdering(num_colors,color,ord,true);
+    int new_num_colors = starColoringGreedy(ord,new_color);
+    if(new_num_colors>=num_colors) break;
+    color.swap(new_color);
+    num_colors = new_num_colors;
+  }
+
+  // Return sparsity in sparse triplet format
+  return sp_triplet(num_colors,nrow_,color,range(nrow_));
+}
+
+int CRSSparsityInternal::starColoringGreedy(const std::vector<int>& ord, std::vector<int>& color) const{
+  
+  // Natural ordering if none given
+  bool natural = ord.empty();
+  
   // Allocate temporary vectors
   vector<int> forbiddenColors;
-  forbiddenColors.reserve(nrow_);
-  vector<int> color(nrow_,-1);
+  forbiddenColors.reserve(64);
+  color.resize(nrow_);
+  fill(color.begin(),color.end(),-1);
+  
+  // The lists below are stored in the place of the nonzeros of each row, a vertex cannot have more distinct neighbor colors than neighbors
+  
+  // The distinct colors among the colored neighbors of each vertex and how often they appear
+  vector<int> nb_color(col_.size()), nb_count(col_.size()), nb_ncolors(nrow_,0);
+  
+  // For each colored vertex w, the colors of its colored neighbors x having another colored neighbor y with color[y]==color[w]
+  // (lines 9-19 of the algorithm, maintained incrementally so that the path w-x-y does not need to be searched for)
+  vector<int> path_color(col_.size()), path_ncolors(nrow_,0);
     
   // 4: for i <- 1 to |V | do
-  for(int i=0; i<nrow_; ++i){
+  for(int k=0; k<nrow_; ++k){
+    int i = natural ? k : ord[k];
         
     // 5: for each w \in N1 (vi ) do
     for(int w_el=rowind_[i]; w_el<rowind_[i+1]; ++w_el){
       int w = col_[w_el];
+      if(w==i) continue;
               
       // 6: if w is colored then
       if(color[w]!=-1){
@@ -2871,69 +3133,81 @@ CRSSparsity CRSSparsityInternal::starColoring(int ordering) const{
         // 7: forbiddenColors[color[w]] <- v
         forbiddenColors[color[w]] = i;
         
-      } // 8: end if
-
-      // 9: for each colored vertex x \in N1 (w) do
-      for(int x_el=rowind_[w]; x_el<rowind_[w+1]; ++x_el){
-        int x = col_[x_el];
-        if(color[x]==-1) continue;
+        // 9-19: forbiddenColors[color[x]] <- vi for each colored x \in N1 (w) with a colored neighbor y != w, color[y] = color[w]
+        for(int el=rowind_[w]; el<rowind_[w]+path_ncolors[w]; ++el){
+          forbiddenColors[path_color[el]] = i;
+        }
+      } else {
         
-        // 10: if w is not colored then
-        if(color[w]==-1){
-          
-          //11: forbiddenColors[color[x]] <- vi
-          forbiddenColors[color[x]] = i;
-          
-        } else { // 12: else
-          
-          // 13: for each colored vertex y \in N1 (x), y != w do
-          for(int y_el=rowind_[x]; y_el<rowind_[x+1]; ++y_el){
-            int y = col_[y_el];
-            if(color[y]==-1 || y==w) continue;
-            
-            // 14: if color[y] = color[w] then
-            if(color[y]==color[w]){
-              
-              // 15: forbiddenColors[color[x]] <- vi
-              forbiddenColors[color[x]] = i;
-              
-              // 16: break
-              break;
-              
-            } // 17: end if
-            
-          } // 18: end for
-          
-        } // 19: end if
-
-      } // 20 end for
-      
+        // 10-11: if w is not colored, then forbiddenColors[color[x]] <- vi for each colored vertex x \in N1 (w)
+        for(int el=rowind_[w]; el<rowind_[w]+nb_ncolors[w]; ++el){
+          forbiddenColors[nb_color[el]] = i;
+        }
+      }
     } // 21 end for
     
     // 22: color[v] <- min{c > 0 : forbiddenColors[c] = v}
-    bool new_color = true;
-    for(int color_i=0; color_i<forbiddenColors.size(); ++color_i){
+    int color_i;
+    for(color_i=0; color_i<forbiddenColors.size(); ++color_i){
       // Break if color is ok
-      if(forbiddenColors[color_i]!=i){
-        color[i] = color_i;
-        new_color = false;
-        break;
-      }
+      if(forbiddenColors[color_i]!=i) break;
     }
+    color[i] = color_i;
     
     // New color if reached end
-    if(new_color){
-      color[i] = forbiddenColors.size();
+    if(color_i==forbiddenColors.size())
       forbiddenColors.push_back(-1);
+    
+    // Register the color with the neighbors
+    for(int w_el=rowind_[i]; w_el<rowind_[i+1]; ++w_el){
+      int x = col_[w_el];
+      if(x==i) continue;
+      int el = findColor(nb_color,rowind_[x],nb_ncolors[x],color_i);
+      if(el<0){
+        el = rowind_[x] + nb_ncolors[x]++;
+        nb_color[el] = color_i;
+        nb_count[el] = 0;
+      }
+      nb_count[el]++;
+      
+      // A colored neighbor x that now has two or more neighbors with the new color
+      if(color[x]>=0 && nb_count[el]>=2){
+        if(nb_count[el]==2){
+          // All its neighbors with that color get a new path
+          for(int y_el=rowind_[x]; y_el<rowind_[x+1]; ++y_el){
+            int y = col_[y_el];
+            if(y!=x && color[y]==color_i) addColor(path_color,rowind_[y],path_ncolors[y],color[x]);
+          }
+        } else {
+          // Only the new vertex gets a new path
+          addColor(path_color,rowind_[i],path_ncolors[i],color[x]);
+        }
+      }
+    }
+    
+    // The new vertex as the middle vertex of paths
+    for(int w_el=rowind_[i]; w_el<rowind_[i+1]; ++w_el){
+      int w = col_[w_el];
+      if(w==i || color[w]<0) continue;
+      int el = findColor(nb_color,rowind_[i],nb_ncolors[i],color[w]);
+      if(nb_count[el]>=2) addColor(path_color,rowind_[w],path_ncolors[w],color_i);
     }
   
   } // 23 end for
 
   // Number of colors used
-  int num_colors = forbiddenColors.size();
+  return forbiddenColors.size();
+}
 
-  // Return sparsity in sparse triplet format
-  return sp_triplet(num_colors,nrow_,color,range(color.size()));
+int CRSSparsityInternal::findColor(const std::vector<int>& colors, int offset, int n, int c){
+  for(int el=offset; el<offset+n; ++el){
+    if(colors[el]==c) return el;
+  }
+  return -1;
+}
+
+void CRSSparsityInternal::addColor(std::vector<int>& colors, int offset, int& n, int c){
+  if(findColor(colors,offset,n,c)<0) colors[offset + n++] = c;
 }
 
 std::vector<int> CRSSparsityInternal::largestFirstOrdering() const{
@@ -2971,6 +3245,164 @@ std::vector<int> CRSSparsityInternal::largestFirstOrdering() const{
   return reverse_ordering;
 }
 
+std::vector<int> CRSSparsityInternal::coloringOrdering(int ordering, const CRSSparsity& AT) const{
+  switch(ordering){
+    case 0: return vector<int>(); // natural
+    case 1: return largestFirstOrdering();
+    case 2: return smallestLastOrdering(AT);
+    case 3: return incidenceDegreeOrdering(AT);
+    default: casadi_error("CRSSparsityInternal::coloringOrdering: Unknown ordering " << ordering << ". Possible values are none (0), largest first (1), smallest last (2) and incidence degree (3)");
+  }
+}
+
+void CRSSparsityInternal::getNeighbors(int i, const CRSSparsity& AT, std::vector<int>& nb, std::vector<int>& mark) const{
+  nb.clear();
+  mark[i] = i;
+  if(AT.isNull()){
+    // Adjacency graph of a symmetric pattern
+    for(int el=rowind_[i]; el<rowind_[i+1]; ++el){
+      int j = col_[el];
+      if(mark[j]!=i){
+        mark[j] = i;
+        nb.push_back(j);
+      }
+    }
+  } else {
+    // Rows sharing a column
+    const vector<int>& AT_rowind = AT.rowind();
+    const vector<int>& AT_col = AT.col();
+    for(int el=rowind_[i]; el<rowind_[i+1]; ++el){
+      int c = col_[el];
+      for(int el_c=AT_rowind[c]; el_c<AT_rowind[c+1]; ++el_c){
+        int j = AT_col[el_c];
+        if(mark[j]!=i){
+          mark[j] = i;
+          nb.push_back(j);
+        }
+      }
+    }
+  }
+}
+
+std::vector<int> CRSSparsityInternal::smallestLastOrdering(const CRSSparsity& AT) const{
+  vector<int> nb, mark(nrow_,-1);
+  
+  // Degree of each vertex
+  vector<int> degree(nrow_);
+  int max_degree = 0;
+  for(int i=0; i<nrow_; ++i){
+    getNeighbors(i,AT,nb,mark);
+    degree[i] = nb.size();
+    max_degree = max(max_degree,degree[i]);
+  }
+  
+  // Vertices in doubly linked lists, one for each degree
+  vector<int> head(max_degree+1,-1), next(nrow_), prev(nrow_);
+  for(int i=nrow_-1; i>=0; --i){
+    prev[i] = -1;
+    next[i] = head[degree[i]];
+    if(next[i]>=0) prev[next[i]] = i;
+    head[degree[i]] = i;
+  }
+  
+  // Repeatedly remove a vertex of minimal degree, the vertices removed first are colored last
+  vector<int> ord(nrow_);
+  vector<bool> removed(nrow_,false);
+  int min_degree = 0;
+  for(int k=nrow_-1; k>=0; --k){
+    
+    // Get a vertex of minimal degree and remove it
+    while(head[min_degree]<0) min_degree++;
+    int v = head[min_degree];
+    head[min_degree] = next[v];
+    if(next[v]>=0) prev[next[v]] = -1;
+    removed[v] = true;
+    ord[k] = v;
+    
+    // Update the degree of the remaining neighbors
+    getNeighbors(v,AT,nb,mark);
+    for(vector<int>::const_iterator it=nb.begin(); it!=nb.end(); ++it){
+      int j = *it;
+      if(removed[j]) continue;
+      
+      // Unlink
+      if(prev[j]>=0){
+        next[prev[j]] = next[j];
+      } else {
+        head[degree[j]] = next[j];
+      }
+      if(next[j]>=0) prev[next[j]] = prev[j];
+      
+      // Link into the list of the lower degree
+      int d = --degree[j];
+      prev[j] = -1;
+      next[j] = head[d];
+      if(next[j]>=0) prev[next[j]] = j;
+      head[d] = j;
+      min_degree = min(min_degree,d);
+    }
+  }
+  
+  return ord;
+}
+
+std::vector<int> CRSSparsityInternal::incidenceDegreeOrdering(const CRSSparsity& AT) const{
+  vector<int> nb, mark(nrow_,-1);
+
+  // Vertices in doubly linked lists, one for each number of ordered neighbors, initially all in the first list 
+  // with the vertices with the most nonzeros first
+  vector<int> lf = largestFirstOrdering();
+  vector<int> incidence(nrow_,0);
+  vector<int> head(nrow_+1,-1), next(nrow_), prev(nrow_);
+  for(int k=nrow_-1; k>=0; --k){
+    int i = lf[k];
+    prev[i] = -1;
+    next[i] = head[0];
+    if(next[i]>=0) prev[next[i]] = i;
+    head[0] = i;
+  }
+  
+  // Repeatedly pick the vertex with the most already ordered neighbors
+  vector<int> ord(nrow_);
+  vector<bool> ordered(nrow_,false);
+  int max_incidence = 0;
+  for(int k=0; k<nrow_; ++k){
+    
+    // Get a vertex of maximal incidence and remove it
+    while(head[max_incidence]<0) max_incidence--;
+    int v = head[max_incidence];
+    head[max_incidence] = next[v];
+    if(next[v]>=0) prev[next[v]] = -1;
+    ordered[v] = true;
+    ord[k] = v;
+    
+    // Update the incidence of the neighbors that have not yet been ordered
+    getNeighbors(v,AT,nb,mark);
+    for(vector<int>::const_iterator it=nb.begin(); it!=nb.end(); ++it){
+      int j = *it;
+      if(ordered[j]) continue;
+      
+      // Unlink
+      if(prev[j]>=0){
+        next[prev[j]] = next[j];
+      } else {
+        head[incidence[j]] = next[j];
+      }
+      if(next[j]>=0) prev[next[j]] = prev[j];
+      
+      // Link into the list of the higher incidence
+      int d = ++incidence[j];
+      prev[j] = -1;
+      next[j] = head[d];
+      if(next[j]>=0) prev[next[j]] = j;
+      head[d] = j;
+      max_incidence = max(max_incidence,d);
+    }
+  }
+  
+  return ord;
+}
+
 CRSSparsity CRSSparsityInternal::pmult(const std::vector<int>& p, bool permute_rows, bool permute_columns, bool invert_permutation) const{
   // Invert p, possibly
   vector<int> p_inv;
@@ -240,14 +240,49 @@ class CRSSparsityInternal : public SharedObjectNode{
     std::vector<int> rowind_;
     
     /// Perform a unidirectional coloring: A greedy distance-2 coloring algorithm (Algorithm 3.1 in A. H. GEBREMEDHIN, F. MANNE, A. POTHEN) 
-    CRSSparsity unidirectionalColoring(const CRSSparsity& AT) const;
+    CRSSparsity unidirectionalColoring(const CRSSparsity& AT, int ordering, int recolor, bool parallel) const;
+
+    /// Greedy distance-2 coloring of the rows in a given order (natural if empty), returns the number of colors
+    int greedyColoring(const CRSSparsity& AT, const std::vector<int>& ord, std::vector<int>& color) const;
+
+#ifdef WITH_OPENMP
+    /// Speculative parallel version of greedyColoring (Gebremedhin and Manne), the result depends on the thread scheduling
+    int greedyColoringParallel(const CRSSparsity& AT, const std::vector<int>& ord, std::vector<int>& color) const;
+#endif // WITH_OPENMP
+    
+    /// Order the vertices by color class, the classes in reverse order or by increasing size (used for recoloring)
+    static void colorClassOrdering(int num_colors, const std::vector<int>& color, std::vector<int>& ord, bool smallest_first);
+
+    /// Perform a bidirectional coloring: dense rows in adjoint mode, the rest in forward mode
+    int bidirectionalColoring(const CRSSparsity& AT, CRSSparsity& D1, CRSSparsity& D2, int adj_penalty, int ordering, int recolor, bool parallel) const;
 
     /// Perform a star coloring of a symmetric matrix: A greedy distance-2 coloring algorithm (Algorithm 4.1 in A. H. GEBREMEDHIN, F. MANNE, A. POTHEN)
-    CRSSparsity starColoring(int ordering) const;
+    CRSSparsity starColoring(int ordering, int recolor) const;
+
+    /// Greedy star coloring of the vertices in a given order (natural if empty), returns the number of colors
+    int starColoringGreedy(const std::vector<int>& ord, std::vector<int>& color) const;
+
+    /// Locate a color in a list stored at colors[offset], ..., colors[offset+n-1], -1 if not found
+    static int findColor(const std::vector<int>& colors, int offset, int n, int c);
+
+    /// Add a color to a list stored at colors[offset], ..., colors[offset+n-1], unless already there
+    static void addColor(std::vector<int>& colors, int offset, int& n, int c);
 
     /// Order the rows by decreasing degree
     std::vector<int> largestFirstOrdering() const;
 
+    /// Smallest last ordering of the adjacency graph (AT null) or of the distance-2 graph of the rows (AT given)
+    std::vector<int> smallestLastOrdering(const CRSSparsity& AT) const;
+
+    /// Incidence degree ordering of the adjacency graph (AT null) or of the distance-2 graph of the rows (AT given)
+    std::vector<int> incidenceDegreeOrdering(const CRSSparsity& AT) const;
+
+    /// Get an ordering for coloring: none (0, returns an empty vector), largest first (1), smallest last (2), incidence degree (3)
+    std::vector<int> coloringOrdering(int ordering, const CRSSparsity& AT) const;
+
+    /// Get the distinct neighbors of a vertex, excluding the vertex itself, in the graph used by smallestLastOrdering
+    void getNeighbors(int i, const CRSSparsity& AT, std::vector<int>& nb, std::vector<int>& mark) const;
+
     /// Permute rows and/or columns
     CRSSparsity pmult(const std::vector<int>& p, bool permute_rows=true, bool permute_columns=true, bool invert_permutation=false) const;
     
@@ -0,0 +1,221 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef DENSE_KERNELS_HPP
+#define DENSE_KERNELS_HPP
+
+#include <algorithm>
+#include <cmath>
+
+namespace CasADi{
+
+  /** \brief Block size of the dense kernels, chosen so that three blocks of doubles fit in a typical L1 cache */
+  const int DENSE_BLOCK = 48;
+  
+  /** \brief Whether the dense kernels are used for a scalar type
+    Only for floating point types, symbolic types keep the order of the operations of the sparse loops. */
+  template<class T> struct DenseKernels{ static const bool enabled = false;};
+  template<> struct DenseKernels<double>{ static const bool enabled = true;};
+
+  /** \brief Dense matrix-matrix product with the second factor transposed, C += A*trans(B)
+    All matrices are stored row by row, A is m-by-k, B is n-by-k and C is m-by-n. Each entry of C is a dot product
+    of two contiguous rows, the loops are blocked so that the rows of B are reused from the cache.
+  */
+  template<class T>
+  void dense_mul_nt(int m, int n, int k, const T* A, const T* B, T* C){
+    for(int i0=0; i0<m; i0+=DENSE_BLOCK){
+      int i1 = std::min(i0+DENSE_BLOCK,m);
+      for(int j0=0; j0<n; j0+=DENSE_BLOCK){
+        int j1 = std::min(j0+DENSE_BLOCK,n);
+        for(int p0=0; p0<k; p0+=DENSE_BLOCK){
+          int p1 = std::min(p0+DENSE_BLOCK,k);
+          for(int i=i0; i<i1; ++i){
+            const T* a = A + i*k;
+            T* c = C + i*n;
+            
+            // Four rows of B at a time, to reuse the entries of A from registers
+            int j=j0;
+            for(; j+4<=j1; j+=4){
+              const T *b0 = B + j*k, *b1 = b0 + k, *b2 = b1 + k, *b3 = b2 + k;
+              T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+              for(int p=p0; p<p1; ++p){
+                T a_ip = a[p];
+                s0 += a_ip*b0[p];
+                s1 += a_ip*b1[p];
+                s2 += a_ip*b2[p];
+                s3 += a_ip*b3[p];
+              }
+              c[j] += s0;
+              c[j+1] += s1;
+              c[j+2] += s2;
+              c[j+3] += s3;
+            }
+            for(; j<j1; ++j){
+              const T* b = B + j*k;
+              T s = 0;
+              for(int p=p0; p<p1; ++p) s += a[p]*b[p];
+              c[j] += s;
+            }
+          }
+        }
+      }
+    }
+  }
+  
+  /** \brief Dense matrix-matrix product, C += A*B
+    All matrices are stored row by row, A is m-by-k, B is k-by-n and C is m-by-n.
+  */
+  template<class T>
+  void dense_mul_nn(int m, int n, int k, const T* A, const T* B, T* C){
+    for(int p0=0; p0<k; p0+=DENSE_BLOCK){
+      int p1 = std::min(p0+DENSE_BLOCK,k);
+      for(int j0=0; j0<n; j0+=DENSE_BLOCK){
+        int j1 = std::min(j0+DENSE_BLOCK,n);
+        for(int i=0; i<m; ++i){
+          const T* a = A + i*k;
+          T* c = C + i*n;
+          for(int p=p0; p<p1; ++p){
+            T a_ip = a[p];
+            const T* b = B + p*n;
+            for(int j=j0; j<j1; ++j) c[j] += a_ip*b[j];
+          }
+        }
+      }
+    }
+  }
+  
+  /** \brief Dense matrix-matrix product with the first factor transposed, C += trans(A)*B
+    All matrices are stored row by row, A is k-by-m, B is k-by-n and C is m-by-n.
+  */
+  template<class T>
+  void dense_mul_tn(int m, int n, int k, const T* A, const T* B, T* C){
+    for(int p0=0; p0<k; p0+=DENSE_BLOCK){
+      int p1 = std::min(p0+DENSE_BLOCK,k);
+      for(int j0=0; j0<n; j0+=DENSE_BLOCK){
+        int j1 = std::min(j0+DENSE_BLOCK,n);
+        for(int i=0; i<m; ++i){
+          T* c = C + i*n;
+          for(int p=p0; p<p1; ++p){
+            T a_pi = A[p*m+i];
+            const T* b = B + p*n;
+            for(int j=j0; j<j1; ++j) c[j] += a_pi*b[j];
+          }
+        }
+      }
+    }
+  }
+  
+  /** \brief LU factorization with partial pivoting of a dense n-by-n matrix stored row by row, in place
+    On return, A contains L (unit diagonal, not stored) and U, and row i of the factorized matrix is row perm[i]
+    of the original matrix. Returns false if the matrix is singular.
+  */
+  template<class T>
+  bool dense_lu(int n, T* A, int* perm){
+    for(int i=0; i<n; ++i) perm[i] = i;
+    for(int k=0; k<n; ++k){
+      // Pivot: largest entry in the column
+      int piv = k;
+      for(int i=k+1; i<n; ++i){
+        if(std::fabs(A[i*n+k])>std::fabs(A[piv*n+k])) piv = i;
+      }
+      if(A[piv*n+k]==0) return false;
+      if(piv!=k){
+        std::swap_ranges(A+k*n,A+(k+1)*n,A+piv*n);
+        std::swap(perm[k],perm[piv]);
+      }
+      
+      // Eliminate below the diagonal
+      T* a_k = A + k*n;
+      for(int i=k+1; i<n; ++i){
+        T* a_i = A + i*n;
+        T l = a_i[k] /= a_k[k];
+        for(int j=k+1; j<n; ++j) a_i[j] -= l*a_k[j];
+      }
+    }
+    return true;
+  }
+  
+  /** \brief Solve A*X = B, or trans(A)*X = B if tr is true, for nrhs right hand sides at once
+    LU and perm are the output of dense_lu, B is n-by-nrhs stored row by row and is overwritten with the solution.
+    Each step of the substitutions updates complete rows of B, so that all right hand sides are processed together.
+    work must have room for n*nrhs elements.
+  */
+  template<class T>
+  void dense_lu_solve(int n, const T* LU, const int* perm, T* B, int nrhs, bool tr, T* work){
+    if(!tr){
+      // Permute the rows
+      for(int i=0; i<n; ++i) std::copy(B+perm[i]*nrhs,B+(perm[i]+1)*nrhs,work+i*nrhs);
+      
+      // Forward substitution with L, then backward substitution with U
+      for(int i=0; i<n; ++i){
+        T* x_i = work + i*nrhs;
+        for(int j=0; j<i; ++j){
+          T l = LU[i*n+j];
+          if(l==0) continue;
+          const T* x_j = work + j*nrhs;
+          for(int c=0; c<nrhs; ++c) x_i[c] -= l*x_j[c];
+        }
+      }
+      for(int i=n-1; i>=0; --i){
+        T* x_i = work + i*nrhs;
+        for(int j=i+1; j<n; ++j){
+          T u = LU[i*n+j];
+          if(u==0) continue;
+          const T* x_j = work + j*nrhs;
+          for(int c=0; c<nrhs; ++c) x_i[c] -= u*x_j[c];
+        }
+        T d = LU[i*n+i];
+        for(int c=0; c<nrhs; ++c) x_i[c] /= d;
+      }
+      std::copy(work,work+n*nrhs,B);
+    } else {
+      // Forward substitution with trans(U), then backward substitution with trans(L)
+      for(int i=0; i<n; ++i){
+        T* x_i = B + i*nrhs;
+        T d = LU[i*n+i];
+        for(int c=0; c<nrhs; ++c) x_i[c] /= d;
+        for(int j=i+1; j<n; ++j){
+          T u = LU[i*n+j];
+          if(u==0) continue;
+          T* x_j = B + j*nrhs;
+          for(int c=0; c<nrhs; ++c) x_j[c] -= u*x_i[c];
+        }
+      }
+      for(int i=n-1; i>=0; --i){
+        const T* x_i = B + i*nrhs;
+        for(int j=0; j<i; ++j){
+          T l = LU[i*n+j];
+          if(l==0) continue;
+          T* x_j = B + j*nrhs;
+          for(int c=0; c<nrhs; ++c) x_j[c] -= l*x_i[c];
+        }
+      }
+      
+      // Undo the permutation
+      for(int i=0; i<n; ++i) std::copy(B+i*nrhs,B+(i+1)*nrhs,work+perm[i]*nrhs);
+      std::copy(work,work+n*nrhs,B);
+    }
+  }
+
+} // namespace CasADi
+
+#endif // DENSE_KERNELS_HPP
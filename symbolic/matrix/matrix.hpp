@@ -31,6 +31,7 @@
 #include "../stl_vector_tools.hpp"
 #include "generic_matrix.hpp"
 #include "generic_expression.hpp"
+#include "mul_plan.hpp"
 
 namespace CasADi{
 
@@ -471,6 +472,15 @@ class Matrix : public GenericExpression<Matrix<T> >, public GenericMatrix<Matrix
     /// Matrix product, no memory allocation: y += mul(trans(x),z)
     static void mul_no_alloc2(const Matrix<T> &x, Matrix<T> &y_trans, const Matrix<T>& z);
     
+#ifndef SWIG
+    //@{
+    /// Matrix products as above, using a plan precomputed for the sparsity patterns of x, y_trans and z
+    static void mul_no_alloc(const Matrix<T> &x, const Matrix<T> &y_trans, Matrix<T>& z, const MulPlan& plan);
+    static void mul_no_alloc1(Matrix<T> &x, const Matrix<T> &y_trans, const Matrix<T>& z, const MulPlan& plan);
+    static void mul_no_alloc2(const Matrix<T> &x, Matrix<T> &y_trans, const Matrix<T>& z, const MulPlan& plan);
+    //@}
+#endif // SWIG
+    
     /// Propagate sparsity using 0-1 logic through a matrix product, no memory allocation: z = mul(x,y)
     static void mul_sparsity(Matrix<T> &x, Matrix<T> &y_trans, Matrix<T>& z, bool fwd);
     
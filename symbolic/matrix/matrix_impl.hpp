@@ -26,9 +26,7 @@
 // The declaration of the class is in a separate file
 #include "matrix.hpp"
 
-#ifdef WITH_EIGEN3
-#include <Eigen/Dense>
-#endif
+#include "dense_kernels.hpp"
 
 namespace CasADi{
 // Implementations
@@ -1204,6 +1202,14 @@ void Matrix<T>::mul_no_alloc1(Matrix<T> &x, const Matrix<T> &y_trans, const Matr
   const std::vector<int> &x_rowind = x.rowind();
   const std::vector<int> &y_colind = y_trans.rowind();
 
+  // Blocked kernel if all matrices are dense
+  if(DenseKernels<T>::enabled && x.dense() && y_trans.dense() && z.dense()){
+    if(x.size()>0 && z.size()>0){
+      dense_mul_nn(x.size1(),x.size2(),y_trans.size1(),&z_data.front(),&y_trans_data.front(),&x_data.front());
+    }
+    return;
+  }
+
   // loop over the row of the resulting matrix)
   for(int i=0; i<z.size1(); ++i){
     for(int el=z_rowind[i]; el<z_rowind[i+1]; ++el){ // loop over the non-zeros of the resulting matrix
@@ -1240,6 +1246,14 @@ void Matrix<T>::mul_no_alloc2(const Matrix<T> &x, Matrix<T> &y_trans, const Matr
   const std::vector<int> &x_rowind = x.rowind();
   const std::vector<int> &y_colind = y_trans.rowind();
 
+  // Blocked kernel if all matrices are dense
+  if(DenseKernels<T>::enabled && x.dense() && y_trans.dense() && z.dense()){
+    if(y_trans.size()>0 && z.size()>0){
+      dense_mul_tn(y_trans.size1(),y_trans.size2(),x.size1(),&z_data.front(),&x_data.front(),&y_trans_data.front());
+    }
+    return;
+  }
+
   // loop over the row of the resulting matrix)
   for(int i=0; i<z.size1(); ++i){
     for(int el=z_rowind[i]; el<z_rowind[i+1]; ++el){ // loop over the non-zeros of the resulting matrix
@@ -1275,15 +1289,13 @@ void Matrix<T>::mul_no_alloc(const Matrix<T> &x, const Matrix<T> &y_trans, Matri
   const std::vector<T> &y_trans_data = y_trans.data();
   std::vector<T> &z_data = z.data();
   
-  #ifdef WITH_EIGEN3
-  if (x.dense() && y_trans.dense() && z.dense()) {
-    Eigen::Map< const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic , Eigen::RowMajor > > X(&x_data[0],x.size1(),x.size2());
-    Eigen::Map< const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic > > Y(&y_trans_data[0],y_trans.size2(),y_trans.size1());
-    Eigen::Map< Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic , Eigen::RowMajor> > Z(&z.data()[0],z.size1(),z.size2());
-    Z = X*Y;
+  // Blocked kernel if all matrices are dense
+  if(DenseKernels<T>::enabled && x.dense() && y_trans.dense() && z.dense()){
+    if(x.size()>0 && y_trans.size()>0){
+      dense_mul_nt(x.size1(),y_trans.size1(),x.size2(),&x_data.front(),&y_trans_data.front(),&z_data.front());
+    }
     return;
   }
-  #endif
   
   // loop over the rows of the resulting matrix)
   for(int i=0; i<z_rowind.size()-1; ++i){
@@ -1306,6 +1318,68 @@ void Matrix<T>::mul_no_alloc(const Matrix<T> &x, const Matrix<T> &y_trans, Matri
   }
 }
 
+template<class T>
+void Matrix<T>::mul_no_alloc(const Matrix<T> &x, const Matrix<T> &y_trans, Matrix<T>& z, const MulPlan& plan){
+  const std::vector<T> &x_data = x.data();
+  const std::vector<T> &y_trans_data = y_trans.data();
+  std::vector<T> &z_data = z.data();
+  if(plan.dense){
+    if(DenseKernels<T>::enabled){
+      if(plan.m*plan.n*plan.k>0) dense_mul_nt(plan.m,plan.n,plan.k,&x_data.front(),&y_trans_data.front(),&z_data.front());
+    } else {
+      mul_no_alloc(x,y_trans,z);
+    }
+    return;
+  }
+  
+  // Loop over the nonzeros of the result and the pairs contributing to each
+  for(int el=0; el<z_data.size(); ++el){
+    for(int k=plan.pair_begin[el]; k<plan.pair_begin[el+1]; ++k){
+      z_data[el] += x_data[plan.x_el[k]] * y_trans_data[plan.y_el[k]];
+    }
+  }
+}
+
+template<class T>
+void Matrix<T>::mul_no_alloc1(Matrix<T> &x, const Matrix<T> &y_trans, const Matrix<T>& z, const MulPlan& plan){
+  std::vector<T> &x_data = x.data();
+  const std::vector<T> &y_trans_data = y_trans.data();
+  const std::vector<T> &z_data = z.data();
+  if(plan.dense){
+    if(DenseKernels<T>::enabled){
+      if(plan.m*plan.n*plan.k>0) dense_mul_nn(plan.m,plan.k,plan.n,&z_data.front(),&y_trans_data.front(),&x_data.front());
+    } else {
+      mul_no_alloc1(x,y_trans,z);
+    }
+    return;
+  }
+  for(int el=0; el<z_data.size(); ++el){
+    for(int k=plan.pair_begin[el]; k<plan.pair_begin[el+1]; ++k){
+      x_data[plan.x_el[k]] += z_data[el]*y_trans_data[plan.y_el[k]];
+    }
+  }
+}
+
+template<class T>
+void Matrix<T>::mul_no_alloc2(const Matrix<T> &x, Matrix<T> &y_trans, const Matrix<T>& z, const MulPlan& plan){
+  const std::vector<T> &x_data = x.data();
+  std::vector<T> &y_trans_data = y_trans.data();
+  const std::vector<T> &z_data = z.data();
+  if(plan.dense){
+    if(DenseKernels<T>::enabled){
+      if(plan.m*plan.n*plan.k>0) dense_mul_tn(plan.n,plan.k,plan.m,&z_data.front(),&x_data.front(),&y_trans_data.front());
+    } else {
+      mul_no_alloc2(x,y_trans,z);
+    }
+    return;
+  }
+  for(int el=0; el<z_data.size(); ++el){
+    for(int k=plan.pair_begin[el]; k<plan.pair_begin[el+1]; ++k){
+      y_trans_data[plan.y_el[k]] += z_data[el] * x_data[plan.x_el[k]];
+    }
+  }
+}
+
 template<class T>
 void Matrix<T>::mul_sparsity(Matrix<T> &x, Matrix<T> &y_trans, Matrix<T>& z, bool fwd){
   // Direct access to the arrays
@@ -0,0 +1,95 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "mul_plan.hpp"
+
+using namespace std;
+
+namespace CasADi{
+
+MulPlan::MulPlan() : dense(false), m(0), n(0), k(0){
+}
+
+MulPlan::MulPlan(const CRSSparsity& x, const CRSSparsity& y_trans, const CRSSparsity& z) : dense(false), m(0), n(0), k(0){
+  // Dense blocks that line up: the columns of x and y_trans coincide, z is the block of the rows of x and y_trans
+  int x_row0, x_row1, x_col0, x_col1, y_row0, y_row1, y_col0, y_col1, z_row0, z_row1, z_col0, z_col1;
+  if(denseBlock(x,x_row0,x_row1,x_col0,x_col1) && denseBlock(y_trans,y_row0,y_row1,y_col0,y_col1) && denseBlock(z,z_row0,z_row1,z_col0,z_col1)){
+    if(x_col0==y_col0 && x_col1==y_col1 && z_row0==x_row0 && z_row1==x_row1 && z_col0==y_row0 && z_col1==y_row1){
+      dense = true;
+      m = x_row1-x_row0;
+      n = y_row1-y_row0;
+      k = x_col1-x_col0;
+      return;
+    }
+  }
+  
+  // Merge the rows of x and y_trans once for each nonzero of z
+  const vector<int> &z_col = z.col();
+  const vector<int> &z_rowind = z.rowind();
+  const vector<int> &x_col = x.col();
+  const vector<int> &x_rowind = x.rowind();
+  const vector<int> &y_row = y_trans.col();
+  const vector<int> &y_colind = y_trans.rowind();
+  pair_begin.resize(z.size()+1);
+  pair_begin[0] = 0;
+  for(int i=0; i<z.size1(); ++i){
+    for(int el=z_rowind[i]; el<z_rowind[i+1]; ++el){
+      int j = z_col[el];
+      int el1 = x_rowind[i];
+      int el2 = y_colind[j];
+      while(el1 < x_rowind[i+1] && el2 < y_colind[j+1]){
+        int j1 = x_col[el1];
+        int i2 = y_row[el2];
+        if(j1==i2){
+          x_el.push_back(el1++);
+          y_el.push_back(el2++);
+        } else if(j1<i2) {
+          el1++;
+        } else {
+          el2++;
+        }
+      }
+      pair_begin[el+1] = x_el.size();
+    }
+  }
+}
+
+bool MulPlan::denseBlock(const CRSSparsity& sp, int& row0, int& row1, int& col0, int& col1){
+  if(sp.size()==0) return false;
+  const vector<int> &col = sp.col();
+  const vector<int> &rowind = sp.rowind();
+  
+  // First and last nonempty row
+  for(row0=0; rowind[row0+1]==rowind[row0]; ++row0);
+  for(row1=sp.size1(); rowind[row1-1]==rowind[row1]; --row1);
+  
+  // All rows in between must contain the same contiguous range of columns
+  col0 = col[rowind[row0]];
+  col1 = col[rowind[row0+1]-1]+1;
+  int ncol = col1-col0;
+  for(int i=row0; i<row1; ++i){
+    if(rowind[i+1]-rowind[i]!=ncol || col[rowind[i]]!=col0 || col[rowind[i+1]-1]!=col1-1) return false;
+  }
+  return true;
+}
+
+} // namespace CasADi
@@ -0,0 +1,60 @@
+/*
+ *    This file is part of CasADi.
+ *
+ *    CasADi -- A symbolic framework for dynamic optimization.
+ *    Copyright (C) 2010 by Joel Andersson, Moritz Diehl, K.U.Leuven. All rights reserved.
+ *
+ *    CasADi is free software; you can redistribute it and/or
+ *    modify it under the terms of the GNU Lesser General Public
+ *    License as published by the Free Software Foundation; either
+ *    version 3 of the License, or (at your option) any later version.
+ *
+ *    CasADi is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    Lesser General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Lesser General Public
+ *    License along with CasADi; if not, write to the Free Software
+ *    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef MUL_PLAN_HPP
+#define MUL_PLAN_HPP
+
+#include "crs_sparsity.hpp"
+#include <vector>
+
+namespace CasADi{
+
+/** \brief Precomputed structure of the matrix product z += mul(x,trans(y_trans)) for fixed sparsity patterns
+  For each nonzero of z, the plan stores the pairs of nonzeros of x and y_trans that contribute to it, so that the
+  sparsity patterns need not be merged every time the product is evaluated (see Matrix<T>::mul_no_alloc). If the
+  nonzeros of x, y_trans and z each form a single rectangular block and the blocks line up, the nonzeros are dense
+  matrices stored row by row and the product is instead evaluated with the blocked dense kernels.
+*/
+struct MulPlan{
+  /// Default constructor, a null plan
+  MulPlan();
+  
+  /// Construct the plan for given sparsity patterns
+  MulPlan(const CRSSparsity& x, const CRSSparsity& y_trans, const CRSSparsity& z);
+  
+  /// Is the plan null
+  bool isNull() const{ return !dense && pair_begin.empty();}
+  
+  /// Dense product of an m-by-k block and the transpose of an n-by-k block
+  bool dense;
+  int m, n, k;
+  
+  /// The pairs contributing to nonzero el of z are pair_begin[el] to pair_begin[el+1]
+  std::vector<int> pair_begin, x_el, y_el;
+  
+  /// If the nonzeros form a single dense block, get its rows [row0,row1) and columns [col0,col1)
+  static bool denseBlock(const CRSSparsity& sp, int& row0, int& row1, int& col0, int& col1);
+};
+
+} // namespace CasADi
+
+#endif // MUL_PLAN_HPP
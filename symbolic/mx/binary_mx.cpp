@@ -29,6 +29,7 @@
 #include "../matrix/matrix_tools.hpp"
 #include "../sx/sx_tools.hpp"
 #include "../stl_vector_tools.hpp"
+#include "../fx/code_generator.hpp"
 
 using namespace std;
 
@@ -48,6 +49,9 @@ SparseSparseOp::SparseSparseOp(Operation op, const MX& x, const MX& y) : BinaryM
   bool fx0_is_zero = operation_checker<FX0Checker>(op_);
   CRSSparsity sp = x->sparsity().patternUnion(y->sparsity(),mapping_,f00_is_zero,f0x_is_zero,fx0_is_zero);
   setSparsity(sp);
+  
+  // Precompute the gather lists, so that numerical evaluation does not need to walk the mapping
+  plan_ = BinaryPlan(mapping_);
 }
 
 void BinaryMX::printPart(std::ostream &stream, int part) const{
@@ -60,66 +64,60 @@ void BinaryMX::printPart(std::ostream &stream, int part) const{
   }
 }
 
-void SparseSparseOp::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens){
+void SparseSparseOp::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens, std::vector<int>& itmp, std::vector<double>& rtmp){
   int nfwd = fwdSens.size();
   int nadj = adjSeed.size();
-  if(nfwd==0 && nadj==0){
-    DMatrix::binary_no_alloc(casadi_math<double>::fun,op_,*input[0],*input[1],*output[0],mapping_);
-  } else {
-    vector<double>& output0 = output[0]->data();
-    const vector<double> &input0 = input[0]->data();
-    const vector<double> &input1 = input[1]->data();
-
-    // Argument values
-    double a[2][2] = {{0,0},{0,0}};
-
-    // Nonzero counters
-    int el0=0, el1=0, el=0;
-
-    // Partial derivatives
-    double pd[2][2] = {{0,0},{0,0}};
-    
-    // With sensitivities
-    for(int i=0; i<mapping_.size(); ++i){
-      // Check which elements are nonzero
-      unsigned char m = mapping_[i];
-      bool nz0 = m & 1;
-      bool nz1 = m & 2;
-      bool skip_nz = m & 4;
-      
-      if(!skip_nz){
-      
-        // Read the next nonzero 
-        if(nz0) a[0][1] = input0[el0];
-        if(nz1) a[1][1] = input1[el1];
-        
-        // Evaluate and get partial derivatives
-        casadi_math<double>::fun(op_,a[0][nz0], a[1][nz1],output0[el]);
-        casadi_math<double>::der(op_,a[0][nz0], a[1][nz1],output0[el],pd[1]);
-        
-        // Propagate forward seeds
-        for(int d=0; d<nfwd; ++d){
-          double s = 0;
-          if(nz0) s += pd[nz0][0]*fwdSeed[d][0]->data()[el0];
-          if(nz1) s += pd[nz1][1]*fwdSeed[d][1]->data()[el1];
-          fwdSens[d][0]->data()[el] = s;
-        }
-        
-        // Propagate adjoint seeds
-        for(int d=0; d<nadj; ++d){
-          double s = adjSeed[d][0]->data()[el];
-          if(nz0) adjSens[d][0]->data()[el0] += s*pd[nz0][0];
-          if(nz1) adjSens[d][1]->data()[el1] += s*pd[nz1][1];
-        }
-        
-        // Next nonzero for the output
-        el++;
-      }
-      
-      // Go to next nonzero for the arguments
-      el0 += nz0;
-      el1 += nz1;
-    }
+  int n = plan_.nnz;
+  const vector<int> &x_src = plan_.x_src, &x_dst = plan_.x_dst, &y_src = plan_.y_src, &y_dst = plan_.y_dst;
+  
+  // Work vector: the gathered arguments and the partial derivatives with respect to each of them
+  if(rtmp.size()<4*n) rtmp.resize(4*n);
+  double *x_gather = getPtr(rtmp), *y_gather = x_gather + n, *d0 = y_gather + n, *d1 = d0 + n;
+
+  // Gather the arguments to the sparsity pattern of the result, structurally zero entries are zero
+  const double* x = getPtr(input[0]->data());
+  const double* y = getPtr(input[1]->data());
+  if(!plan_.x_direct){
+    std::fill(x_gather,x_gather+n,0);
+    for(int k=0; k<x_src.size(); ++k) x_gather[x_dst[k]] = x[x_src[k]];
+    x = x_gather;
+  }
+  if(!plan_.y_direct){
+    std::fill(y_gather,y_gather+n,0);
+    for(int k=0; k<y_src.size(); ++k) y_gather[y_dst[k]] = y[y_src[k]];
+    y = y_gather;
+  }
+  
+  // Evaluate
+  double* z = getPtr(output[0]->data());
+  casadi_math<double>::fun(op_,x,y,z,n);
+  if(nfwd==0 && nadj==0) return;
+  
+  // Partial derivatives
+  double pd[2];
+  for(int el=0; el<n; ++el){
+    casadi_math<double>::der(op_,x[el],y[el],z[el],pd);
+    d0[el] = pd[0];
+    d1[el] = pd[1];
+  }
+  
+  // Propagate forward seeds, only the structurally nonzero arguments contribute
+  for(int d=0; d<nfwd; ++d){
+    const double* x_seed = getPtr(fwdSeed[d][0]->data());
+    const double* y_seed = getPtr(fwdSeed[d][1]->data());
+    double* z_sens = getPtr(fwdSens[d][0]->data());
+    for(int el=0; el<n; ++el) z_sens[el] = 0;
+    for(int k=0; k<x_src.size(); ++k) z_sens[x_dst[k]] += d0[x_dst[k]]*x_seed[x_src[k]];
+    for(int k=0; k<y_src.size(); ++k) z_sens[y_dst[k]] += d1[y_dst[k]]*y_seed[y_src[k]];
+  }
+  
+  // Propagate adjoint seeds
+  for(int d=0; d<nadj; ++d){
+    const double* z_seed = getPtr(adjSeed[d][0]->data());
+    double* x_sens = getPtr(adjSens[d][0]->data());
+    double* y_sens = getPtr(adjSens[d][1]->data());
+    for(int k=0; k<x_src.size(); ++k) x_sens[x_src[k]] += z_seed[x_dst[k]]*d0[x_dst[k]];
+    for(int k=0; k<y_src.size(); ++k) y_sens[y_src[k]] += z_seed[y_dst[k]]*d1[y_dst[k]];
   }
 }
 
@@ -217,7 +215,7 @@ void NonzerosScalarOp::evaluateGen(const MatV& input, MatV& output, const MatVV&
   }
 }
 
-void NonzerosScalarOp::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens){
+void NonzerosScalarOp::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens, std::vector<int>& itmp, std::vector<double>& rtmp){
   evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
 }
 
@@ -266,7 +264,7 @@ void ScalarNonzerosOp::evaluateGen(const MatV& input, MatV& output, const MatVV&
   }
 }
 
-void ScalarNonzerosOp::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens){
+void ScalarNonzerosOp::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens, std::vector<int>& itmp, std::vector<double>& rtmp){
   evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
 }
 
@@ -317,7 +315,7 @@ void NonzerosNonzerosOp::evaluateGen(const MatV& input, MatV& output, const MatV
   }
 }
 
-void NonzerosNonzerosOp::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens){
+void NonzerosNonzerosOp::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens, std::vector<int>& itmp, std::vector<double>& rtmp){
   evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
 }
 
@@ -339,6 +337,19 @@ void NonzerosNonzerosOp::propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& outp
   }
 }
 
+void NonzerosNonzerosOp::propagateSparsityBlock(const std::vector<bvec_t*>& arg, const std::vector<bvec_t*>& res, int nw, bool fwd){
+  bvec_t *input0 = arg[0], *input1 = arg[1], *outputd = res[0];
+  int n = size()*nw;
+  if(fwd){
+    for(int k=0; k<n; ++k) outputd[k] = input0[k] | input1[k];
+  } else {
+    for(int k=0; k<n; ++k){
+      input0[k] |= outputd[k];
+      input1[k] |= outputd[k];
+    }
+  }
+}
+
 void NonzerosScalarOp::propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output, bool fwd){
   bvec_t *input0 = get_bvec_t(input[0]->data());
   bvec_t *input1 = get_bvec_t(input[1]->data());
@@ -353,6 +364,21 @@ void NonzerosScalarOp::propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output
   }
 }
 
+void NonzerosScalarOp::propagateSparsityBlock(const std::vector<bvec_t*>& arg, const std::vector<bvec_t*>& res, int nw, bool fwd){
+  bvec_t *input0 = arg[0], *input1 = arg[1], *outputd = res[0];
+  for(int el=0; el<size(); ++el){
+    bvec_t *r = outputd + el*nw, *a0 = input0 + el*nw;
+    if(fwd){
+      for(int w=0; w<nw; ++w) r[w] = a0[w] | input1[w];
+    } else {
+      for(int w=0; w<nw; ++w){
+        a0[w] |= r[w];
+        input1[w] |= r[w];
+      }
+    }
+  }
+}
+
 void ScalarNonzerosOp::propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output, bool fwd){
   bvec_t *input0 = get_bvec_t(input[0]->data());
   bvec_t *input1 = get_bvec_t(input[1]->data());
@@ -367,42 +393,95 @@ void ScalarNonzerosOp::propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output
   }
 }
 
+void ScalarNonzerosOp::propagateSparsityBlock(const std::vector<bvec_t*>& arg, const std::vector<bvec_t*>& res, int nw, bool fwd){
+  bvec_t *input0 = arg[0], *input1 = arg[1], *outputd = res[0];
+  for(int el=0; el<size(); ++el){
+    bvec_t *r = outputd + el*nw, *a1 = input1 + el*nw;
+    if(fwd){
+      for(int w=0; w<nw; ++w) r[w] = input0[w] | a1[w];
+    } else {
+      for(int w=0; w<nw; ++w){
+        input0[w] |= r[w];
+        a1[w] |= r[w];
+      }
+    }
+  }
+}
+
 void SparseSparseOp::propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output, bool fwd){
   bvec_t *input0 = get_bvec_t(input[0]->data());
   bvec_t *input1 = get_bvec_t(input[1]->data());
   bvec_t *outputd = get_bvec_t(output[0]->data());
+  const vector<int> &x_src = plan_.x_src, &x_dst = plan_.x_dst, &y_src = plan_.y_src, &y_dst = plan_.y_dst;
 
-  // Argument values
-  bvec_t zero = 0;
+  if(fwd){
+    for(int el=0; el<plan_.nnz; ++el) outputd[el] = 0;
+    for(int k=0; k<x_src.size(); ++k) outputd[x_dst[k]] |= input0[x_src[k]];
+    for(int k=0; k<y_src.size(); ++k) outputd[y_dst[k]] |= input1[y_src[k]];
+  } else {
+    for(int k=0; k<x_src.size(); ++k) input0[x_src[k]] |= outputd[x_dst[k]];
+    for(int k=0; k<y_src.size(); ++k) input1[y_src[k]] |= outputd[y_dst[k]];
+  }
+}
 
-  // Nonzero counters
-  int el0=0, el1=0, el=0;
-  
-  // Loop over nonzero elements
-  for(int i=0; i<mapping_.size(); ++i){
-    // Check which elements are nonzero
-    unsigned char m = mapping_[i];
-    bool nz0(m & 1);
-    bool nz1(m & 2);
-    bool skip_nz(m & 4);
-    
-    // Evaluate
-    if(!skip_nz){
-      if(fwd){
-        outputd[el++] = (nz0 ? input0[el0] : zero) | (nz1 ? input1[el1] : zero);
-      } else {
-        if(nz0) input0[el0] |= outputd[el];
-        if(nz1) input1[el1] |= outputd[el];
-        el++;
-      }
+void SparseSparseOp::propagateSparsityBlock(const std::vector<bvec_t*>& arg, const std::vector<bvec_t*>& res, int nw, bool fwd){
+  bvec_t *input0 = arg[0], *input1 = arg[1], *outputd = res[0];
+  const vector<int> &x_src = plan_.x_src, &x_dst = plan_.x_dst, &y_src = plan_.y_src, &y_dst = plan_.y_dst;
+
+  if(fwd){
+    std::fill(outputd,outputd+plan_.nnz*nw,bvec_t(0));
+    for(int k=0; k<x_src.size(); ++k){
+      bvec_t *r = outputd + x_dst[k]*nw, *a = input0 + x_src[k]*nw;
+      for(int w=0; w<nw; ++w) r[w] |= a[w];
+    }
+    for(int k=0; k<y_src.size(); ++k){
+      bvec_t *r = outputd + y_dst[k]*nw, *a = input1 + y_src[k]*nw;
+      for(int w=0; w<nw; ++w) r[w] |= a[w];
+    }
+  } else {
+    for(int k=0; k<x_src.size(); ++k){
+      bvec_t *r = outputd + x_dst[k]*nw, *a = input0 + x_src[k]*nw;
+      for(int w=0; w<nw; ++w) a[w] |= r[w];
+    }
+    for(int k=0; k<y_src.size(); ++k){
+      bvec_t *r = outputd + y_dst[k]*nw, *a = input1 + y_src[k]*nw;
+      for(int w=0; w<nw; ++w) a[w] |= r[w];
     }
-    
-    // Go to next nonzero
-    el0 += nz0;
-    el1 += nz1;
   }
 }
 
+void SparseSparseOp::generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const{
+  // Nonzero of each argument corresponding to each nonzero of the result, -1 if structurally zero
+  vector<int> nz0(size(),-1), nz1(size(),-1);
+  for(int k=0; k<plan_.x_src.size(); ++k) nz0[plan_.x_dst[k]] = plan_.x_src[k];
+  for(int k=0; k<plan_.y_src.size(); ++k) nz1[plan_.y_dst[k]] = plan_.y_src[k];
+  string s0 = gen.getConstant(nz0);
+  string s1 = gen.getConstant(nz1);
+
+  stream << "  for(i=0; i<" << size() << "; ++i) " << res.front() << "[i]=";
+  casadi_math<double>::print(op_,stream,
+                             "(" + s0 + "[i]>=0 ? " + arg.at(0) + "[" + s0 + "[i]] : 0)",
+                             "(" + s1 + "[i]>=0 ? " + arg.at(1) + "[" + s1 + "[i]] : 0)");
+  stream << ";" << endl;
+}
+
+void NonzerosScalarOp::generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const{
+  stream << "  for(i=0; i<" << size() << "; ++i) " << res.front() << "[i]=";
+  casadi_math<double>::print(op_,stream,arg.at(0)+"[i]",arg.at(1)+"[0]");
+  stream << ";" << endl;
+}
+
+void ScalarNonzerosOp::generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const{
+  stream << "  for(i=0; i<" << size() << "; ++i) " << res.front() << "[i]=";
+  casadi_math<double>::print(op_,stream,arg.at(0)+"[0]",arg.at(1)+"[i]");
+  stream << ";" << endl;
+}
+
+void NonzerosNonzerosOp::generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const{
+  stream << "  for(i=0; i<" << size() << "; ++i) " << res.front() << "[i]=";
+  casadi_math<double>::print(op_,stream,arg.at(0)+"[i]",arg.at(1)+"[i]");
+  stream << ";" << endl;
+}
 
 } // namespace CasADi
 
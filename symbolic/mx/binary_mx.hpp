@@ -24,6 +24,7 @@
 #define BINARY_MX_HPP
 
 #include "mx_node.hpp"
+#include "../matrix/binary_plan.hpp"
 
 namespace CasADi{
 /** \brief Represents any binary operation that involves two matrices 
@@ -44,6 +45,9 @@ class BinaryMX : public MXNode{
     /** \brief Get the operation */
     virtual int getOp() const{ return op_;}
     
+    /** \brief  Add to a hash */
+    virtual bool hashStructure(StructureHash& h){ return true;}
+    
     /** \brief  Evaluate the function symbolically (MX) */
     virtual void evaluateMX(const MXPtrV& input, MXPtrV& output, const MXPtrVV& fwdSeed, MXPtrVV& fwdSens, const MXPtrVV& adjSeed, MXPtrVV& adjSens, bool output_given);
 
@@ -69,7 +73,7 @@ class SparseSparseOp : public BinaryMX{
     virtual SparseSparseOp * clone() const{ return new SparseSparseOp(*this);}
 
     /** \brief  Evaluate the function numerically */
-    virtual void evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens);
+    virtual void evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens, std::vector<int>& itmp, std::vector<double>& rtmp);
 
     /** \brief  Evaluate the function symbolically (SX) */
     virtual void evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens);
@@ -77,8 +81,17 @@ class SparseSparseOp : public BinaryMX{
     /** \brief  Propagate sparsity */
     virtual void propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output, bool fwd);
 
+    /** \brief  Propagate sparsity, several words per nonzero */
+    virtual void propagateSparsityBlock(const std::vector<bvec_t*>& arg, const std::vector<bvec_t*>& res, int nw, bool fwd);
+
+    /** \brief  Generate code for the operation */
+    virtual void generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const;
+
     //! \brief Which argument for each nonzero
     std::vector<unsigned char> mapping_;
+    
+    //! \brief Gather lists of the arguments, built together with the sparsity pattern
+    BinaryPlan plan_;
 };
 
 /// A matrix-scalar binary operation where one loops only over nonzeros of the matrix
@@ -95,7 +108,7 @@ class NonzerosScalarOp : public BinaryMX{
     virtual NonzerosScalarOp * clone() const{ return new NonzerosScalarOp(*this);}
 
     /** \brief  Evaluate the function numerically */
-    virtual void evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens);
+    virtual void evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens, std::vector<int>& itmp, std::vector<double>& rtmp);
 
     /** \brief  Evaluate the function symbolically (SX) */
     virtual void evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens);
@@ -103,6 +116,12 @@ class NonzerosScalarOp : public BinaryMX{
     /** \brief  Propagate sparsity */
     virtual void propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output, bool fwd);
 
+    /** \brief  Propagate sparsity, several words per nonzero */
+    virtual void propagateSparsityBlock(const std::vector<bvec_t*>& arg, const std::vector<bvec_t*>& res, int nw, bool fwd);
+
+    /** \brief  Generate code for the operation */
+    virtual void generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const;
+
     /** \brief  Evaluate the function (template) */
     template<typename T, typename MatV, typename MatVV> 
     void evaluateGen(const MatV& input, MatV& output, const MatVV& fwdSeed, MatVV& fwdSens, const MatVV& adjSeed, MatVV& adjSens);
@@ -122,7 +141,7 @@ class ScalarNonzerosOp : public BinaryMX{
     virtual ScalarNonzerosOp * clone() const{ return new ScalarNonzerosOp(*this);}
 
     /** \brief  Evaluate the function numerically */
-    virtual void evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens);
+    virtual void evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens, std::vector<int>& itmp, std::vector<double>& rtmp);
 
     /** \brief  Evaluate the function symbolically (SX) */
     virtual void evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens);
@@ -130,6 +149,12 @@ class ScalarNonzerosOp : public BinaryMX{
     /** \brief  Propagate sparsity */
     virtual void propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output, bool fwd);
 
+    /** \brief  Propagate sparsity, several words per nonzero */
+    virtual void propagateSparsityBlock(const std::vector<bvec_t*>& arg, const std::vector<bvec_t*>& res, int nw, bool fwd);
+
+    /** \brief  Generate code for the operation */
+    virtual void generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const;
+
     /** \brief  Evaluate the function (template) */
     template<typename T, typename MatV, typename MatVV> 
     void evaluateGen(const MatV& input, MatV& output, const MatVV& fwdSeed, MatVV& fwdSens, const MatVV& adjSeed, MatVV& adjSens);
@@ -149,7 +174,7 @@ class NonzerosNonzerosOp : public BinaryMX{
     virtual NonzerosNonzerosOp * clone() const{ return new NonzerosNonzerosOp(*this);}
 
     /** \brief  Evaluate the function numerically */
-    virtual void evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens);
+    virtual void evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens, std::vector<int>& itmp, std::vector<double>& rtmp);
 
     /** \brief  Evaluate the function symbolically (SX) */
     virtual void evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens);
@@ -157,6 +182,12 @@ class NonzerosNonzerosOp : public BinaryMX{
     /** \brief  Propagate sparsity */
     virtual void propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output, bool fwd);
 
+    /** \brief  Propagate sparsity, several words per nonzero */
+    virtual void propagateSparsityBlock(const std::vector<bvec_t*>& arg, const std::vector<bvec_t*>& res, int nw, bool fwd);
+
+    /** \brief  Generate code for the operation */
+    virtual void generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const;
+
     /** \brief  Evaluate the function (template) */
     template<typename T, typename MatV, typename MatVV> 
     void evaluateGen(const MatV& input, MatV& output, const MatVV& fwdSeed, MatVV& fwdSens, const MatVV& adjSeed, MatVV& adjSens);
@@ -25,6 +25,7 @@
 #include <vector>
 #include <algorithm>
 #include "../stl_vector_tools.hpp"
+#include "../fx/code_generator.hpp"
 
 using namespace std;
 
@@ -42,7 +43,7 @@ void ConstantMX::printPart(std::ostream &stream, int part) const{
   x_.print(stream);
 }
 
-void ConstantMX::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens){
+void ConstantMX::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens, std::vector<int>& itmp, std::vector<double>& rtmp){
   int nfwd = fwdSens.size();
   output[0]->set(x_);
   for(int d=0; d<nfwd; ++d){
@@ -91,5 +92,15 @@ void ConstantMX::propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output, bool
   }
 }
 
+void ConstantMX::propagateSparsityBlock(const std::vector<bvec_t*>& arg, const std::vector<bvec_t*>& res, int nw, bool fwd){
+  if(fwd){
+    fill_n(res[0],size()*nw,bvec_t(0));
+  }
+}
+
+void ConstantMX::generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const{
+  stream << "  for(i=0; i<" << size() << "; ++i) " << res.front() << "[i]=" << gen.getConstant(x_.data()) << "[i];" << endl;
+}
+
 } // namespace CasADi
 
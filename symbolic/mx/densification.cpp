@@ -25,6 +25,7 @@
 #include <vector>
 #include <sstream>
 #include "../stl_vector_tools.hpp"
+#include "../fx/code_generator.hpp"
 
 using namespace std;
 
@@ -47,7 +48,7 @@ void Densification::printPart(std::ostream &stream, int part) const{
   }
 }
 
-void Densification::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens){
+void Densification::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens, std::vector<int>& itmp, std::vector<double>& rtmp){
   int nfwd = fwdSens.size();
   int nadj = adjSeed.size();
 
@@ -121,6 +122,10 @@ void Densification::propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output, b
     if(fwd) outputd[k] = 0;
 }
 
+void Densification::generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const{
+  gen.addAuxiliary(CodeGenerator::AUX_DENSIFY);
+  stream << "  casadi_densify(" << arg.front() << "," << gen.getSparsity(dep(0).sparsity()) << "," << res.front() << ");" << endl;
+}
 
 } // namespace CasADi
 
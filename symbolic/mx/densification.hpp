@@ -46,7 +46,7 @@ public:
   virtual void printPart(std::ostream &stream, int part) const;
 
   /** \brief  Evaluate the function numerically */
-  virtual void evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens);
+  virtual void evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens, std::vector<int>& itmp, std::vector<double>& rtmp);
 
   /** \brief  Evaluate the function symbolically (SX) */
   virtual void evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens);
@@ -57,6 +57,12 @@ public:
   /** \brief  Propagate sparsity */
   virtual void propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output, bool fwd);
 
+  /** \brief  Add to a hash */
+  virtual bool hashStructure(StructureHash& h){ return true;}
+
+  /** \brief  Generate code for the operation */
+  virtual void generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const;
+
   /** \brief Get the operation */
   virtual int getOp() const{ return OP_DENSIFY;}
 };
@@ -26,6 +26,7 @@
 #include "../mx/mx_tools.hpp"
 #include "../matrix/matrix_tools.hpp"
 #include "../fx/derivative.hpp"
+#include "../fx/code_generator.hpp"
 
 using namespace std;
 
@@ -61,7 +62,7 @@ void EvaluationMX::printPart(std::ostream &stream, int part) const {
 
 void EvaluationMX::evaluateD(const DMatrixPtrV& arg, DMatrixPtrV& res,
     const DMatrixPtrVV& fseed, DMatrixPtrVV& fsens,
-    const DMatrixPtrVV& aseed, DMatrixPtrVV& asens) {
+    const DMatrixPtrVV& aseed, DMatrixPtrVV& asens, std::vector<int>& itmp, std::vector<double>& rtmp) {
   
   // Number of inputs and outputs
   int num_in = fcn_.getNumInputs();
@@ -258,6 +259,10 @@ void EvaluationMX::deepCopyMembers(
   fcn_ = deepcopy(fcn_, already_copied);
 }
 
+bool EvaluationMX::hashStructure(StructureHash& h){
+  return fcn_->hashStructure(h);
+}
+
 void EvaluationMX::propagateSparsity(DMatrixPtrV& arg, DMatrixPtrV& res,bool use_fwd) {
   if (fcn_.spCanEvaluate(use_fwd)) {
     // Propagating sparsity pattern supported
@@ -490,4 +495,48 @@ void EvaluationMX::create(const FX& fcn, const std::vector<MX> &arg,
   }
 }
 
+void EvaluationMX::generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const{
+  // Get the name of the generated function
+  string f = gen.getDependency(fcn_);
+  
+  // Number of inputs and outputs
+  int num_in = fcn_.getNumInputs();
+  int num_out = fcn_.getNumOutputs();
+  
+  // Pass the arguments, structural zeros for missing arguments
+  stream << "  {" << endl;
+  stream << "    const d* xx[" << std::max(num_in,1) << "];" << endl;
+  stream << "    d* rr[" << std::max(num_out,1) << "];" << endl;
+  for(int i=0; i<num_in; ++i){
+    const CRSSparsity& sp = fcn_.input(i).sparsity();
+    stream << "    xx[" << i << "]=";
+    if(arg.at(i)=="0"){
+      stream << gen.getConstant(vector<double>(sp.size(),0));
+    } else {
+      casadi_assert_message(dep(i).sparsity()==sp, "EvaluationMX::generateOperation: sparsity mismatch for input " << i);
+      stream << arg[i];
+    }
+    stream << ";" << endl;
+  }
+  
+  // Results, unused results are written to separate local arrays
+  for(int i=0; i<num_out; ++i){
+    const CRSSparsity& sp = fcn_.output(i).sparsity();
+    if(res.at(i)=="0"){
+      stream << "    d u" << i << "[" << std::max(sp.size(),1) << "];" << endl;
+    }
+  }
+  for(int i=0; i<num_out; ++i){
+    stream << "    rr[" << i << "]=";
+    if(res.at(i)=="0"){
+      stream << "u" << i;
+    } else {
+      stream << res[i];
+    }
+    stream << ";" << endl;
+  }
+  stream << "    " << f << "(xx,rr);" << endl;
+  stream << "  }" << endl;
+}
+
 } // namespace CasADi
@@ -27,6 +27,8 @@
 #include "../sx/sx_tools.hpp"
 #include "../fx/sx_function.hpp"
 #include "../matrix/sparsity_tools.hpp"
+#include "../fx/code_generator.hpp"
+#include "../fx/sparsity_cache.hpp"
 
 const bool ELIMINATE_NESTED = true;
 
@@ -60,7 +62,7 @@ void Mapping::evaluateBlock(int iind, int oind, const vector<T>& idata, vector<T
   }
 }
 
-void Mapping::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens){
+void Mapping::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens, std::vector<int>& itmp, std::vector<double>& rtmp){
   evaluateGen<double,DMatrixPtrV,DMatrixPtrVV>(input,output,fwdSeed,fwdSens,adjSeed,adjSens);
 }
 
@@ -106,6 +108,20 @@ void Mapping::evaluateGen(const MatV& input, MatV& output, const MatVV& fwdSeed,
   }
 }
 
+bool Mapping::hashStructure(StructureHash& h){
+  for(vector<vector<IOMap> >::const_iterator it=index_output_sorted_.begin(); it!=index_output_sorted_.end(); ++it){
+    h.add(int(it->size()));
+    for(vector<IOMap>::const_iterator it2=it->begin(); it2!=it->end(); ++it2){
+      h.add(int(it2->size()));
+      for(IOMap::const_iterator it3=it2->begin(); it3!=it2->end(); ++it3){
+        h.add(it3->first);
+        h.add(it3->second);
+      }
+    }
+  }
+  return true;
+}
+
 void Mapping::propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output, bool fwd){
   
   // Loop over outputs
@@ -141,6 +157,34 @@ void Mapping::propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output, bool fw
   }
 }
 
+void Mapping::propagateSparsityBlock(const std::vector<bvec_t*>& arg, const std::vector<bvec_t*>& res, int nw, bool fwd){
+  // Loop over outputs
+  for(int oind=0; oind<res.size(); ++oind){
+    if(res[oind]==0) continue;
+    bvec_t *outputd = res[oind];
+
+    // Clear output
+    if(fwd) fill_n(outputd,sparsity(oind).size()*nw,bvec_t(0));
+    
+    // Loop over inputs
+    for(int iind=0; iind<arg.size(); ++iind){
+      if(arg[iind]==0) continue;
+      bvec_t *inputd = arg[iind];
+      
+      // Propagate sparsity
+      const IOMap& assigns = index_output_sorted_[oind][iind];
+      for(IOMap::const_iterator it=assigns.begin(); it!=assigns.end(); ++it){
+        bvec_t *r = outputd + it->second*nw, *a = inputd + it->first*nw;
+        if(fwd){
+          for(int w=0; w<nw; ++w) r[w] |= a[w];
+        } else {
+          for(int w=0; w<nw; ++w) a[w] |= r[w];
+        }
+      }
+    }
+  }
+}
+
 void Mapping::printPart(std::ostream &stream, int part) const{
   if(ndep()==0){
     stream << "sparse(" << size1() << "," << size2() << ")";
@@ -645,4 +689,25 @@ bool Mapping::isTranspose() const{
   return true;
 }
 
+void Mapping::generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const{
+  // Clear the result
+  stream << "  for(i=0; i<" << size() << "; ++i) " << res.front() << "[i]=0;" << endl;
+  
+  // Add the contribution from each dependency
+  for(int iind=0; iind<arg.size(); ++iind){
+    const IOMap& assigns = index_output_sorted_[0][iind];
+    if(arg[iind]=="0" || assigns.empty()) continue;
+    
+    // Input and output nonzeros
+    vector<int> inz(assigns.size()), onz(assigns.size());
+    for(int k=0; k<assigns.size(); ++k){
+      inz[k] = assigns[k].first;
+      onz[k] = assigns[k].second;
+    }
+    string s_inz = gen.getConstant(inz);
+    string s_onz = gen.getConstant(onz);
+    stream << "  for(i=0; i<" << assigns.size() << "; ++i) " << res.front() << "[" << s_onz << "[i]] += " << arg[iind] << "[" << s_inz << "[i]];" << endl;
+  }
+}
+
 } // namespace CasADi
@@ -49,7 +49,7 @@ OutputNode::OutputNode(const MX& parent, int oind) : oind_(oind){
 OutputNode::~OutputNode(){
 }
 
-void OutputNode::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens){
+void OutputNode::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens, std::vector<int>& itmp, std::vector<double>& rtmp){
 }
 
 void OutputNode::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
@@ -61,6 +61,9 @@ void OutputNode::evaluateMX(const MXPtrV& input, MXPtrV& output, const MXPtrVV&
 void OutputNode::propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output, bool fwd){ 
 }
 
+void OutputNode::propagateSparsityBlock(const std::vector<bvec_t*>& arg, const std::vector<bvec_t*>& res, int nw, bool fwd){
+}
+
 void OutputNode::printPart(std::ostream &stream, int part) const{
   if(part==0){
     if(ndep()>1)
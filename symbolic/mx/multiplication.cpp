@@ -22,9 +22,11 @@
 
 #include "multiplication.hpp"
 #include "../matrix/matrix_tools.hpp"
+#include "../matrix/dense_kernels.hpp"
 #include "mx_tools.hpp"
 #include "../stl_vector_tools.hpp"
 #include <vector>
+#include "../fx/code_generator.hpp"
 
 using namespace std;
 
@@ -39,6 +41,9 @@ Multiplication::Multiplication(const MX& x, const MX& y_trans){
 
   // Save sparsity
   setSparsity(spres);
+  
+  // Structure of the numeric product, the sparsity patterns of the node are fixed
+  plan_ = MulPlan(x.sparsity(),y_trans.sparsity(),spres);
 }
 
 Multiplication* Multiplication::clone() const{
@@ -55,24 +60,124 @@ void Multiplication::printPart(std::ostream &stream, int part) const{
   }
 }
 
-void Multiplication::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens){
+void Multiplication::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens, std::vector<int>& itmp, std::vector<double>& rtmp){
   int nfwd = fwdSens.size();
   int nadj = adjSeed.size();
 
   fill(output[0]->begin(),output[0]->end(),0);
-  DMatrix::mul_no_alloc(*input[0],*input[1],*output[0]);
+  DMatrix::mul_no_alloc(*input[0],*input[1],*output[0],plan_);
 
   // Forward sensitivities: dot(Z) = dot(X)*Y + X*dot(Y)
+  if(nfwd>1){
+    evaluateFwdBatch(input,fwdSeed,fwdSens,rtmp);
+  } else {
+    for(int d=0; d<nfwd; ++d){
+      fill(fwdSens[d][0]->begin(),fwdSens[d][0]->end(),0);
+      DMatrix::mul_no_alloc(*fwdSeed[d][0],*input[1],*fwdSens[d][0],plan_);
+      DMatrix::mul_no_alloc(*input[0],*fwdSeed[d][1],*fwdSens[d][0],plan_);
+    }
+  }
+
+  // Adjoint sensitivities
+  if(nadj>1){
+    evaluateAdjBatch(input,adjSeed,adjSens,rtmp);
+  } else {
+    for(int d=0; d<nadj; ++d){
+      DMatrix::mul_no_alloc1(*adjSens[d][0],*input[1],*adjSeed[d][0],plan_);
+      DMatrix::mul_no_alloc2(*input[0],*adjSens[d][1],*adjSeed[d][0],plan_);
+    }
+  }
+}
+
+void Multiplication::evaluateFwdBatch(const DMatrixPtrV& input, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, std::vector<double>& rtmp){
+  int nfwd = fwdSens.size();
+  const vector<double> &x_data = input[0]->data();
+  const vector<double> &y_data = input[1]->data();
   for(int d=0; d<nfwd; ++d){
     fill(fwdSens[d][0]->begin(),fwdSens[d][0]->end(),0);
-    DMatrix::mul_no_alloc(*fwdSeed[d][0],*input[1],*fwdSens[d][0]);
-    DMatrix::mul_no_alloc(*input[0],*fwdSeed[d][1],*fwdSens[d][0]);
   }
+  
+  if(plan_.dense){
+    int m = plan_.m, n = plan_.n, k = plan_.k;
+    if(rtmp.size()<nfwd*(m*k + n*k + 2*m*n)) rtmp.resize(nfwd*(m*k + n*k + 2*m*n));
+    double* dx = getPtr(rtmp);       // dot(X) of all directions on top of each other
+    double* dy = dx + nfwd*m*k;      // dot(Y), likewise
+    double* dz1 = dy + nfwd*n*k;     // dot(X)*Y, on top of each other
+    double* dz2 = dz1 + nfwd*m*n;    // X*dot(Y), side by side
+    for(int d=0; d<nfwd; ++d){
+      copy(fwdSeed[d][0]->begin(),fwdSeed[d][0]->end(),dx+d*m*k);
+      copy(fwdSeed[d][1]->begin(),fwdSeed[d][1]->end(),dy+d*n*k);
+    }
+    fill(dz1,dz1+2*nfwd*m*n,0);
+    if(m*n*k>0){
+      dense_mul_nt(nfwd*m,n,k,dx,getPtr(y_data),dz1);
+      dense_mul_nt(m,nfwd*n,k,getPtr(x_data),dy,dz2);
+    }
+    for(int d=0; d<nfwd; ++d){
+      vector<double>& r = fwdSens[d][0]->data();
+      for(int i=0; i<m; ++i){
+        for(int j=0; j<n; ++j){
+          r[i*n+j] = dz1[(d*m+i)*n+j] + dz2[(i*nfwd+d)*n+j];
+        }
+      }
+    }
+    return;
+  }
+  
+  // Sparse: loop over the pairs of nonzeros of the factors once for all directions
+  for(int el=0; el<size(); ++el){
+    for(int p=plan_.pair_begin[el]; p<plan_.pair_begin[el+1]; ++p){
+      int el1 = plan_.x_el[p], el2 = plan_.y_el[p];
+      for(int d=0; d<nfwd; ++d){
+        fwdSens[d][0]->data()[el] += fwdSeed[d][0]->data()[el1]*y_data[el2] + x_data[el1]*fwdSeed[d][1]->data()[el2];
+      }
+    }
+  }
+}
 
-  // Adjoint sensitivities
-  for(int d=0; d<nadj; ++d){
-    DMatrix::mul_no_alloc1(*adjSens[d][0],*input[1],*adjSeed[d][0]);
-    DMatrix::mul_no_alloc2(*input[0],*adjSens[d][1],*adjSeed[d][0]);
+void Multiplication::evaluateAdjBatch(const DMatrixPtrV& input, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens, std::vector<double>& rtmp){
+  int nadj = adjSeed.size();
+  const vector<double> &x_data = input[0]->data();
+  const vector<double> &y_data = input[1]->data();
+  
+  if(plan_.dense){
+    int m = plan_.m, n = plan_.n, k = plan_.k;
+    if(rtmp.size()<nadj*(2*m*n + m*k + n*k)) rtmp.resize(nadj*(2*m*n + m*k + n*k));
+    double* az1 = getPtr(rtmp);      // bar(Z) of all directions on top of each other
+    double* az2 = az1 + nadj*m*n;    // bar(Z), side by side
+    double* ax = az2 + nadj*m*n;     // bar(Z)*trans(Y), on top of each other
+    double* ay = ax + nadj*m*k;      // trans(bar(Z))*X, on top of each other
+    for(int d=0; d<nadj; ++d){
+      const vector<double>& s = adjSeed[d][0]->data();
+      copy(s.begin(),s.end(),az1+d*m*n);
+      for(int i=0; i<m; ++i){
+        copy(s.begin()+i*n,s.begin()+(i+1)*n,az2+(i*nadj+d)*n);
+      }
+    }
+    fill(ax,ax+nadj*(m*k+n*k),0);
+    if(m*n*k>0){
+      dense_mul_nn(nadj*m,k,n,az1,getPtr(y_data),ax);
+      dense_mul_tn(nadj*n,k,m,az2,getPtr(x_data),ay);
+    }
+    for(int d=0; d<nadj; ++d){
+      vector<double>& rx = adjSens[d][0]->data();
+      for(int i=0; i<m*k; ++i) rx[i] += ax[d*m*k+i];
+      vector<double>& ry = adjSens[d][1]->data();
+      for(int i=0; i<n*k; ++i) ry[i] += ay[d*n*k+i];
+    }
+    return;
+  }
+  
+  // Sparse: loop over the pairs of nonzeros of the factors once for all directions
+  for(int el=0; el<size(); ++el){
+    for(int p=plan_.pair_begin[el]; p<plan_.pair_begin[el+1]; ++p){
+      int el1 = plan_.x_el[p], el2 = plan_.y_el[p];
+      for(int d=0; d<nadj; ++d){
+        double s = adjSeed[d][0]->data()[el];
+        adjSens[d][0]->data()[el1] += s*y_data[el2];
+        adjSens[d][1]->data()[el2] += s*x_data[el1];
+      }
+    }
   }
 }
 
@@ -103,5 +208,13 @@ void Multiplication::propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output,
   DMatrix::mul_sparsity(*input[0],*input[1],*output[0],fwd);
 }
 
+void Multiplication::generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const{
+  gen.addAuxiliary(CodeGenerator::AUX_MM_NT);
+  stream << "  for(i=0; i<" << size() << "; ++i) " << res.front() << "[i]=0;" << endl;
+  stream << "  casadi_mm_nt(" << arg.at(0) << "," << gen.getSparsity(dep(0).sparsity()) << ",";
+  stream << arg.at(1) << "," << gen.getSparsity(dep(1).sparsity()) << ",";
+  stream << res.front() << "," << gen.getSparsity(sparsity()) << ");" << endl;
+}
+
 } // namespace CasADi
 
@@ -226,9 +226,15 @@ int MXNode::getFunctionInput() const{
   throw CasadiException(string("MXNode::getFunctionOutput() not defined for class ") + typeid(*this).name());
 }
 
+void MXNode::generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const{
+  throw CasadiException(string("MXNode::generateOperation() not defined for class ") + typeid(*this).name());
+}
+
 void MXNode::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output){
   DMatrixPtrVV fwdSeed, fwdSens, adjSeed, adjSens;
-  evaluateD(input,output,fwdSeed, fwdSens, adjSeed, adjSens);
+  vector<int> itmp;
+  vector<double> rtmp;
+  evaluateD(input,output,fwdSeed, fwdSens, adjSeed, adjSens, itmp, rtmp);
 }
 
 void MXNode::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output){
@@ -241,6 +247,47 @@ void MXNode::evaluateMX(const MXPtrV& input, MXPtrV& output){
   evaluateMX(input,output,fwdSeed, fwdSens, adjSeed, adjSens,false);
 }
 
+void MXNode::propagateSparsityBlock(const std::vector<bvec_t*>& arg, const std::vector<bvec_t*>& res, int nw, bool fwd){
+  // Matrices holding a single word per nonzero
+  vector<DMatrix> arg_w(arg.size()), res_w(res.size());
+  DMatrixPtrV input(arg.size(),0), output(res.size(),0);
+  for(int iind=0; iind<arg.size(); ++iind){
+    if(arg[iind]==0) continue;
+    arg_w[iind] = DMatrix(dep(iind).sparsity(),0);
+    input[iind] = &arg_w[iind];
+  }
+  for(int oind=0; oind<res.size(); ++oind){
+    if(res[oind]==0) continue;
+    res_w[oind] = DMatrix(sparsity(oind),0);
+    output[oind] = &res_w[oind];
+  }
+  
+  // Propagate word by word
+  for(int w=0; w<nw; ++w){
+    for(int iind=0; iind<arg.size(); ++iind){
+      if(arg[iind]==0) continue;
+      bvec_t* a = get_bvec_t(arg_w[iind].data());
+      for(int el=0; el<arg_w[iind].size(); ++el) a[el] = arg[iind][el*nw+w];
+    }
+    for(int oind=0; oind<res.size(); ++oind){
+      if(res[oind]==0) continue;
+      bvec_t* r = get_bvec_t(res_w[oind].data());
+      for(int el=0; el<res_w[oind].size(); ++el) r[el] = res[oind][el*nw+w];
+    }
+    propagateSparsity(input,output,fwd);
+    for(int iind=0; iind<arg.size(); ++iind){
+      if(arg[iind]==0) continue;
+      const bvec_t* a = get_bvec_t(arg_w[iind].data());
+      for(int el=0; el<arg_w[iind].size(); ++el) arg[iind][el*nw+w] = a[el];
+    }
+    for(int oind=0; oind<res.size(); ++oind){
+      if(res[oind]==0) continue;
+      const bvec_t* r = get_bvec_t(res_w[oind].data());
+      for(int el=0; el<res_w[oind].size(); ++el) res[oind][el*nw+w] = r[el];
+    }
+  }
+}
+
 void MXNode::deepCopyMembers(std::map<SharedObjectNode*,SharedObject>& already_copied){
   SharedObjectNode::deepCopyMembers(already_copied);
   dep_ = deepcopy(dep_,already_copied);
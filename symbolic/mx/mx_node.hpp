@@ -30,6 +30,10 @@
 #include <stack>
 
 namespace CasADi{
+  /// Forward declaration
+  class CodeGenerator;
+  class StructureHash;
+
   //@{
   /** \brief Convenience function, convert vectors to vectors of pointers */
   template<class T>
@@ -104,10 +108,13 @@ class MXNode : public SharedObjectNode{
     /** \brief  Print a part of the expression */
     virtual void printPart(std::ostream &stream, int part) const = 0;
     
-    /** \brief  Evaluate the function */
+    /** \brief  Evaluate the function
+        itmp and rtmp are work vectors owned by the caller, which the node may resize and overwrite. They are reused between
+        calls and nodes, so that the nodes do not keep any state and can be shared between functions. */
     virtual void evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, 
                            const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, 
-                           const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens) = 0;
+                           const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens,
+                           std::vector<int>& itmp, std::vector<double>& rtmp) = 0;
 
     /** \brief  Evaluate the function, no derivatives*/
     void evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output);
@@ -131,6 +138,16 @@ class MXNode : public SharedObjectNode{
     /** \brief  Propagate sparsity */
     virtual void propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output, bool fwd) = 0;
 
+    /** \brief  Propagate sparsity with nw words (nw*bvec_size directions) per nonzero, stored word by word for each nonzero
+        A null pointer marks an argument or result that is not used. By default, propagateSparsity is called once for each word. */
+    virtual void propagateSparsityBlock(const std::vector<bvec_t*>& arg, const std::vector<bvec_t*>& res, int nw, bool fwd);
+
+    /** \brief  Add what the sparsity propagation depends on, other than the operation and the sparsity of the dependencies and outputs, to a hash. Returns false if not possible */
+    virtual bool hashStructure(StructureHash& h){ return false;}
+
+    /** \brief  Generate C code for the operation, given the names of the argument and result arrays */
+    virtual void generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const;
+
     /** \brief  Get the name */
     virtual const std::string& getName() const;
     
@@ -22,9 +22,11 @@
 
 #include "solve.hpp"
 #include "../matrix/matrix_tools.hpp"
+#include "../matrix/dense_kernels.hpp"
 #include "mx_tools.hpp"
 #include "../stl_vector_tools.hpp"
 #include <vector>
+#include "../fx/code_generator.hpp"
 
 using namespace std;
 
@@ -57,8 +59,96 @@ void Solve::printPart(std::ostream &stream, int part) const{
   }
 }
 
-void Solve::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens){
-  casadi_error("Not implemented");
+void Solve::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens, std::vector<int>& itmp, std::vector<double>& rtmp){
+  int nfwd = fwdSens.size();
+  int nadj = adjSeed.size();
+  const DMatrix& A = *input[0];
+  const DMatrix& b = *input[1];
+  vector<double>& x = output[0]->data();
+  int n = size1(), nrhs = size2();
+  
+  // Work vectors: the LU factorization of A and its row permutation, the right hand sides of all directions side by side
+  // and the work vector for the substitutions
+  int ndir = std::max(nfwd,nadj);
+  int nrtmp = n*n + n*nrhs*ndir + n*nrhs*std::max(1,ndir);
+  if(rtmp.size()<nrtmp) rtmp.resize(nrtmp);
+  if(itmp.size()<n) itmp.resize(n);
+  double *lu = getPtr(rtmp), *rhs = lu + n*n, *work = rhs + n*nrhs*ndir;
+  int* perm = getPtr(itmp);
+  
+  // Factorize A once, the factorization is used for the right hand sides of all directions
+  std::fill(lu,lu+n*n,0);
+  for(int i=0; i<n; ++i){
+    for(int el=A.rowind(i); el<A.rowind(i+1); ++el){
+      lu[i*n+A.col(el)] = A.at(el);
+    }
+  }
+  bool nonsingular = dense_lu(n,lu,perm);
+  casadi_assert_message(nonsingular,"Solve::evaluateD: the matrix is singular");
+  
+  // Nondifferentiated solution
+  fill(x.begin(),x.end(),0);
+  for(int i=0; i<n; ++i){
+    for(int el=b.rowind(i); el<b.rowind(i+1); ++el){
+      x[i*nrhs+b.col(el)] = b.at(el);
+    }
+  }
+  if(n>0 && nrhs>0) dense_lu_solve(n,lu,perm,getPtr(x),nrhs,false,work);
+  
+  // Forward sensitivities: A*dot(X) = dot(B) - dot(A)*X, solved for all directions at once
+  if(nfwd>0 && n>0 && nrhs>0){
+    int w = nfwd*nrhs;
+    std::fill(rhs,rhs+n*w,0);
+    for(int d=0; d<nfwd; ++d){
+      const vector<double>& db = fwdSeed[d][1]->data();
+      const vector<double>& dA = fwdSeed[d][0]->data();
+      for(int i=0; i<n; ++i){
+        double* r = rhs + i*w + d*nrhs;
+        for(int el=b.rowind(i); el<b.rowind(i+1); ++el){
+          r[b.col(el)] += db[el];
+        }
+        for(int el=A.rowind(i); el<A.rowind(i+1); ++el){
+          const double* x_j = getPtr(x) + A.col(el)*nrhs;
+          for(int c=0; c<nrhs; ++c) r[c] -= dA[el]*x_j[c];
+        }
+      }
+    }
+    dense_lu_solve(n,lu,perm,rhs,w,false,work);
+    for(int d=0; d<nfwd; ++d){
+      vector<double>& dx = fwdSens[d][0]->data();
+      for(int i=0; i<n; ++i){
+        copy(rhs+i*w+d*nrhs,rhs+i*w+(d+1)*nrhs,dx.begin()+i*nrhs);
+      }
+    }
+  }
+  
+  // Adjoint sensitivities: trans(A)*L = bar(X), bar(B) += L, bar(A) -= L*trans(X), solved for all directions at once
+  if(nadj>0 && n>0 && nrhs>0){
+    int w = nadj*nrhs;
+    for(int d=0; d<nadj; ++d){
+      const vector<double>& ax = adjSeed[d][0]->data();
+      for(int i=0; i<n; ++i){
+        copy(ax.begin()+i*nrhs,ax.begin()+(i+1)*nrhs,rhs+i*w+d*nrhs);
+      }
+    }
+    dense_lu_solve(n,lu,perm,rhs,w,true,work);
+    for(int d=0; d<nadj; ++d){
+      vector<double>& ab = adjSens[d][1]->data();
+      vector<double>& aA = adjSens[d][0]->data();
+      for(int i=0; i<n; ++i){
+        const double* l_i = rhs + i*w + d*nrhs;
+        for(int el=b.rowind(i); el<b.rowind(i+1); ++el){
+          ab[el] += l_i[b.col(el)];
+        }
+        for(int el=A.rowind(i); el<A.rowind(i+1); ++el){
+          const double* x_j = getPtr(x) + A.col(el)*nrhs;
+          double s = 0;
+          for(int c=0; c<nrhs; ++c) s += l_i[c]*x_j[c];
+          aA[el] -= s;
+        }
+      }
+    }
+  }
 }
 
 void Solve::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
@@ -73,5 +163,21 @@ void Solve::propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output, bool fwd)
   casadi_error("Not implemented");
 }
 
+void Solve::generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const{
+  casadi_assert_message(arg.at(0)!="0","Solve::generateOperation: the matrix is structurally zero");
+  if(res.front()=="0") return;
+  gen.addAuxiliary(CodeGenerator::AUX_SOLVE);
+  int n = size1(), nrhs = size2();
+  string b = arg.at(1)=="0" ? gen.getConstant(vector<double>(dep(1).size(),0)) : arg[1];
+  
+  // The factorization is stored in local arrays, a singular matrix makes the generated function return 1
+  stream << "  {" << endl;
+  stream << "    d lu[" << std::max(n*n,1) << "], wrk[" << std::max(n*nrhs,1) << "];" << endl;
+  stream << "    int perm[" << std::max(n,1) << "];" << endl;
+  stream << "    if(casadi_solve(" << arg[0] << "," << gen.getSparsity(dep(0).sparsity()) << "," << b << "," << gen.getSparsity(dep(1).sparsity()) << ",";
+  stream << res.front() << ",lu,wrk,perm)) return 1;" << endl;
+  stream << "  }" << endl;
+}
+
 } // namespace CasADi
 
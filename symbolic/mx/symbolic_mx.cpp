@@ -43,7 +43,7 @@ void SymbolicMX::printPart(std::ostream &stream, int part) const{
   stream << name_;
 }
 
-void SymbolicMX::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens){
+void SymbolicMX::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens, std::vector<int>& itmp, std::vector<double>& rtmp){
 }
 
 void SymbolicMX::evaluateSX(const SXMatrixPtrV& input, SXMatrixPtrV& output, const SXMatrixPtrVV& fwdSeed, SXMatrixPtrVV& fwdSens, const SXMatrixPtrVV& adjSeed, SXMatrixPtrVV& adjSens){
@@ -67,6 +67,12 @@ void SymbolicMX::propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output, bool
   }
 }
 
+void SymbolicMX::propagateSparsityBlock(const std::vector<bvec_t*>& arg, const std::vector<bvec_t*>& res, int nw, bool fwd){
+  if(fwd){
+    fill_n(res[0],size()*nw,bvec_t(0));
+  }
+}
+
 
 } // namespace CasADi
 
@@ -25,6 +25,7 @@
 #include <vector>
 #include <sstream>
 #include "../stl_vector_tools.hpp"
+#include "../fx/code_generator.hpp"
 
 using namespace std;
 
@@ -52,7 +53,7 @@ void UnaryMX::printPart(std::ostream &stream, int part) const{
   }
 }
 
-void UnaryMX::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens){
+void UnaryMX::evaluateD(const DMatrixPtrV& input, DMatrixPtrV& output, const DMatrixPtrVV& fwdSeed, DMatrixPtrVV& fwdSens, const DMatrixPtrVV& adjSeed, DMatrixPtrVV& adjSens, std::vector<int>& itmp, std::vector<double>& rtmp){
   double nan = numeric_limits<double>::quiet_NaN();
   vector<double> &outputd = output[0]->data();
   const vector<double> &inputd = input[0]->data();
@@ -135,6 +136,18 @@ void UnaryMX::propagateSparsity(DMatrixPtrV& input, DMatrixPtrV& output, bool fw
   }
 }
 
+void UnaryMX::propagateSparsityBlock(const std::vector<bvec_t*>& arg, const std::vector<bvec_t*>& res, int nw, bool fwd){
+  bvec_t *inputd = arg[0], *outputd = res[0];
+  int n = size()*nw;
+  if(fwd){
+    copy(inputd,inputd+n,outputd);
+  } else {
+    for(int k=0; k<n; ++k){
+      inputd[k] |= outputd[k];
+    }
+  }
+}
+
 MX UnaryMX::create(int op, const MX& x){
   /*if(x.isConstant()){
     // Constant folding
@@ -152,6 +165,11 @@ MX UnaryMX::create(int op, const MX& x){
   }
 }
 
+void UnaryMX::generateOperation(std::ostream &stream, const std::vector<std::string>& arg, const std::vector<std::string>& res, CodeGenerator& gen) const{
+  stream << "  for(i=0; i<" << size() << "; ++i) " << res.front() << "[i]=";
+  casadi_math<double>::print(op_,stream,arg.front()+"[i]","");
+  stream << ";" << endl;
+}
 
 } // namespace CasADi
 
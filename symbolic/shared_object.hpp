@@ -25,6 +25,7 @@
 
 #include "printable_object.hpp"
 #include "casadi_exception.hpp"
+#include "casadi_types.hpp"
 #include <map>
 #include <vector>
 
@@ -204,7 +205,7 @@ class SharedObjectNode{
 
   private:
     /// Number of references pointing to the object
-    unsigned int count;
+    refcount_t count;
 };
 
 /// Typecast a shared object to a base class to a shared object to a derived class, cf. dynamic_cast
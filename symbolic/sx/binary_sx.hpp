@@ -33,6 +33,7 @@ namespace CasADi{
   \date 2010
 */
 class BinarySX : public SXNode{
+  friend class SX;
   private:
     
     /** \brief  Constructor is private, use "create" below */
@@ -51,77 +52,16 @@ class BinarySX : public SXNode{
 	return ret_val;
       } else {
 	// Expression containing free variables
+	if(SX::getHashConsing()){
+	  // Reuse an identical expression, if any
+	  return SX::hashConsed(op,dep0,dep1);
+	}
 	return SX::create(new BinarySX(op,dep0,dep1));
       }
     }
     
-    /** \brief Destructor
-    This is a rather complex destructor which is necessary since the default destructor 
-    can cause stack overflow due to recursive calling.
-    */
-    virtual ~BinarySX(){
-      // Start destruction method if any of the dependencies has dependencies
-      for(int c1=0; c1<2; ++c1){
-        // Get the node of the dependency and remove it from the smart pointer
-        SXNode* n1 = dep(c1).assignNoDelete(casadi_limits<SX>::nan);
-        
-        // Check if this was the last reference
-        if(n1->count==0){
-
-          // Check if binary
-          if(!n1->hasDep()){ // n1 is not binary
-
-            delete n1; // Delete stright away 
-
-          } else { // n1 is binary
-            
-            // Stack of experssions to be deleted
-            std::stack<SXNode*> deletion_stack;
-            
-            // Add the node to the deletion stack
-            deletion_stack.push(n1);
-            
-            // Process stack
-            while(!deletion_stack.empty()){
-              
-              // Top element
-              SXNode *t = deletion_stack.top();
-              
-              // Check if the top element has dependencies with dependencies
-              bool added_to_stack = false;
-              for(int c2=0; c2<t->ndep(); ++c2){ // for all dependencies of the dependency
-                
-                // Get the node of the dependency of the top element and remove it from the smart pointer
-                SXNode *n2 = t->dep(c2).assignNoDelete(casadi_limits<SX>::nan);
-                
-                // Check if this is the only reference to the element
-                if(n2->count == 0){
-                  
-                  // Check if binary
-                  if(!n2->hasDep()){
-                    
-                    // Delete stright away if not binary
-                    delete n2;
-                    
-                  } else {
-                    
-                    // Add to deletion stack
-                    deletion_stack.push(n2);
-                    added_to_stack = true;
-                  }
-                }
-              }
-              
-              // Delete and pop from stack if nothing added to the stack
-              if(!added_to_stack){
-                delete deletion_stack.top();
-                deletion_stack.pop();
-              }
-            } // while
-          }
-        }
-      }
-    }
+    /** \brief Destructor (the dependencies are released by SX without recursion) */
+    virtual ~BinarySX(){}
     
     virtual bool isSmooth() const{ return operation_checker<SmoothChecker>(op_);}
     
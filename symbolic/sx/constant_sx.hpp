@@ -25,6 +25,9 @@
 
 #include "sx_node.hpp"
 #include <cassert>
+#ifdef WITH_THREADSAFE_SYMBOLICS
+#include <mutex>
+#endif // WITH_THREADSAFE_SYMBOLICS
 
 // Cashing of constants requires a map (preferably a hash map)
 #ifdef USE_CXX11
@@ -88,28 +91,40 @@ class RealtypeSX : public ConstantSX{
     
     /// Destructor
     virtual ~RealtypeSX(){
-      size_t num_erased = cached_constants_.erase(value);
-      assert(num_erased==1);
+#ifdef WITH_THREADSAFE_SYMBOLICS
+      std::lock_guard<std::mutex> lock(mutex_);
+#endif // WITH_THREADSAFE_SYMBOLICS
+      // Remove from the cache, unless already replaced by a new node (see create)
+      CACHING_MAP<double,RealtypeSX*>::iterator it = cached_constants_.find(value);
+      if(it!=cached_constants_.end() && it->second==this) cached_constants_.erase(it);
     }
     
-    /// Static creator function (use instead of constructor)
+    /// Static creator function (use instead of constructor), the reference counter of the returned node has already been increased
     inline static RealtypeSX* create(double value){
+#ifdef WITH_THREADSAFE_SYMBOLICS
+      std::lock_guard<std::mutex> lock(mutex_);
+#endif // WITH_THREADSAFE_SYMBOLICS
       // Try to find the constant
       CACHING_MAP<double,RealtypeSX*>::iterator it = cached_constants_.find(value);
       
-      // If not found, add it,
-      if(it==cached_constants_.end()){
-        // Allocate a new object
-        RealtypeSX* n = new RealtypeSX(value);
-        
-        // Add to hash_table
-        cached_constants_.insert(it,std::make_pair(value,n));
-        
-        // Return it to caller
-        return n;
-      } else { // Else, returned the object
+      // If found, take a reference to it, unless the last reference has been released by another thread and the node is about to be deleted
+      if(it!=cached_constants_.end()){
+#ifdef WITH_THREADSAFE_SYMBOLICS
+        unsigned int c = it->second->count.load();
+        while(c!=0){
+          if(it->second->count.compare_exchange_weak(c,c+1)) return it->second;
+        }
+#else // WITH_THREADSAFE_SYMBOLICS
+        it->second->count++;
         return it->second;
+#endif // WITH_THREADSAFE_SYMBOLICS
       }
+      
+      // Allocate a new object and add it to (or replace it in) the hash table
+      RealtypeSX* n = new RealtypeSX(value);
+      n->count++;
+      cached_constants_[value] = n;
+      return n;
     }
     
     //@{
@@ -121,6 +136,11 @@ class RealtypeSX : public ConstantSX{
   protected:
     /** \brief Hash map of all constants currently allocated (storage is allocated for it in sx.cpp) */
     static CACHING_MAP<double,RealtypeSX*> cached_constants_;
+
+#ifdef WITH_THREADSAFE_SYMBOLICS
+    /** \brief Mutex protecting the hash map */
+    static std::mutex mutex_;
+#endif // WITH_THREADSAFE_SYMBOLICS
     
     /** \brief  Data members */
     double value;
@@ -140,28 +160,40 @@ class IntegerSX : public ConstantSX{
 
     /// Destructor
     virtual ~IntegerSX(){
-      size_t num_erased = cached_constants_.erase(value);
-      assert(num_erased==1);
+#ifdef WITH_THREADSAFE_SYMBOLICS
+      std::lock_guard<std::mutex> lock(mutex_);
+#endif // WITH_THREADSAFE_SYMBOLICS
+      // Remove from the cache, unless already replaced by a new node (see create)
+      CACHING_MAP<int,IntegerSX*>::iterator it = cached_constants_.find(value);
+      if(it!=cached_constants_.end() && it->second==this) cached_constants_.erase(it);
     }
     
-    /// Static creator function (use instead of constructor)
+    /// Static creator function (use instead of constructor), the reference counter of the returned node has already been increased
     inline static IntegerSX* create(int value){
+#ifdef WITH_THREADSAFE_SYMBOLICS
+      std::lock_guard<std::mutex> lock(mutex_);
+#endif // WITH_THREADSAFE_SYMBOLICS
       // Try to find the constant
       CACHING_MAP<int,IntegerSX*>::iterator it = cached_constants_.find(value);
       
-      // If not found, add it,
-      if(it==cached_constants_.end()){
-        // Allocate a new object
-        IntegerSX* n = new IntegerSX(value);
-        
-        // Add to hash_table
-        cached_constants_.insert(it,std::make_pair(value,n));
-        
-        // Return it to caller
-        return n;
-      } else { // Else, returned the object
+      // If found, take a reference to it, unless the last reference has been released by another thread and the node is about to be deleted
+      if(it!=cached_constants_.end()){
+#ifdef WITH_THREADSAFE_SYMBOLICS
+        unsigned int c = it->second->count.load();
+        while(c!=0){
+          if(it->second->count.compare_exchange_weak(c,c+1)) return it->second;
+        }
+#else // WITH_THREADSAFE_SYMBOLICS
+        it->second->count++;
         return it->second;
+#endif // WITH_THREADSAFE_SYMBOLICS
       }
+      
+      // Allocate a new object and add it to (or replace it in) the hash table
+      IntegerSX* n = new IntegerSX(value);
+      n->count++;
+      cached_constants_[value] = n;
+      return n;
     }
     
     //@{
@@ -177,6 +209,11 @@ class IntegerSX : public ConstantSX{
 
     /** \brief Hash map of all constants currently allocated (storage is allocated for it in sx.cpp) */
     static CACHING_MAP<int,IntegerSX*> cached_constants_;
+
+#ifdef WITH_THREADSAFE_SYMBOLICS
+    /** \brief Mutex protecting the hash map */
+    static std::mutex mutex_;
+#endif // WITH_THREADSAFE_SYMBOLICS
     
     /** \brief  Data members */
     int value;
@@ -24,6 +24,7 @@
 #include "../matrix/matrix.hpp"
 #include "../matrix/generic_expression_tools.hpp"
 #include <stack>
+#include <map>
 #include <cassert>
 #include "../casadi_math.hpp"
 #include "constant_sx.hpp"
@@ -37,6 +38,26 @@ namespace CasADi{
 // Allocate storage for the caching
 CACHING_MAP<int,IntegerSX*> IntegerSX::cached_constants_;
 CACHING_MAP<double,RealtypeSX*> RealtypeSX::cached_constants_;
+#ifdef WITH_THREADSAFE_SYMBOLICS
+std::mutex IntegerSX::mutex_;
+std::mutex RealtypeSX::mutex_;
+#endif // WITH_THREADSAFE_SYMBOLICS
+
+// Hash-consing table: operation and dependency nodes (null for unary operations) to expression.
+// The table does not own the nodes, an entry is removed when its node is deleted.
+typedef std::pair<int,std::pair<const SXNode*,const SXNode*> > HashConsKey;
+static std::map<HashConsKey,SXNode*> hash_consed_;
+
+// Number of entries in the table, read without locking when deleting nodes
+static refcount_t hash_consed_size_(0);
+
+// Number of expressions found in the hash-consing table
+static long hash_consing_hits_ = 0;
+
+#ifdef WITH_THREADSAFE_SYMBOLICS
+// Mutex protecting the hash-consing table and counter
+static std::mutex hash_consing_mutex_;
+#endif // WITH_THREADSAFE_SYMBOLICS
 
 SX::SX(){
   node = casadi_limits<SX>::nan.node;
@@ -63,12 +84,12 @@ SX::SX(double val){
     else if(intval == 1)        node = casadi_limits<SX>::one.node;
     else if(intval == 2)        node = casadi_limits<SX>::two.node;
     else if(intval == -1)       node = casadi_limits<SX>::minus_one.node;
-    else                        node = IntegerSX::create(intval);
+    else{                       node = IntegerSX::create(intval); return;} // counted by create
     node->count++;
   } else {
     if(isnan(val))              node = casadi_limits<SX>::nan.node;
     else if(isinf(val))         node = val > 0 ? casadi_limits<SX>::inf.node : casadi_limits<SX>::minus_inf.node;
-    else                        node = RealtypeSX::create(val);
+    else{                       node = RealtypeSX::create(val); return;} // counted by create
     node->count++;
   }
 }
@@ -78,20 +99,57 @@ SX::SX(const std::string& name){
   node->count++;
 }
 
+void SX::deleteNode(SXNode* node){
+  // Quick return if no dependencies
+  if(!node->hasDep()){
+    delete node;
+    return;
+  }
+  
+  // Nodes to be deleted
+  vector<SXNode*> deletion_stack(1,node);
+  while(!deletion_stack.empty()){
+    SXNode* t = deletion_stack.back();
+    deletion_stack.pop_back();
+    
+    // Nodes without dependencies cause no further deletions and are not in the hash-consing table
+    if(!t->hasDep()){
+      delete t;
+      continue;
+    }
+    
+    // Remove the node from the hash-consing table, while the key (the dependencies) is still valid
+    if(hash_consed_size_>0) removeHashConsed(t);
+    
+    // Detach the dependencies so that deleting the node does not cause further deletions
+    int ndep = t->ndep();
+    casadi_limits<SX>::nan.node->count += ndep;
+    for(int c=0; c<ndep; ++c){
+      SXNode* d = t->dep(c).node;
+      t->dep(c).node = casadi_limits<SX>::nan.node;
+      
+      // Exactly one owner (possibly in another thread) sees the counter reach zero
+      if(--d->count==0) deletion_stack.push_back(d);
+    }
+    delete t;
+  }
+}
+
 SX::~SX(){
-  if(--node->count == 0) delete node;
+  if(--node->count == 0) deleteNode(node);
 }
 
 SX& SX::operator=(const SX &scalar){
   // quick return if the old and new pointers point to the same object
   if(node == scalar.node) return *this;
 
-  // decrease the counter and delete if this was the last pointer	
-  if(--node->count == 0) delete node;
-
-  // save the new pointer
+  // save the new pointer before releasing the old one, which may own the new one
+  SXNode* old_node = node;
   node = scalar.node;
   node->count++;
+
+  // decrease the counter and delete if this was the last pointer	
+  if(--old_node->count == 0) deleteNode(old_node);
   return *this;
 }
 
@@ -504,7 +562,7 @@ bool __nonzero__<SX>(const SX& val) { return val.__nonzero__();}
 
 const SX casadi_limits<SX>::zero(new ZeroSX(),false); // node corresponding to a constant 0
 const SX casadi_limits<SX>::one(new OneSX(),false); // node corresponding to a constant 1
-const SX casadi_limits<SX>::two(IntegerSX::create(2),false); // node corresponding to a constant 2
+const SX casadi_limits<SX>::two(IntegerSX::create(2),false); // node corresponding to a constant 2 (with an extra reference from create, never deleted)
 const SX casadi_limits<SX>::minus_one(new MinusOneSX(),false); // node corresponding to a constant -1
 const SX casadi_limits<SX>::nan(new NanSX(),false);
 const SX casadi_limits<SX>::inf(new InfSX(),false);
@@ -759,6 +817,101 @@ long SX::getMaxNumCallsInPrint(){
   return max_num_calls_in_print_;
 }
 
+#ifdef WITH_THREADSAFE_SYMBOLICS
+std::atomic<bool> SX::hash_consing_(false);
+#else // WITH_THREADSAFE_SYMBOLICS
+bool SX::hash_consing_ = false;
+#endif // WITH_THREADSAFE_SYMBOLICS
+
+void SX::setHashConsing(bool flag){
+  hash_consing_ = flag;
+}
+
+bool SX::getHashConsing(){
+  return hash_consing_;
+}
+
+void SX::clearHashConsing(){
+#ifdef WITH_THREADSAFE_SYMBOLICS
+  std::lock_guard<std::mutex> lock(hash_consing_mutex_);
+#endif // WITH_THREADSAFE_SYMBOLICS
+  hash_consed_.clear();
+  hash_consed_size_ = 0;
+  hash_consing_hits_ = 0;
+}
+
+int SX::getHashConsingSize(){
+#ifdef WITH_THREADSAFE_SYMBOLICS
+  std::lock_guard<std::mutex> lock(hash_consing_mutex_);
+#endif // WITH_THREADSAFE_SYMBOLICS
+  return hash_consed_.size();
+}
+
+long SX::getHashConsingHits(){
+#ifdef WITH_THREADSAFE_SYMBOLICS
+  std::lock_guard<std::mutex> lock(hash_consing_mutex_);
+#endif // WITH_THREADSAFE_SYMBOLICS
+  return hash_consing_hits_;
+}
+
+long SX::getPoolMemory(){
+  return SXNode::getPoolMemory();
+}
+
+SX SX::hashConsed(int op, const SX& dep0, const SX& dep1){
+  const bool binary = casadi_math<double>::ndeps(op)==2;
+  const SXNode* n1 = binary ? dep1.get() : 0;
+#ifdef WITH_THREADSAFE_SYMBOLICS
+  std::lock_guard<std::mutex> lock(hash_consing_mutex_);
+#endif // WITH_THREADSAFE_SYMBOLICS
+  // Look for the expression
+  map<HashConsKey,SXNode*>::iterator it = hash_consed_.find(HashConsKey(op,make_pair(dep0.get(),n1)));
+  
+  // Commutative operations: look for the expression with the arguments swapped
+  if(it==hash_consed_.end() && binary && operation_checker<CommChecker>(op)){
+    it = hash_consed_.find(HashConsKey(op,make_pair(n1,dep0.get())));
+  }
+  
+  if(it!=hash_consed_.end()){
+    SXNode* n = it->second;
+#ifdef WITH_THREADSAFE_SYMBOLICS
+    // Take a reference, unless the last reference is being released by another thread, which will remove the entry
+    unsigned int c = n->count.load();
+    while(c!=0 && !n->count.compare_exchange_weak(c,c+1)){}
+    if(c!=0){
+      hash_consing_hits_++;
+      SX ret = SX::create(n);
+      n->count--;
+      return ret;
+    }
+#else // WITH_THREADSAFE_SYMBOLICS
+    hash_consing_hits_++;
+    return SX::create(n);
+#endif // WITH_THREADSAFE_SYMBOLICS
+  }
+  
+  // Create the expression and add it to the table, replacing an entry of a node being deleted
+  SX ret = SX::create(binary ? static_cast<SXNode*>(new BinarySX(op,dep0,dep1)) : static_cast<SXNode*>(new UnarySX(op,dep0)));
+  SXNode*& entry = hash_consed_[HashConsKey(op,make_pair(dep0.get(),n1))];
+  if(entry==0) hash_consed_size_++;
+  entry = ret.get();
+  return ret;
+}
+
+void SX::removeHashConsed(SXNode* node){
+#ifdef WITH_THREADSAFE_SYMBOLICS
+  std::lock_guard<std::mutex> lock(hash_consing_mutex_);
+#endif // WITH_THREADSAFE_SYMBOLICS
+  const SXNode* n1 = node->ndep()==2 ? node->dep(1).get() : 0;
+  map<HashConsKey,SXNode*>::iterator it = hash_consed_.find(HashConsKey(node->getOp(),make_pair(node->dep(0).get(),n1)));
+  
+  // The entry may refer to another node with the same key, created after this one
+  if(it!=hash_consed_.end() && it->second==node){
+    hash_consed_.erase(it);
+    hash_consed_size_--;
+  }
+}
+
 } // namespace CasADi
 
 using namespace CasADi;
@@ -36,6 +36,9 @@
 #include <limits>
 #include <cmath>
 #include <vector>
+#ifdef WITH_THREADSAFE_SYMBOLICS
+#include <atomic>
+#endif // WITH_THREADSAFE_SYMBOLICS
 
 namespace CasADi{
 
@@ -276,6 +279,38 @@ class SX : public GenericExpression<SX>{
 
     /** \brief Get the maximum number of calls to the printing function when printing an expression */
     static long getMaxNumCallsInPrint();
+
+    /** \brief Enable or disable hash-consing of unary and binary expressions
+     * When enabled, creating an expression with the same operation and the same dependencies
+     * (the same nodes, not just equal expressions) as an existing one returns the existing node.
+     * The table does not keep the expressions alive, an entry is removed when its expression is destroyed.
+     */
+    static void setHashConsing(bool flag);
+
+    /** \brief Check if hash-consing is enabled */
+    static bool getHashConsing();
+
+    /** \brief Empty the hash-consing table and reset the counters, the expressions themselves are not affected */
+    static void clearHashConsing();
+
+    /** \brief Number of unique expressions in the hash-consing table */
+    static int getHashConsingSize();
+
+    /** \brief Number of expressions that were not allocated since an identical expression already existed */
+    static long getHashConsingHits();
+    
+    /** \brief Bytes allocated for the nodes by the node pool, zero if CasADi is compiled without WITH_SX_POOL
+     * The memory of deleted nodes is reused for new nodes but is never returned to the operating system,
+     * so this number does not decrease.
+     */
+    static long getPoolMemory();
+
+#ifndef SWIG
+    /** \brief Get a unary or binary expression from the hash-consing table, creating and adding it if not found (used by UnarySX and BinarySX)
+     * The lookup and the insertion are done under the same lock. For unary operations, dep1 is ignored.
+     */
+    static SX hashConsed(int op, const SX& dep0, const SX& dep1);
+#endif // SWIG
     
     /** \brief Assign the node to something, without invoking the deletion of the node, if the count reaches 0 */
     SXNode* assignNoDelete(const SX& scalar);
@@ -284,6 +319,19 @@ class SX : public GenericExpression<SX>{
   private:
     // Maximum number of calls
     static long max_num_calls_in_print_;
+
+    // Is hash-consing enabled
+#ifdef WITH_THREADSAFE_SYMBOLICS
+    static std::atomic<bool> hash_consing_;
+#else // WITH_THREADSAFE_SYMBOLICS
+    static bool hash_consing_;
+#endif // WITH_THREADSAFE_SYMBOLICS
+    
+    /// Delete a node which is no longer referenced, and its no longer referenced dependencies, without recursion
+    static void deleteNode(SXNode* node);
+    
+    /// Remove a node that is being deleted from the hash-consing table
+    static void removeHashConsed(SXNode* node);
     
     // Pointer to node (SX is only a reference class)
     SXNode* node;
@@ -330,6 +378,21 @@ class casadi_limits<SX>{
     static const SX minus_inf;
 };
 
+/** \brief Enables hash-consing of SX expressions for the lifetime of the object
+ * The previous setting is restored and, if hash-consing was previously disabled, the table is cleared on destruction.
+ * Expressions created in the scope remain valid after the scope has ended.
+*/
+class SXHashConsingScope{
+  public:
+    SXHashConsingScope() : was_enabled_(SX::getHashConsing()){ SX::setHashConsing(true);}
+    ~SXHashConsingScope(){
+      SX::setHashConsing(was_enabled_);
+      if(!was_enabled_) SX::clearHashConsing();
+    }
+  private:
+    bool was_enabled_;
+};
+
 #endif // SWIG
 
   typedef std::vector<SX> SXVector;
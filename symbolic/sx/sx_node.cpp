@@ -38,6 +38,88 @@ SXNode::~SXNode(){
   assert(count==0);
 }
 
+#ifdef WITH_SX_POOL
+namespace{
+  // Node sizes are rounded up to a multiple of the granularity, larger nodes are not pooled
+  const size_t pool_granularity = 8;
+  const int pool_num_classes = 16;
+  
+  // Number of bytes allocated at a time for each size class
+  const size_t pool_chunk_size = 1<<16;
+  
+  // A block in a free list
+  struct PoolBlock{ PoolBlock* next; };
+  
+  // Free lists for each size class (zero-initialized before any static constructor is called)
+#ifdef WITH_THREADSAFE_SYMBOLICS
+  // One set of lists per thread, a block freed by another thread than the one that allocated it moves to the lists of that thread
+  thread_local PoolBlock* pool_free_[pool_num_classes];
+#else // WITH_THREADSAFE_SYMBOLICS
+  PoolBlock* pool_free_[pool_num_classes];
+#endif // WITH_THREADSAFE_SYMBOLICS
+  
+  // Number of chunks allocated, by all threads
+#ifdef WITH_THREADSAFE_SYMBOLICS
+  std::atomic<long> pool_num_chunks_(0);
+#else // WITH_THREADSAFE_SYMBOLICS
+  long pool_num_chunks_ = 0;
+#endif // WITH_THREADSAFE_SYMBOLICS
+  
+  // Add a chunk of blocks to a free list, the chunks are reused but never returned to the system
+  void poolRefill(int c){
+    size_t block_size = (c+1)*pool_granularity;
+    char* chunk = static_cast<char*>(::operator new(pool_chunk_size));
+    pool_num_chunks_++;
+    size_t nblocks = pool_chunk_size/block_size;
+    for(size_t i=0; i<nblocks; ++i){
+      PoolBlock* b = reinterpret_cast<PoolBlock*>(chunk + i*block_size);
+      b->next = pool_free_[c];
+      pool_free_[c] = b;
+    }
+  }
+} // namespace
+
+void* SXNode::operator new(size_t size){
+  int c = (size-1)/pool_granularity;
+  if(c>=pool_num_classes) return ::operator new(size);
+  if(pool_free_[c]==0) poolRefill(c);
+  PoolBlock* b = pool_free_[c];
+  pool_free_[c] = b->next;
+  return b;
+}
+
+void SXNode::operator delete(void* ptr, size_t size){
+  if(ptr==0) return;
+  int c = (size-1)/pool_granularity;
+  if(c>=pool_num_classes){
+    ::operator delete(ptr);
+    return;
+  }
+  PoolBlock* b = static_cast<PoolBlock*>(ptr);
+  b->next = pool_free_[c];
+  pool_free_[c] = b;
+}
+
+long SXNode::getPoolMemory(){
+  return pool_num_chunks_*long(pool_chunk_size);
+}
+
+#else // WITH_SX_POOL
+
+void* SXNode::operator new(size_t size){
+  return ::operator new(size);
+}
+
+void SXNode::operator delete(void* ptr, size_t size){
+  ::operator delete(ptr);
+}
+
+long SXNode::getPoolMemory(){
+  return 0;
+}
+
+#endif // WITH_SX_POOL
+
 double SXNode::getValue() const{
   return numeric_limits<double>::quiet_NaN();
 /*  std::cerr << "getValue() not defined for class " << typeid(*this).name() << std::endl;
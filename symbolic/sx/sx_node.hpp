@@ -30,6 +30,7 @@
 
 /** \brief  Scalar expression (which also works as a smart pointer class to this class) */
 #include "sx.hpp"
+#include "../casadi_types.hpp"
 
 namespace CasADi{
 
@@ -48,6 +49,15 @@ SXNode();
 /** \brief  destructor  */
 virtual ~SXNode();
 
+/** \brief  Allocate from the node pool (size-class free lists, unless compiled without WITH_SX_POOL) */
+static void* operator new(size_t size);
+
+/** \brief  Return to the node pool */
+static void operator delete(void* ptr, size_t size);
+
+/** \brief  Bytes allocated by the node pool, zero if compiled without WITH_SX_POOL */
+static long getPoolMemory();
+
 //@{
 /** \brief  check properties of a node */
 virtual bool isConstant() const; // check if constant
@@ -110,7 +120,7 @@ void mark();
 int temp;
 
 // Reference counter -- counts the number of parents of the node
-unsigned int count;
+refcount_t count;
 
 };
 
@@ -25,6 +25,8 @@
 #include "../casadi_math.hpp"
 #include "../matrix/matrix_tools.hpp"
 #include "../stl_vector_tools.hpp"
+#include <stack>
+#include <map>
 using namespace std;
 
 namespace CasADi{
@@ -138,12 +140,78 @@ void simplify(SXMatrix &ex){
     simplify(ex.at(el));
 }
 
-void compress(SXMatrix &ex, int level){
-
-  throw CasadiException("SXMatrix::compress: Not implemented");
-
-  if(level>0)
-    compress(ex,level-1);
+int compress(SXMatrix &ex, int level){
+  // Expression, without duplicates, corresponding to each node visited
+  map<const SXNode*,SX> replacement;
+  
+  // Number of duplicates found
+  int nremoved = 0;
+  
+  // Unique unary and binary expressions, keyed by the operation and the dependency nodes after replacement
+  typedef pair<int,pair<const SXNode*,const SXNode*> > ExprKey;
+  map<ExprKey,SX> unique;
+  
+  // Depth-first search, visiting the dependencies of a node before the node itself
+  stack<SX> s;
+  for(int el=0; el<ex.size(); ++el){
+    s.push(ex.at(el));
+    while(!s.empty()){
+      SX t = s.top();
+      
+      // Skip if already visited
+      if(replacement.find(t.get())!=replacement.end()){
+        s.pop();
+        continue;
+      }
+      
+      // Constants and symbolic primitives are already unique
+      if(!t.hasDep()){
+        replacement[t.get()] = t;
+        s.pop();
+        continue;
+      }
+      
+      // Visit the dependencies first
+      int ndep = t->ndep();
+      bool added_to_stack = false;
+      for(int c=0; c<ndep; ++c){
+        if(replacement.find(t->dep(c).get())==replacement.end()){
+          s.push(t->dep(c));
+          added_to_stack = true;
+        }
+      }
+      if(added_to_stack) continue;
+      s.pop();
+      
+      // Dependencies after replacement
+      const SX& r0 = replacement[t->dep(0).get()];
+      const SX& r1 = replacement[t->dep(ndep-1).get()];
+      int op = t.getOp();
+      ExprKey key(op,make_pair(r0.get(),ndep==2 ? r1.get() : 0));
+      
+      // Look for an identical expression, for commutative operations also with the arguments swapped
+      map<ExprKey,SX>::const_iterator it = unique.find(key);
+      if(it==unique.end() && ndep==2 && operation_checker<CommChecker>(op)){
+        it = unique.find(ExprKey(op,make_pair(r1.get(),r0.get())));
+      }
+      
+      if(it!=unique.end()){
+        // Duplicate found
+        replacement[t.get()] = it->second;
+        nremoved++;
+      } else if(r0.get()==t->dep(0).get() && r1.get()==t->dep(ndep-1).get()){
+        // Unique and no dependency replaced, keep node
+        unique[key] = replacement[t.get()] = t;
+      } else {
+        // Unique but with some dependency replaced, create a new node
+        unique[key] = replacement[t.get()] = ndep==2 ? SX::binary(op,r0,r1) : SX::unary(op,r0);
+      }
+    }
+    
+    // Replace the element
+    ex.at(el) = replacement[ex.at(el).get()];
+  }
+  return nremoved;
 }
 
 std::vector<SXMatrix> substitute(const std::vector<SXMatrix> &ex, const std::vector<SXMatrix> &v, const std::vector<SXMatrix> &vdef){
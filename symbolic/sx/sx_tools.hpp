@@ -163,8 +163,12 @@ SXMatrix gauss_quadrature(SXMatrix f, const SXMatrix &x, const SXMatrix &a, cons
 /** \brief  Simplify an expression */
 void simplify(SXMatrix &ex);
 
-/** \brief  Remove identical calculations */
-void compress(SXMatrix &ex, int level=5); 
+/** \brief  Remove identical calculations (common subexpression elimination)
+ * Unary and binary expressions with the same operation and the same dependencies (after elimination) are replaced by a single node.
+ * Commutative operations are also matched with their arguments swapped. A single pass suffices, the argument level is not used.
+ * Returns the number of nodes removed from the expression graph.
+ */
+int compress(SXMatrix &ex, int level=5); 
 
 /** \brief  Substitute variable v with expression vdef in an expression ex */
 SXMatrix substitute(const SXMatrix& ex, const SXMatrix& v, const SXMatrix& vdef);
@@ -33,6 +33,7 @@ namespace CasADi{
   \date 2012
 */
 class UnarySX : public SXNode{
+  friend class SX;
   private:
     
     /** \brief  Constructor is private, use "create" below */
@@ -50,6 +51,10 @@ class UnarySX : public SXNode{
 	return ret_val;
       } else {
 	// Expression containing free variables
+	if(SX::getHashConsing()){
+	  // Reuse an identical expression, if any
+	  return SX::hashConsed(op,dep,dep);
+	}
 	return SX::create(new UnarySX(op,dep));
       }
     }
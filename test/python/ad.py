@@ -177,6 +177,186 @@ class ADtests(casadiTestCase):
               sens = array(f.adjSens()).ravel()
               self.checkarray(sens,dot(J.T,seed),"AD")
 
+  def test_vectorized_sweeps(self):
+    self.message("multi-direction AD on SX in a single sweep")
+    n=array([1.2,2.3,7,1.4])
+    seeds = [array([1,0,0,0]),array([0,2,0,0]),array([1.2,4.8,7.9,4.6])]
+    for inputtype in ["sparse","dense"]:
+      for outputtype in ["sparse","dense"]:
+        for vectorized in [True,False]:
+          f=SXFunction(self.sxinputs["column"][inputtype],self.sxoutputs["column"][outputtype])
+          f.setOption("vectorized_sweeps",vectorized)
+          f.setOption("number_of_fwd_dir",len(seeds))
+          f.setOption("number_of_adj_dir",len(seeds))
+          f.init()
+          f.input().set(n)
+          J = self.jacobians[inputtype][outputtype](*n)
+          for d in range(len(seeds)):
+            f.fwdSeed(0,d).set(seeds[d])
+            f.adjSeed(0,d).set(seeds[d])
+          f.evaluate(len(seeds),len(seeds))
+          for d in range(len(seeds)):
+            fseed = array(f.fwdSeed(0,d)).ravel()
+            aseed = array(f.adjSeed(0,d)).ravel()
+            self.checkarray(array(f.fwdSens(0,d)).ravel(),dot(J,fseed),"fwd AD")
+            self.checkarray(array(f.adjSens(0,d)).ravel(),dot(J.T,aseed),"adj AD")
+
+  def test_checkpointing(self):
+    self.message("AD on SX with a memory limit for the tape")
+    x=ssym("x",2)
+    y=x
+    for i in range(1000):
+      y = sin(y)*0.5 + x
+    n=array([1.2,2.3])
+    res = []
+    for limit, vectorized in [(0,True),(0.01,True),(0.01,False)]:
+      f=SXFunction([x],[y])
+      f.setOption("tape_memory_limit",limit)
+      f.setOption("vectorized_sweeps",vectorized)
+      f.setOption("number_of_fwd_dir",2)
+      f.setOption("number_of_adj_dir",2)
+      f.init()
+      f.input().set(n)
+      for d in range(2):
+        f.fwdSeed(0,d).set([1-d,d])
+        f.adjSeed(0,d).set([d,1-d])
+      f.evaluate(2,2)
+      res.append([DMatrix(f.fwdSens(0,d)) for d in range(2)] + [DMatrix(f.adjSens(0,d)) for d in range(2)])
+    self.assertTrue(f.getStat("tape_segments")>1)
+    for r in zip(*res):
+      self.checkarray(r[0],r[1],"checkpointed AD")
+      self.checkarray(r[0],r[2],"checkpointed AD, vectorized_sweeps false")
+
+  def test_sparsity_block_width(self):
+    self.message("Jacobian sparsity with several words per nonzero")
+    n = 300
+    x = ssym("x",n)
+    f = SXMatrix([sin(x[i])*x[(7*i+3)%n] + x[(i+1)%n] for i in range(n)])
+    for mode in ["forward","reverse"]:
+      sp = []
+      for w in [1,2,8]:
+        F = SXFunction([x],[f])
+        F.setOption("ad_mode",mode)
+        F.setOption("sparsity_block_width",w)
+        F.init()
+        sp.append(DMatrix(F.jacSparsity(),1))
+      self.checkarray(sp[0],sp[1],"block width 2")
+      self.checkarray(sp[0],sp[2],"block width 8")
+      F = SXFunction([x],[f])
+      F.setOption("ad_mode",mode)
+      F.setOption("sparsity_block_width",2)
+      F.setOption("sparsity_parallelization","openmp")
+      F.init()
+      self.checkarray(sp[0],DMatrix(F.jacSparsity(),1),"parallel sweeps")
+
+  def test_sparsity_block_width_mx(self):
+    self.message("Jacobian sparsity of an MXFunction with several words per nonzero")
+    n = 300
+    x = msym("x",n)
+    y = msym("y",2)
+    xs = ssym("xs",2)
+    g = SXFunction([xs],[sin(xs)*xs[0]])
+    g.init()
+    e = sin(x)*x[0] + x*y[1]
+    f = vertcat([e[0:n/2] + e[n/2:n], mul(trans(x[0:10]),x[10:20]), g.call([vertcat([x[3],y[0]])])[0]])
+    for mode in ["forward","reverse"]:
+      sp = []
+      for w in [1,2,8]:
+        F = MXFunction([x,y],[f])
+        F.setOption("ad_mode",mode)
+        F.setOption("sparsity_block_width",w)
+        F.init()
+        sp.append([DMatrix(F.jacSparsity(i,0),1) for i in range(2)])
+      for i in range(2):
+        self.checkarray(sp[0][i],sp[1][i],"block width 2")
+        self.checkarray(sp[0][i],sp[2][i],"block width 8")
+
+  def test_bidirectional_jacobian(self):
+    self.message("Jacobian with a dense row and a dense column (bidirectional coloring)")
+    n = 50
+    x = ssym("x",n)
+    f = SXMatrix([sum([sin(x[i])*x[i] for i in range(n)])] + [x[i]*x[i+1] + x[n-1]**2*x[i] for i in range(n-1)])
+    x0 = [0.1*i+0.3 for i in range(n)]
+    J = []
+    for mode in ["forward","automatic"]:
+      F = SXFunction([x],[f])
+      F.setOption("ad_mode",mode)
+      F.init()
+      G = SXFunction([x],[F.jac()])
+      G.init()
+      G.input().set(x0)
+      G.evaluate()
+      J.append(DMatrix(G.output()))
+      if mode=="forward":
+        self.assertEqual(F.getStat("partition_adj_dirs"),0)
+      else:
+        # The dense row is recovered in adjoint mode, the rest in forward mode
+        self.assertTrue(F.getStat("partition_fwd_dirs")>0)
+        self.assertTrue(F.getStat("partition_adj_dirs")>0)
+        self.assertTrue(F.getStat("partition_fwd_dirs")+F.getStat("partition_adj_dirs")<n/2)
+      X = msym("X",n)
+      M = MXFunction([X],F.call([X]))
+      M.setOption("ad_mode",mode)
+      M.init()
+      G = M.jacobian()
+      G.init()
+      G.input().set(x0)
+      G.evaluate()
+      self.checkarray(J[-1],G.output(),"MX jacobian, " + mode)
+    self.checkarray(J[0],J[1],"bidirectional")
+
+  def test_sparsity_cache(self):
+    self.message("Persistent cache of Jacobian sparsity patterns and colorings")
+    import tempfile, shutil, os
+    cachedir = tempfile.mkdtemp()
+    n = 20
+    x = ssym("x",n)
+    f = SXMatrix([sin(x[i])*x[(i+3)%n] + x[0]**2 for i in range(n)])
+    x0 = [0.1*i+0.3 for i in range(n)]
+    J = []
+    for run, cache in enumerate(["",cachedir,cachedir]):
+      F = SXFunction([x],[f])
+      F.setOption("sparsity_cache",cache)
+      F.init()
+      sp = F.jacSparsity()
+      G = SXFunction([x],[F.jac()])
+      G.init()
+      G.input().set(x0)
+      G.evaluate()
+      J.append(DMatrix(G.output()))
+      self.assertEqual(sp.size(),J[-1].size())
+      # Nothing is cached the first time the directory is used
+      if run<2:
+        self.assertEqual(F.getStat("sparsity_cache_hits"),0)
+      else:
+        self.assertTrue(F.getStat("sparsity_cache_hits")>0)
+      X = msym("X",n)
+      M = MXFunction([X],F.call([X]))
+      M.setOption("sparsity_cache",cache)
+      M.init()
+      G = M.jacobian()
+      G.init()
+      G.input().set(x0)
+      G.evaluate()
+      self.checkarray(J[-1],G.output(),"MX jacobian")
+      if run==0:
+        self.assertEqual(M.getStat("sparsity_cache_hits"),0)
+      elif run==2:
+        self.assertTrue(M.getStat("sparsity_cache_hits")>0)
+    self.assertTrue(len(os.listdir(cachedir))>0)
+    
+    # A corrupt entry is a miss, and is replaced
+    for name in os.listdir(cachedir):
+      open(os.path.join(cachedir,name),"wb").write("garbage")
+    F = SXFunction([x],[f])
+    F.setOption("sparsity_cache",cachedir)
+    F.init()
+    self.assertEqual(F.jacSparsity().size(),J[0].size())
+    self.assertEqual(F.getStat("sparsity_cache_hits"),0)
+    self.checkarray(J[0],J[1],"cache miss")
+    self.checkarray(J[0],J[2],"cache hit")
+    shutil.rmtree(cachedir)
+
   def test_fwdMX(self):
     n=array([1.2,2.3,7,1.4])
     for inputshape in ["column","row","matrix"]:
@@ -111,6 +111,208 @@ class FXtests(casadiTestCase):
       self.checkarray(array([0,cos(n2[1])]),p.adjSens(2),"adjSens")
       self.checkarray(1,p.adjSens(3),"adjSens")
 
+  def test_SXFunction_parallelization(self):
+    self.message("SXFunction parallelization")
+    x = ssym("x",3)
+    y = ssym("y")
+    
+    f = SXFunction([x,y],[sin(x) + y, x[0]*x[1]*y + x[2]])
+    
+    for mode in ["openmp","serial"]:
+      f.setOption("parallelization",mode)
+      f.init()
+      
+      n1 = DMatrix([4,5,6])
+      N1 = 3
+      
+      f.input(0).set(n1)
+      f.input(1).set(N1)
+      f.fwdSeed(0).set([1,0,0])
+      f.fwdSeed(1).set(0)
+      f.adjSeed(0).setAll(0)
+      f.adjSeed(1).set(1)
+      
+      f.evaluate(1,1)
+      
+      self.checkarray(sin(n1)+N1,f.output(0),"output")
+      self.checkarray(n1[0]*n1[1]*N1+n1[2],f.output(1),"output")
+      self.checkarray(array([cos(n1[0]),0,0]),f.fwdSens(0),"fwdSens")
+      self.checkarray(n1[1]*N1,f.fwdSens(1),"fwdSens")
+      self.checkarray(array([n1[1]*N1,n1[0]*N1,1]),f.adjSens(0),"adjSens")
+      self.checkarray(n1[0]*n1[1],f.adjSens(1),"adjSens")
+      
+      # The level-scheduled evaluation is used also without OpenMP, by a single thread
+      if mode=="openmp":
+        self.assertTrue(f.getStat("num_levels")>1)
+        self.assertTrue(f.getStat("num_levels")<f.getAlgorithmSize())
+        self.assertTrue(f.getStat("num_threads")>=1)
+
+  def test_SXFunction_jit_compile(self):
+    self.message("SXFunction jit_compile")
+    import tempfile, shutil, os
+    x = ssym("x",3)
+    y = ssym("y")
+    
+    f = SXFunction([x,y],[sin(x)*y, x[0]*x[1]+y**2])
+    f.init()
+    
+    cache_dir = tempfile.mkdtemp()
+    try:
+      for cache_hit in [False,True]:
+        g = SXFunction([x,y],[sin(x)*y, x[0]*x[1]+y**2])
+        g.setOption("jit_compile",True)
+        g.setOption("jit_cache_dir",cache_dir)
+        try:
+          g.init()
+        except Exception as e:
+          if "WITH_DL" in str(e): return # CasADi compiled without dynamic loading
+          raise
+        self.assertEqual(bool(g.getStat("jit_cache_hit")),cache_hit)
+        
+        for h in [f,g]:
+          h.input(0).set([4,5,6])
+          h.input(1).set(3)
+          h.evaluate()
+        self.checkarray(f.output(0),g.output(0),"output")
+        self.checkarray(f.output(1),g.output(1),"output")
+      
+      # A cache directory that others can write to is rejected
+      os.chmod(cache_dir,0777)
+      g = SXFunction([x,y],[sin(x)*y, x[0]*x[1]+y**2])
+      g.setOption("jit_compile",True)
+      g.setOption("jit_cache_dir",cache_dir)
+      self.assertRaises(Exception,lambda : g.init())
+    finally:
+      shutil.rmtree(cache_dir)
+
+  def test_SXFunction_codegen_derivatives(self):
+    self.message("SXFunction code generation of derivatives")
+    import tempfile, shutil, os, ctypes
+    x = ssym("x",3)
+    y = ssym("y")
+    
+    f = SXFunction([x,y],[sin(x)*y, x[0]*x[1]+y**2])
+    f.init()
+    
+    # C arrays of doubles and an array of pointers to them
+    P = ctypes.POINTER(ctypes.c_double)
+    def carrays(vals):
+      arrs = [(ctypes.c_double*max(len(v),1))(*v) for v in vals]
+      return arrs, (P*len(arrs))(*[ctypes.cast(a,P) for a in arrs])
+    
+    tmp_dir = tempfile.mkdtemp()
+    try:
+      src_name = os.path.join(tmp_dir,"f.c")
+      bin_name = os.path.join(tmp_dir,"f.so")
+      f.generateCode(src_name)
+      if os.system("gcc -fPIC -shared %s -o %s -lm" % (src_name,bin_name))!=0: return # no C compiler
+      lib = ctypes.CDLL(bin_name)
+      
+      x0 = [[4,5,6],[3]]
+      xa, xp = carrays(x0)
+      ra, rp = carrays([[0]*3,[0]])
+      for i in range(2):
+        f.input(i).set(x0[i])
+      
+      # Forward sensitivities
+      seed = [[1,0.5,0],[2]]
+      seeda, seedp = carrays(seed)
+      sensa, sensp = carrays([[0]*3,[0]])
+      self.assertEqual(lib.evaluateFwd(xp,rp,seedp,sensp),0)
+      for i in range(2):
+        f.fwdSeed(i).set(seed[i])
+      f.evaluate(1,0)
+      for i in range(2):
+        self.checkarray(f.output(i),DMatrix(list(ra[i])[:f.output(i).size()]),"output")
+        self.checkarray(f.fwdSens(i),DMatrix(list(sensa[i])[:f.output(i).size()]),"evaluateFwd")
+      
+      # Adjoint sensitivities
+      seed = [[1,2,3],[0.5]]
+      seeda, seedp = carrays(seed)
+      sensa, sensp = carrays([[0]*3,[0]])
+      self.assertEqual(lib.evaluateAdj(xp,rp,seedp,sensp),0)
+      for i in range(2):
+        f.adjSeed(i).set(seed[i])
+      f.evaluate(0,1)
+      for i in range(2):
+        self.checkarray(f.adjSens(i),DMatrix(list(sensa[i])[:f.input(i).size()]),"evaluateAdj")
+      
+      # Jacobian blocks
+      for iind in range(2):
+        for oind in range(2):
+          nrow = ctypes.c_int()
+          ncol = ctypes.c_int()
+          rowind = ctypes.POINTER(ctypes.c_int)()
+          col = ctypes.POINTER(ctypes.c_int)()
+          self.assertEqual(lib.getJacSparsity(iind,oind,ctypes.byref(nrow),ctypes.byref(ncol),ctypes.byref(rowind),ctypes.byref(col)),0)
+          nnz = rowind[nrow.value]
+          J = (ctypes.c_double*max(nnz,1))()
+          self.assertEqual(lib.jacobian(iind,oind,xp,J),0)
+          J_c = zeros((nrow.value,ncol.value))
+          for i in range(nrow.value):
+            for el in range(rowind[i],rowind[i+1]):
+              J_c[i,col[el]] = J[el]
+          
+          jacf = f.jacobian(iind,oind)
+          jacf.init()
+          for i in range(2):
+            jacf.input(i).set(x0[i])
+          jacf.evaluate()
+          self.checkarray(jacf.output(),J_c,"jacobian")
+      
+      # A function without inputs has no Jacobian blocks
+      g = SXFunction([],[SXMatrix(3)])
+      g.init()
+      g.generateCode(src_name)
+      self.assertEqual(os.system("gcc -fPIC -shared %s -o %s -lm" % (src_name,bin_name)),0)
+    finally:
+      shutil.rmtree(tmp_dir)
+
+  def test_SXFunction_superinstructions(self):
+    self.message("SXFunction superinstructions")
+    x = ssym("x",3)
+    y = ssym("y")
+    
+    f = SXFunction([x,y],[x[0]*x[1] + y, y - 2*x[2], -(x[0]*x[0])*(x[0]*x[0]), 3/(x[1]*y) - x[2]])
+    
+    n1 = DMatrix([4,5,6])
+    N1 = 3
+    for s in [False,True]:
+      f.setOption("superinstructions",s)
+      f.init()
+      f.input(0).set(n1)
+      f.input(1).set(N1)
+      f.evaluate()
+      
+      self.checkarray(n1[0]*n1[1]+N1,f.output(0),"output")
+      self.checkarray(N1-2*n1[2],f.output(1),"output")
+      self.checkarray(-n1[0]**4,f.output(2),"output")
+      self.checkarray(3/(n1[1]*N1)-n1[2],f.output(3),"output")
+    self.assertTrue(f.getStat("num_superinstructions")<f.getStat("num_instructions"))
+
+  def test_evaluate_batch(self):
+    self.message("SXFunction evaluateBatch")
+    x = ssym("x",2)
+    y = ssym("y")
+    f = SXFunction([x,y],[sin(x)*y + 3, x[0]/(x[1]+y)])
+    f.init()
+    npoints = 5
+    X = [[0.1*p+k for p in range(npoints)] for k in range(2)]
+    Y = [1.5-0.2*p for p in range(npoints)]
+    
+    # Nonzero k of point p is located at index k*npoints + p
+    arg = DVectorVector([X[0]+X[1],Y])
+    res = DVectorVector()
+    f.evaluateBatch(arg,res,npoints)
+    self.assertEqual(len(res),2)
+    
+    for p in range(npoints):
+      f.input(0).set([X[0][p],X[1][p]])
+      f.input(1).set(Y[p])
+      f.evaluate()
+      self.checkarray(DMatrix([res[0][p],res[0][npoints+p]]),f.output(0),"batch output 0")
+      self.checkarray(DMatrix(res[1][p]),f.output(1),"batch output 1")
+
   def test_MXFunctionSeed(self):
     self.message("MXFunctionSeed")
     x1 = MX("x",2)
@@ -315,6 +517,174 @@ class FXtests(casadiTestCase):
     
     self.checkfx(f,F,sens_der=False)
 
+  def test_save_load(self):
+    self.message("Binary save and load of SXFunction and MXFunction")
+    import tempfile, os
+    fd, fname = tempfile.mkstemp()
+    os.close(fd)
+    x = ssym("x",3,1)
+    y = ssym("y",2,1)
+    f = SXFunction([x,y],[sin(x)*y[0]+2.5,y**2])
+    f.init()
+    f.save(fname)
+    fsize = os.path.getsize(fname)
+    for symbolic in [False,True]:
+      g = SXFunction.load(fname,symbolic)
+      for F in [f,g]:
+        F.input(0).set([0.1,0.7,1.3])
+        F.input(1).set([7.1,2.9])
+      self.checkfx(f,g,sens_der=False)
+    # The expression graph is recreated with the names of the inputs
+    self.assertEqual(str(g.inputExpr(0)),str(x))
+    self.assertEqual(str(g.inputExpr(1)),str(y))
+    
+    X = msym("x",3,1)
+    Y = msym("y",2,1)
+    Z = f.call([X,Y])
+    F = MXFunction([X,Y],f.call([Z[0],Y])+[mul(X,trans(Y))+X[0]])
+    F.init()
+    F.save(fname)
+    # The function called twice is saved once
+    self.assertTrue(os.path.getsize(fname)<2*fsize)
+    G = MXFunction.load(fname)
+    for H in [F,G]:
+      H.input(0).set([0.1,0.7,1.3])
+      H.input(1).set([7.1,2.9])
+    self.checkfx(F,G,sens_der=False)
+    os.remove(fname)
+
+  def test_incremental(self):
+    self.message("Incremental evaluation, only the operations depending on changed inputs are re-executed")
+    x = ssym("x",3,1)
+    p = ssym("p",2,1)
+    X = msym("x",3,1)
+    P = msym("p",2,1)
+    for incremental in [False,True]:
+      f = SXFunction([x,p],[sin(x)*p[0]+p[1],p**2])
+      f.setOption("incremental",incremental)
+      f.init()
+      F = MXFunction([X,P],f.call([X,P])+[X*P[1]])
+      F.setOption("incremental",incremental)
+      F.init()
+      if incremental:
+        fcns_inc = [f,F]
+      else:
+        fcns = [f,F]
+    for fcn,fcn_inc in zip(fcns,fcns_inc):
+      xv = [0.1,0.7,1.3]
+      pv = [7.1,2.9]
+      for k in range(6):
+        if k%2==0: xv[k%3]+=0.5
+        if k%3==0: pv[k%2]-=0.3
+        for h in [fcn,fcn_inc]:
+          h.input(0).set(xv)
+          h.input(1).set(pv)
+          h.evaluate()
+        for i in range(fcn.getNumOutputs()):
+          self.checkarray(fcn.output(i),fcn_inc.output(i),"incremental")
+
+  def test_evaluate_outputs(self):
+    self.message("Evaluation of a subset of the outputs")
+    x = ssym("x",3,1)
+    # The slices are evaluated with the superinstruction bytecode too
+    f = SXFunction([x],[sin(x),x[0]*x[1],x**2])
+    f.setOption("superinstructions",True)
+    f.init()
+    X = msym("x",3,1)
+    F = MXFunction([X],f.call([X])+[2*X])
+    F.init()
+    f_plain = SXFunction([x],[sin(x),x[0]*x[1],x**2])
+    f_plain.init()
+    # Level scheduled evaluation cannot be restricted to a slice, the function is evaluated completely
+    f_par = SXFunction([x],[sin(x),x[0]*x[1],x**2])
+    f_par.setOption("parallelization","openmp")
+    f_par.init()
+    for fcn in [f,f_plain,F,f_par]:
+      fcn.input().set([0.1,0.7,1.3])
+      fcn.evaluate()
+      ref = [DMatrix(fcn.output(i)) for i in range(fcn.getNumOutputs())]
+      for i in range(fcn.getNumOutputs()):
+        for j in range(fcn.getNumOutputs()):
+          fcn.output(j).set(-1)
+        fcn.evaluateOutput(i)
+        self.checkarray(fcn.output(i),ref[i],"requested output")
+        if fcn is f_par: continue
+        for j in range(fcn.getNumOutputs()):
+          if j!=i and fcn.output(j).size()>0:
+            self.assertEqual(fcn.output(j)[0],-1)
+
+  def test_scheduling(self):
+    self.message("Reordering of the algorithm and allocation of the work vector")
+    x = ssym("x",3,1)
+    y = ssym("y")
+    e = sin(x[0]*x[1])+y*cos(x[2])
+    for i in range(10):
+      e = sin(e*x[i%3]) + y
+    for scheduling in ["none","locality"]:
+      for work_allocation in ["stack","linear_scan"]:
+        f = SXFunction([x,y],[e,x[1]**2,3])
+        f.init()
+        g = SXFunction([x,y],[e,x[1]**2,3])
+        g.setOption("scheduling",scheduling)
+        g.setOption("work_allocation",work_allocation)
+        g.init()
+        for fcn in [f,g]:
+          fcn.input(0).set([0.1,0.7,1.3])
+          fcn.input(1).set(0.4)
+          fcn.fwdSeed(0).set([1,0.5,0.2])
+          fcn.adjSeed(0).set(1)
+          fcn.evaluate(1,1)
+        for i in range(3):
+          self.checkarray(g.output(i),f.output(i),"output")
+          self.checkarray(g.fwdSens(i),f.fwdSens(i),"forward sensitivities")
+        self.checkarray(g.adjSens(0),f.adjSens(0),"adjoint sensitivities")
+
+  def test_work_sharing(self):
+    self.message("Sharing of the work vector between MX nodes with equal sparsity")
+    x = msym("x",3,3)
+    y = msym("y",3,3)
+    e = x
+    for i in range(5):
+      e = sin(e)*y + cos(mul(e,x))
+    f = MXFunction([x,y],[e])
+    f.setOption("live_variables",False)
+    f.init()
+    g = MXFunction([x,y],[e])
+    g.init()
+    self.assertTrue(g.getStats()["work_buffers"]<f.getStats()["work_buffers"])
+    self.assertEqual(g.getStats()["work_nnz_unshared"],f.getStats()["work_nnz"])
+    for fcn in [f,g]:
+      fcn.input(0).set(range(9))
+      fcn.input(1).set(0.3)
+      fcn.evaluate()
+    self.checkarray(g.output(),f.output(),"output")
+
+  def test_optimize_mappings(self):
+    self.message("Elimination of identity mappings in MXFunction")
+    x = ssym("x",2)
+    u = ssym("u")
+    f = SXFunction([x,u],[sin(x)*u])
+    f.init()
+    V = msym("V",5)
+    g = MXFunction([V],[f.call([V[0:2],V[2:3]])[0] - V[3:5]])
+    g.init()
+    J = g.jac()
+    fcns = []
+    for opt in [False,True]:
+      fcn = MXFunction([V],[J])
+      fcn.setOption("optimize_mappings",opt)
+      fcn.init()
+      fcn.input().set(range(5))
+      fcn.fwdSeed().set([1,0.5,-2,3,0.25])
+      fcn.adjSeed().set(range(fcn.output().size()))
+      fcn.evaluate(1,1)
+      fcns.append(fcn)
+    self.assertTrue(fcns[1].getStats()["mapping_nodes"]<fcns[1].getStats()["mapping_nodes_unoptimized"])
+    self.assertTrue(fcns[1].getAlgorithmSize()<fcns[0].getAlgorithmSize())
+    self.checkarray(fcns[1].output(),fcns[0].output(),"output")
+    self.checkarray(fcns[1].fwdSens(),fcns[0].fwdSens(),"fwdSens")
+    self.checkarray(fcns[1].adjSens(),fcns[0].adjSens(),"adjSens")
+
       
 if __name__ == '__main__':
     unittest.main()
@@ -1941,6 +1941,119 @@ class MXtests(casadiTestCase):
   def test_ticket(self):
     J = [] + msym("x")
     J = msym("x") + []
+
+  def test_multidirectional(self):
+    self.message("Multiplication and solve with several directions at once")
+    numpy.random.seed(1)
+    for spx, spy in [(sp_dense(4,3),sp_dense(3,5)),(sp_band(4,1),sp_tril(4))]:
+      x = msym("x",spx)
+      y = msym("y",spy)
+      for e in [mul(x,y)] + ([solve(x+4*MX.eye(4),y)] if spx.size1()==spx.size2() else []):
+        f = MXFunction([x,y],[e])
+        f.setOption("number_of_fwd_dir",3)
+        f.setOption("number_of_adj_dir",3)
+        f.init()
+        g = MXFunction([x,y],[e])
+        g.setOption("number_of_fwd_dir",1)
+        g.setOption("number_of_adj_dir",1)
+        g.init()
+        for fcn in [f,g]:
+          fcn.input(0).set(numpy.random.rand(spx.size()))
+          fcn.input(1).set(numpy.random.rand(spy.size()))
+        g.input(0).set(f.input(0))
+        g.input(1).set(f.input(1))
+        for d in range(3):
+          f.fwdSeed(0,d).set(numpy.random.rand(spx.size()))
+          f.fwdSeed(1,d).set(numpy.random.rand(spy.size()))
+          f.adjSeed(0,d).set(numpy.random.rand(f.output().size()))
+        f.evaluate(3,3)
+        for d in range(3):
+          g.fwdSeed(0).set(f.fwdSeed(0,d))
+          g.fwdSeed(1).set(f.fwdSeed(1,d))
+          g.adjSeed(0).set(f.adjSeed(0,d))
+          g.evaluate(1,1)
+          self.checkarray(f.fwdSens(0,d),g.fwdSens(0),"forward sensitivities")
+          self.checkarray(f.adjSens(0,d),g.adjSens(0),"adjoint sensitivities")
+          self.checkarray(f.adjSens(1,d),g.adjSens(1),"adjoint sensitivities")
+
+  def test_sparse_sparse(self):
+    self.message("Elementwise operations on matrices with different sparsity patterns")
+    numpy.random.seed(1)
+    for spx, spy in [(sp_band(5,1),sp_tril(5)),(sp_tril(5),sp_dense(5,5))]:
+      x = msym("x",spx)
+      y = msym("y",spy)
+      xs = ssym("x",spx)
+      ys = ssym("y",spy)
+      for op in [lambda a,b: a+b, lambda a,b: a*b, lambda a,b: a/(b+3), lambda a,b: fmax(a,b)]:
+        f = MXFunction([x,y],[op(x,y)])
+        g = SXFunction([xs,ys],[op(xs,ys)])
+        for fcn in [f,g]:
+          fcn.init()
+          fcn.input(0).set(numpy.random.rand(spx.size()))
+          fcn.input(1).set(numpy.random.rand(spy.size()))
+        g.input(0).set(f.input(0))
+        g.input(1).set(f.input(1))
+        self.checkarray(DMatrix(f.output().sparsity(),1),DMatrix(g.output().sparsity(),1),"sparsity")
+        f.fwdSeed(0).set(numpy.random.rand(spx.size()))
+        f.fwdSeed(1).set(numpy.random.rand(spy.size()))
+        f.adjSeed(0).set(numpy.random.rand(f.output().size()))
+        for i in range(2):
+          g.fwdSeed(i).set(f.fwdSeed(i))
+        g.adjSeed(0).set(f.adjSeed(0))
+        for fcn in [f,g]:
+          fcn.evaluate(1,1)
+        self.checkarray(f.output(),g.output(),"evaluation")
+        self.checkarray(f.fwdSens(),g.fwdSens(),"forward sensitivities")
+        self.checkarray(f.adjSens(0),g.adjSens(0),"adjoint sensitivities")
+        self.checkarray(f.adjSens(1),g.adjSens(1),"adjoint sensitivities")
+        for i in range(2):
+          self.checkarray(DMatrix(f.jacSparsity(i,0),1),DMatrix(g.jacSparsity(i,0),1),"jacsparsity")
+
+  def test_codegen(self):
+    self.message("MXFunction code generation")
+    import tempfile, shutil, os, ctypes
+    A = msym("A",3,3)
+    b = msym("b",3,2)
+    
+    # Embedded SXFunction with an unused output
+    s = ssym("s",3,2)
+    g = SXFunction([s],[sin(s),s**2])
+    g.init()
+    x = solve(A,g.call([b])[0])
+    f = MXFunction([A,b],[mul(A,x)+x,x,trans(b)])
+    f.init()
+    
+    A0 = [4,1,0,1,5,2,0,2,6]
+    b0 = [1,2,3,4,5,6]
+    f.input(0).set(A0)
+    f.input(1).set(b0)
+    f.evaluate()
+    
+    # C arrays of doubles and an array of pointers to them
+    P = ctypes.POINTER(ctypes.c_double)
+    def carrays(vals):
+      arrs = [(ctypes.c_double*max(len(v),1))(*v) for v in vals]
+      return arrs, (P*len(arrs))(*[ctypes.cast(a,P) for a in arrs])
+    
+    tmp_dir = tempfile.mkdtemp()
+    try:
+      src_name = os.path.join(tmp_dir,"f.c")
+      bin_name = os.path.join(tmp_dir,"f.so")
+      f.generateCode(src_name)
+      if os.system("gcc -fPIC -shared %s -o %s -lm" % (src_name,bin_name))!=0: return # no C compiler
+      lib = ctypes.CDLL(bin_name)
+      
+      xa, xp = carrays([A0,b0])
+      ra, rp = carrays([[0]*f.output(i).size() for i in range(f.getNumOutputs())])
+      self.assertEqual(lib.evaluate(xp,rp),0)
+      for i in range(f.getNumOutputs()):
+        self.checkarray(f.output(i),DMatrix(f.output(i).sparsity(),list(ra[i])[:f.output(i).size()]),"evaluate")
+      
+      # A singular matrix is reported by the return value
+      xa, xp = carrays([[0]*9,b0])
+      self.assertEqual(lib.evaluate(xp,rp),1)
+    finally:
+      shutil.rmtree(tmp_dir)
     
 if __name__ == '__main__':
     unittest.main()
@@ -391,6 +391,75 @@ class Sparsitytests(casadiTestCase):
     print A2, B2
     
     
+
+  def test_coloring(self):
+    self.message("Graph coloring with different orderings")
+    n = 60
+    numpy.random.seed(1)
+    a = CRSSparsity(n,n)
+    for i in range(n):
+      a.getNZ(i,i)
+      for j in numpy.random.randint(0,n,3):
+        a.getNZ(i,int(j))
+    at = a.T
+    h = a + at
+    acol = list(a.col())
+    hcol = list(h.col())
+    for ordering in range(4):
+      for recolor in range(3):
+        # Columns of the same color may not share a row
+        D = at.unidirectionalColoring(a,ordering,recolor)
+        self.assertEqual(D.size2(),n)
+        color = [0]*n
+        for d in range(D.size1()):
+          for j in list(D.col())[D.rowind(d):D.rowind(d+1)]:
+            color[j] = d
+        for i in range(n):
+          row = [color[j] for j in acol[a.rowind(i):a.rowind(i+1)]]
+          self.assertEqual(len(row),len(set(row)))
+        # Neighbors in the symmetric pattern may not share a color
+        D = h.starColoring(ordering,recolor)
+        for d in range(D.size1()):
+          for j in list(D.col())[D.rowind(d):D.rowind(d+1)]:
+            color[j] = d
+        for i in range(n):
+          for j in hcol[h.rowind(i):h.rowind(i+1)]:
+            self.assertTrue(i==j or color[i]!=color[j])
+    self.assertEqual(sorted(at.smallestLastOrdering(a)),range(n))
+    self.assertEqual(sorted(h.incidenceDegreeOrdering()),range(n))
+    
+    # Recoloring never uses more colors than the plain greedy coloring in the same ordering
+    for ordering in range(4):
+      ncolor = at.unidirectionalColoring(a,ordering,0).size1()
+      nstar = h.starColoring(ordering,0).size1()
+      for recolor in range(1,3):
+        self.assertTrue(at.unidirectionalColoring(a,ordering,recolor).size1()<=ncolor)
+        self.assertTrue(h.starColoring(ordering,recolor).size1()<=nstar)
+        
+  def test_coloring_fixed(self):
+    self.message("Graph coloring of fixed patterns")
+    n = 20
+    def band(b):
+      a = CRSSparsity(n,n)
+      for i in range(n):
+        for j in range(max(0,i-b),min(n,i+b+1)):
+          a.getNZ(i,j)
+      return a
+    arrow = CRSSparsity(n,n)
+    for i in range(n):
+      arrow.getNZ(i,i)
+      arrow.getNZ(0,i)
+      arrow.getNZ(i,0)
+    # Number of colors with the natural ordering and no recoloring, i.e. the plain greedy algorithm
+    for a, nuni, nstar in [(band(1),3,3),(band(2),5,5),(arrow,n,2)]:
+      at = a.T
+      self.assertEqual(at.unidirectionalColoring(a,0,0).size1(),nuni)
+      self.assertEqual(a.starColoring(0,0).size1(),nstar)
+      for ordering in range(4):
+        for recolor in range(3):
+          self.assertEqual(at.unidirectionalColoring(a,ordering,recolor).size1(),nuni)
+          self.assertEqual(at.unidirectionalColoring(a,ordering,recolor,True).size1(),nuni)
+          self.assertEqual(a.starColoring(ordering,recolor).size1(),nstar)
       
 if __name__ == '__main__':
     unittest.main()
@@ -994,6 +994,64 @@ class SXtests(casadiTestCase):
     self.checkarray(f.fwdSens(),3*(-x0)**2*dx,"if_else sens")
     self.checkarray(f.adjSens(),3*(-x0)**2*dx,"if_else sens")
 
+  def test_hash_consing(self):
+    self.message("common subexpressions")
+    x = ssym("x",2)
+    def build():
+      return sin(x[0])*x[1] + sin(x[0])*x[1] + x[1]*sin(x[0])
+    f = build()
+    n = countNodes(f)
+    self.assertEqual(compress(f),4)
+    self.assertEqual(countNodes(f),n-4)
+    self.assertEqual(compress(f),0)
+    SX.setHashConsing(True)
+    g = build()
+    self.assertTrue(SX.getHashConsingHits()>0)
+    
+    # The table does not keep expressions alive
+    size = SX.getHashConsingSize()
+    self.assertTrue(size>0)
+    h = sin(x[1])*cos(x[0])
+    self.assertEqual(SX.getHashConsingSize(),size+3)
+    h = 0
+    self.assertEqual(SX.getHashConsingSize(),size)
+    SX.setHashConsing(False)
+    SX.clearHashConsing()
+    self.assertEqual(countNodes(g),countNodes(f))
+    F = SXFunction([x],[build(),f,g])
+    F.init()
+    F.input().set([0.3,1.7])
+    F.evaluate()
+    self.checkarray(F.output(0),F.output(1),"compress")
+    self.checkarray(F.output(0),F.output(2),"hash-consing")
+
+  def test_deep_destruction(self):
+    self.message("destruction of a deep chain of unary operations")
+    x = SX("x")
+    def build():
+      f = x
+      for i in range(200000):
+        f = sin(f)
+      return f
+    f = build()
+    F = SXFunction([x],[f])
+    F.init()
+    F.input().set(0.5)
+    F.evaluate()
+    y = 0.5
+    for i in range(200000):
+      y = sin(y)
+    self.checkarray(F.output(),y,"chain")
+    
+    # The memory of the destroyed nodes is reused for the next chain
+    F = 0
+    f = 0
+    mem = SX.getPoolMemory()
+    f = build()
+    f = 0
+    if mem>0:
+      self.assertEqual(SX.getPoolMemory(),mem)
+
 if __name__ == '__main__':
     unittest.main()
 